@@ -35,6 +35,8 @@ option(BUILD_REMOTE_BITBANG "Build support for the Remote Bitbang driver" ON)
 # Espressif additions
 option(BUILD_ESP_REMOTE "Build support for the ESP remote protocol over TCP or USB" ON)
 option(BUILD_ESP_COMPRESSION "Build support for the ESP flasher image compression" ON)
+option(BUILD_XTENSA_SIM "Build the in-process Xtensa TAP simulator driver" ON)
+option(BUILD_RISCV_SIM "Build the in-process RISC-V Debug Module simulator driver" ON)
 option(USE_GCOV "Build support for the coverage" OFF)
 option(BUILD_SANITIZERS "Build support with the sanitizer flags" OFF)
 
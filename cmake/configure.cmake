@@ -195,7 +195,7 @@ if(MALLOC_LOGGING)
     set(_DEBUG_FREE_SPACE_ 1)
 endif()
 
-if(BUILD_DUMMY)
+if(BUILD_DUMMY OR BUILD_XTENSA_SIM OR BUILD_RISCV_SIM)
     set(BUILD_BITBANG ON CACHE BOOL "" FORCE)
 endif()
 
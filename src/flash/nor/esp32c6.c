@@ -119,5 +119,5 @@ const struct flash_driver esp32c6_flash = {
 	.erase_check = esp_algo_flash_blank_check,
 	.protect_check = esp_algo_flash_protect_check,
 	.info = esp32c6_get_info,
-	.free_driver_priv = default_flash_free_driver_priv,
+	.free_driver_priv = esp_algo_flash_free_driver_priv,
 };
@@ -75,6 +75,18 @@
 #define ESP_FLASH_VERIFY_TMO            30000	/* ms */
 #define ESP_FLASH_WR_DEFLATE_TMO        60000	/* ms */
 #define ESP_FLASH_MAPS_MAX              2
+/* number of chips whose flash mappings are remembered */
+#define ESP_FLASH_MAP_CACHE_SIZE        4
+/* esp_app_desc_t at the start of the app DROM segment */
+#define ESP_FLASH_APP_DESC_SIZE         256
+#define ESP_FLASH_APP_DESC_MAGIC        0xABCD5432
+/* min number of consecutive blank sectors which are worth a separate erase stub run */
+#define ESP_FLASH_ERASE_SKIP_MIN        2
+/* flash jobs are processed by blocks of this size, one block per timer callback.
+ * Every block is a separate stub run, so blocks are large to keep the stub upload
+ * overhead small, at the cost of clients waiting for up to one block. */
+#define ESP_FLASH_JOB_BLOCK_SIZE        (1024 * 1024)
+#define ESP_FLASH_JOB_EVENT_PERIOD      1000	/* ms */
 
 struct esp_flash_rw_args {
 	int (*xfer)(struct target *target, uint32_t block_id, uint32_t len, void *priv);
@@ -104,6 +116,67 @@ struct esp_flash_erase_check_args {
 	uint32_t num_sectors;
 };
 
+/* Flash mappings of the application found by the stub. They are the same for
+ * all banks and cores of a chip, so the stub runs once per chip. */
+struct esp_flash_map_cache {
+	/* first core of the chip, NULL for unused entry */
+	struct target *target;
+	uint32_t appimage_flash_base;
+	struct esp_stub_flash_map flash_map;
+	/* application description read through the DROM mapping, used to detect
+	 * that another app was flashed */
+	uint8_t app_desc[ESP_FLASH_APP_DESC_SIZE];
+	bool app_desc_valid;
+	/* mappings are known to be valid until the next reset */
+	bool checked;
+};
+
+static struct esp_flash_map_cache esp_flash_map_cache[ESP_FLASH_MAP_CACHE_SIZE];
+/* number of banks set up by esp_algo_flash_init(), the target event callback
+ * is registered while there are any */
+static unsigned int esp_flash_banks_num;
+
+static int esp_algo_flash_target_event(struct target *target, enum target_event event, void *priv);
+
+enum esp_flash_job_type {
+	ESP_FLASH_JOB_READ,
+	ESP_FLASH_JOB_VERIFY,
+	ESP_FLASH_JOB_HASH,
+};
+
+enum esp_flash_job_state {
+	ESP_FLASH_JOB_IDLE,
+	ESP_FLASH_JOB_RUNNING,
+	ESP_FLASH_JOB_DONE,
+	ESP_FLASH_JOB_FAILED,
+	ESP_FLASH_JOB_CANCELLED,
+};
+
+/* Long flash operation split into blocks which are processed from the main loop,
+ * so GDB and other clients are served between them. Only one job runs at a time. */
+struct esp_flash_job {
+	enum esp_flash_job_type type;
+	enum esp_flash_job_state state;
+	struct flash_bank *bank;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t done;
+	struct fileio *fileio;
+	uint8_t *buf;
+	struct tc_sha256_state_struct sha256;
+	uint8_t hash[TC_SHA256_DIGEST_SIZE];
+	/* offset of the first block which differs from the file */
+	uint32_t mismatch;
+	bool mismatch_found;
+	int64_t start_ms;
+	int64_t event_ms;
+};
+
+static struct esp_flash_job esp_flash_job;
+
+static const char *const esp_flash_job_type_names[] = { "read", "verify", "hash" };
+static const char *const esp_flash_job_state_names[] = { "idle", "running", "done", "failed", "cancelled" };
+
 struct esp_flash_bp_op_state {
 	struct working_area *target_buf;
 	struct esp_flash_bank *esp_info;
@@ -280,6 +353,9 @@ int esp_algo_flash_init(struct esp_flash_bank *esp_info, uint32_t sec_sz,
 	esp_info->stub_hw = stub_hw;
 	esp_info->check_preloaded_binary = check_preloaded_binary;
 
+	if (esp_flash_banks_num++ == 0)
+		target_register_event_callback(esp_algo_flash_target_event, NULL);
+
 	return ERROR_OK;
 }
 
@@ -293,7 +369,59 @@ int esp_algo_flash_protect_check(struct flash_bank *bank)
 	return ERROR_OK;
 }
 
-int esp_algo_flash_blank_check(struct flash_bank *bank)
+static struct target *esp_algo_flash_chip_target(struct target *target)
+{
+	if (target->smp) {
+		struct target_list *head;
+		foreach_smp_target(head, target->smp_targets)
+			return head->target;
+	}
+	return target;
+}
+
+static bool esp_algo_flash_is_esp_bank(struct flash_bank *bank, struct target *chip)
+{
+	return bank->driver->erase == esp_algo_flash_erase &&
+		esp_algo_flash_chip_target(bank->target) == chip;
+}
+
+/* Sets erase state of the sectors in all banks of the chip which map the same flash area as
+ * sectors [first, last] of the bank. IROM/DROM banks alias parts of the main flash bank. */
+static void esp_algo_flash_sectors_state_set(struct flash_bank *bank, unsigned int first,
+	unsigned int last, int state)
+{
+	struct esp_flash_bank *esp_info = bank->driver_priv;
+	struct target *chip = esp_algo_flash_chip_target(bank->target);
+	uint32_t start = esp_info->hw_flash_base + bank->sectors[first].offset;
+	uint32_t end = esp_info->hw_flash_base + bank->sectors[last].offset + bank->sectors[last].size;
+
+	for (struct flash_bank *b = flash_bank_list(); b; b = b->next) {
+		if (!esp_algo_flash_is_esp_bank(b, chip))
+			continue;
+		struct esp_flash_bank *info = b->driver_priv;
+		for (unsigned int i = 0; i < b->num_sectors; i++) {
+			uint32_t addr = info->hw_flash_base + b->sectors[i].offset;
+			if (addr < end && addr + b->sectors[i].size > start)
+				b->sectors[i].is_erased = state;
+		}
+	}
+}
+
+/* Forgets erase state of all sectors of the chip, e.g. when the app can write to flash. */
+static void esp_algo_flash_sectors_state_invalidate(struct target *target)
+{
+	struct target *chip = esp_algo_flash_chip_target(target);
+
+	for (struct flash_bank *b = flash_bank_list(); b; b = b->next) {
+		if (!esp_algo_flash_is_esp_bank(b, chip))
+			continue;
+		for (unsigned int i = 0; i < b->num_sectors; i++)
+			b->sectors[i].is_erased = -1;
+	}
+}
+
+/* Checks sectors [first, last] for being blank in one stub run */
+static int esp_algo_flash_blank_check_range(struct flash_bank *bank, unsigned int first, unsigned int last)
 {
 	struct esp_flash_bank *esp_info = bank->driver_priv;
 	struct esp_algorithm_run_data run;
@@ -310,9 +438,13 @@ int esp_algo_flash_blank_check(struct flash_bank *bank)
 	if (ret != ERROR_OK)
 		return ret;
 
+	/* stub stores the state of every sector at its index counted from the start of flash */
+	const uint32_t start_sec = esp_info->hw_flash_base / esp_info->sec_sz + first;
+	const uint32_t sec_num = last - first + 1;
+
 	run.stack_size = stack_size;
 	struct mem_param mp;
-	init_mem_param(&mp, 3 /*3rd usr arg*/, bank->num_sectors /*size in bytes*/, PARAM_IN);
+	init_mem_param(&mp, 3 /*3rd usr arg*/, start_sec + sec_num /*size in bytes*/, PARAM_IN);
 	run.mem_args.params = &mp;
 	run.mem_args.count = 1;
 
@@ -320,8 +452,8 @@ int esp_algo_flash_blank_check(struct flash_bank *bank)
 		&run,
 		4,
 		ESP_STUB_CMD_FLASH_ERASE_CHECK /*cmd*/,
-		esp_info->hw_flash_base / esp_info->sec_sz /*start*/,
-		bank->num_sectors /*sectors num*/,
+		start_sec /*start*/,
+		sec_num /*sectors num*/,
 		0 /*address to store sectors' state*/);
 	image_close(&run.image.image);
 	if (ret != ERROR_OK) {
@@ -333,14 +465,107 @@ int esp_algo_flash_blank_check(struct flash_bank *bank)
 		LOG_ERROR("Failed to check erase flash (%" PRId32 ")!", run.ret_code);
 		ret = ERROR_FAIL;
 	} else {
-		for (unsigned int i = 0; i < bank->num_sectors; i++)
-			bank->sectors[i].is_erased = mp.value[i];
+		for (unsigned int i = 0; i < sec_num; i++)
+			esp_algo_flash_sectors_state_set(bank, first + i, first + i, mp.value[start_sec + i]);
 	}
 	destroy_mem_param(&mp);
 	return ret;
 }
 
-static int esp_algo_flash_get_mappings(struct flash_bank *bank,
+int esp_algo_flash_blank_check(struct flash_bank *bank)
+{
+	if (bank->target->state != TARGET_HALTED) {
+		LOG_ERROR("Target not halted!");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	if (bank->num_sectors == 0)
+		return ERROR_OK;
+	return esp_algo_flash_blank_check_range(bank, 0, bank->num_sectors - 1);
+}
+
+static struct esp_flash_map_cache *esp_algo_flash_map_cache_find(struct target *target)
+{
+	struct target *chip = esp_algo_flash_chip_target(target);
+
+	for (unsigned int i = 0; i < ESP_FLASH_MAP_CACHE_SIZE; i++) {
+		if (esp_flash_map_cache[i].target == chip)
+			return &esp_flash_map_cache[i];
+	}
+	return NULL;
+}
+
+static void esp_algo_flash_map_cache_invalidate(struct target *target)
+{
+	struct esp_flash_map_cache *cache = esp_algo_flash_map_cache_find(target);
+
+	if (cache)
+		cache->target = NULL;
+}
+
+static int esp_algo_flash_target_event(struct target *target, enum target_event event, void *priv)
+{
+	if (event == TARGET_EVENT_RESET_ASSERT) {
+		struct esp_flash_map_cache *cache = esp_algo_flash_map_cache_find(target);
+		if (cache)
+			cache->checked = false;
+		esp_algo_flash_sectors_state_invalidate(target);
+	} else if (event == TARGET_EVENT_RESUMED && target->state == TARGET_RUNNING) {
+		/* the app may write to flash, but flasher stub runs do not count */
+		esp_algo_flash_sectors_state_invalidate(target);
+	}
+	return ERROR_OK;
+}
+
+void esp_algo_flash_free_driver_priv(struct flash_bank *bank)
+{
+	/* the cache refers to the target, which may go away with the bank */
+	esp_algo_flash_map_cache_invalidate(bank->target);
+	if (esp_flash_banks_num && --esp_flash_banks_num == 0)
+		target_unregister_event_callback(esp_algo_flash_target_event, NULL);
+	default_flash_free_driver_priv(bank);
+}
+
+/* Read the application description through the DROM mapping, this does not
+ * need a stub run. The mapping is not set up e.g. right after "reset halt",
+ * then the description is not valid. */
+static void esp_algo_flash_read_app_desc(struct target *target, struct esp_flash_map_cache *cache,
+	uint8_t *app_desc, bool *valid)
+{
+	struct esp_stub_flash_map *flash_map = &cache->flash_map;
+
+	*valid = false;
+	if (flash_map->map.maps_num == 0)
+		return;
+	if (target_read_buffer(target, flash_map->map.maps[0].load_addr, ESP_FLASH_APP_DESC_SIZE,
+			app_desc) != ERROR_OK)
+		return;
+	*valid = target_buffer_get_u32(target, app_desc) == ESP_FLASH_APP_DESC_MAGIC;
+}
+
+/* The app can only change with a flash write or erase, which drop the cache,
+ * or with a reset, e.g. when another tool flashed the chip. So the mappings
+ * are checked once per chip after reset and trusted by all other probes.
+ * @returns true if the cached mappings are still valid for the app in flash */
+static bool esp_algo_flash_map_cache_check(struct target *target, struct esp_flash_map_cache *cache,
+	uint32_t appimage_flash_base)
+{
+	if (cache->appimage_flash_base != appimage_flash_base)
+		return false;
+	if (cache->checked)
+		return true;
+	if (!cache->app_desc_valid)
+		return false;
+
+	uint8_t app_desc[ESP_FLASH_APP_DESC_SIZE];
+	bool valid;
+	esp_algo_flash_read_app_desc(target, cache, app_desc, &valid);
+	if (!valid || memcmp(app_desc, cache->app_desc, sizeof(app_desc)) != 0)
+		return false;
+	cache->checked = true;
+	return true;
+}
+
+static int esp_algo_flash_get_mappings_do(struct flash_bank *bank,
 	struct esp_flash_bank *esp_info,
 	struct esp_stub_flash_map *flash_map,
 	uint32_t appimage_flash_base)
@@ -428,7 +653,47 @@ static int esp_algo_flash_get_mappings(struct flash_bank *bank,
 	return ret;
 }
 
-int esp_algo_flash_erase(struct flash_bank *bank, unsigned int first, unsigned int last)
+static int esp_algo_flash_get_mappings(struct flash_bank *bank,
+	struct esp_flash_bank *esp_info,
+	struct esp_stub_flash_map *flash_map,
+	uint32_t appimage_flash_base)
+{
+	struct target *target = bank->target;
+	struct esp_flash_map_cache *cache = esp_algo_flash_map_cache_find(target);
+
+	if (cache && esp_algo_flash_map_cache_check(target, cache, appimage_flash_base)) {
+		LOG_DEBUG("Using cached flash mappings for '%s'", bank->name);
+		*flash_map = cache->flash_map;
+		return ERROR_OK;
+	}
+
+	int ret = esp_algo_flash_get_mappings_do(bank, esp_info, flash_map, appimage_flash_base);
+	if (ret != ERROR_OK) {
+		/* e.g. no app flashed yet, the next probe has to ask the stub again */
+		if (cache)
+			cache->target = NULL;
+		return ret;
+	}
+
+	if (!cache) {
+		for (unsigned int i = 0; i < ESP_FLASH_MAP_CACHE_SIZE; i++) {
+			if (!esp_flash_map_cache[i].target) {
+				cache = &esp_flash_map_cache[i];
+				break;
+			}
+		}
+		if (!cache)
+			return ret;
+	}
+	cache->target = esp_algo_flash_chip_target(target);
+	cache->appimage_flash_base = appimage_flash_base;
+	cache->flash_map = *flash_map;
+	cache->checked = true;
+	esp_algo_flash_read_app_desc(target, cache, cache->app_desc, &cache->app_desc_valid);
+	return ret;
+}
+
+static int esp_algo_flash_erase_do(struct flash_bank *bank, unsigned int first, unsigned int last)
 {
 	struct esp_flash_bank *esp_info = bank->driver_priv;
 	struct esp_algorithm_run_data run;
@@ -442,6 +707,9 @@ int esp_algo_flash_erase(struct flash_bank *bank, unsigned int first, unsigned i
 	}
 	assert((first <= last) && (last < bank->num_sectors));
 
+	/* the app or partition table may change */
+	esp_algo_flash_map_cache_invalidate(bank->target);
+
 	struct duration bench;
 	duration_start(&bench);
 
@@ -476,6 +744,53 @@ int esp_algo_flash_erase(struct flash_bank *bank, unsigned int first, unsigned i
 	return ret;
 }
 
+int esp_algo_flash_erase(struct flash_bank *bank, unsigned int first, unsigned int last)
+{
+	unsigned int skipped = 0;
+
+	if (bank->target->state != TARGET_HALTED) {
+		LOG_ERROR("Target not halted");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	assert((first <= last) && (last < bank->num_sectors));
+
+	/* Blank check stops reading a sector at the first programmed byte, so it is much
+	 * cheaper than erasing the sectors which turn out to be blank. */
+	for (unsigned int i = first; i <= last; i++) {
+		if (bank->sectors[i].is_erased == -1) {
+			esp_algo_flash_blank_check_range(bank, first, last);
+			break;
+		}
+	}
+
+	unsigned int i = first;
+	while (i <= last) {
+		if (bank->sectors[i].is_erased == 1) {
+			skipped++;
+			i++;
+			continue;
+		}
+		unsigned int run_last = i;
+		for (unsigned int j = i + 1; j <= last; j++) {
+			if (bank->sectors[j].is_erased == 1)
+				continue;
+			if (j - run_last - 1 >= ESP_FLASH_ERASE_SKIP_MIN)
+				break;
+			run_last = j;
+		}
+		int ret = esp_algo_flash_erase_do(bank, i, run_last);
+		if (ret != ERROR_OK) {
+			esp_algo_flash_sectors_state_set(bank, i, run_last, -1);
+			return ret;
+		}
+		esp_algo_flash_sectors_state_set(bank, i, run_last, 1);
+		i = run_last + 1;
+	}
+	if (skipped)
+		LOG_INFO("Skipped erasing %u blank sectors", skipped);
+	return ERROR_OK;
+}
+
 static int esp_algo_flash_rw_do(struct target *target, void *priv)
 {
 	struct duration algo_time, tmo_time;
@@ -717,6 +1032,9 @@ int esp_algo_flash_write(struct flash_bank *bank, const uint8_t *buffer,
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
+	/* the app or partition table may change */
+	esp_algo_flash_map_cache_invalidate(bank->target);
+
 	target_addr_t old_addr = 0;
 	/* apptrace is not running on target, so not all fields are inited. */
 	/* Now we just set control struct addr to be able to communicate and detect that apptrace is
@@ -793,6 +1111,9 @@ int esp_algo_flash_write(struct flash_bank *bank, const uint8_t *buffer,
 	if (compressed_buff)
 		free(compressed_buff);
 	esp_algo_flash_apptrace_info_restore(bank->target, esp_info, old_addr);
+	if (count)
+		esp_algo_flash_sectors_state_set(bank, offset / esp_info->sec_sz,
+			(offset + count - 1) / esp_info->sec_sz, 0);
 	if (ret != ERROR_OK) {
 		LOG_ERROR("Failed to run flasher stub (%d)!", ret);
 		return ret;
@@ -1680,6 +2001,272 @@ static int esp_flash_verify_bank_hash(struct target *target,
 	return differ ? ERROR_FAIL : ERROR_OK;
 }
 
+static int esp_flash_job_step(void *priv);
+
+static void esp_flash_job_finish(struct esp_flash_job *job, enum esp_flash_job_state state)
+{
+	target_unregister_timer_callback(esp_flash_job_step, job);
+	if (job->fileio) {
+		fileio_close(job->fileio);
+		job->fileio = NULL;
+	}
+	free(job->buf);
+	job->buf = NULL;
+	if (state == ESP_FLASH_JOB_DONE && job->type == ESP_FLASH_JOB_HASH &&
+		tc_sha256_final(job->hash, &job->sha256) != TC_CRYPTO_SUCCESS) {
+		LOG_ERROR("tc_sha256_final failed!");
+		state = ESP_FLASH_JOB_FAILED;
+	}
+	job->state = state;
+	LOG_INFO("Flash %s job %s, %" PRIu32 " of %" PRIu32 " bytes in %" PRId64 " ms",
+		esp_flash_job_type_names[job->type],
+		esp_flash_job_state_names[job->state],
+		job->done,
+		job->size,
+		timeval_ms() - job->start_ms);
+	target_call_event_callbacks(job->bank->target, TARGET_EVENT_FLASH_JOB_END);
+}
+
+static int esp_flash_job_step(void *priv)
+{
+	struct esp_flash_job *job = priv;
+	struct target *target = job->bank->target;
+	uint8_t file_hash[TC_SHA256_DIGEST_SIZE], target_hash[TC_SHA256_DIGEST_SIZE];
+	size_t cnt;
+	int ret = ERROR_OK;
+
+	if (job->state != ESP_FLASH_JOB_RUNNING)
+		return ERROR_OK;
+	/* stub can run on halted target only, wait until it is halted by user */
+	if (target->state != TARGET_HALTED)
+		return ERROR_OK;
+
+	uint32_t addr = job->offset + job->done;
+	uint32_t len = MIN(job->size - job->done, ESP_FLASH_JOB_BLOCK_SIZE);
+
+	switch (job->type) {
+	case ESP_FLASH_JOB_READ:
+		ret = esp_algo_flash_read(job->bank, job->buf, addr, len);
+		if (ret == ERROR_OK) {
+			ret = fileio_write(job->fileio, len, job->buf, &cnt);
+			if (ret == ERROR_OK && cnt != len)
+				ret = ERROR_FAIL;
+			if (ret != ERROR_OK)
+				LOG_ERROR("File write failure");
+		}
+		break;
+	case ESP_FLASH_JOB_HASH:
+		ret = esp_algo_flash_read(job->bank, job->buf, addr, len);
+		if (ret == ERROR_OK && tc_sha256_update(&job->sha256, job->buf, len) != TC_CRYPTO_SUCCESS) {
+			LOG_ERROR("tc_sha256_update failed!");
+			ret = ERROR_FAIL;
+		}
+		break;
+	case ESP_FLASH_JOB_VERIFY:
+		ret = fileio_read(job->fileio, len, job->buf, &cnt);
+		if (ret != ERROR_OK || cnt != len) {
+			LOG_ERROR("File read failure");
+			ret = ERROR_FAIL;
+			break;
+		}
+		ret = esp_algo_calc_hash(job->buf, len, file_hash);
+		if (ret == ERROR_OK)
+			ret = esp_algo_flash_calc_hash(job->bank, target_hash, addr, len, false);
+		if (ret == ERROR_OK && memcmp(file_hash, target_hash, TC_SHA256_DIGEST_SIZE) != 0) {
+			LOG_ERROR("**** Verification failure in block at 0x%8.8" PRIx32 "! ****", addr);
+			job->mismatch = addr;
+			job->mismatch_found = true;
+			ret = ERROR_FAIL;
+		}
+		break;
+	}
+	if (ret != ERROR_OK) {
+		esp_flash_job_finish(job, ESP_FLASH_JOB_FAILED);
+		return ERROR_OK;
+	}
+
+	job->done += len;
+	if (job->done == job->size) {
+		esp_flash_job_finish(job, ESP_FLASH_JOB_DONE);
+		return ERROR_OK;
+	}
+	int64_t now = timeval_ms();
+	if (now - job->event_ms >= ESP_FLASH_JOB_EVENT_PERIOD) {
+		job->event_ms = now;
+		target_call_event_callbacks(target, TARGET_EVENT_FLASH_JOB_PROGRESS);
+	}
+	return ERROR_OK;
+}
+
+static int esp_flash_job_start(struct command_invocation *cmd,
+	struct target *target,
+	enum esp_flash_job_type type,
+	const char *file_name,
+	uint32_t offset,
+	uint32_t size)
+{
+	struct esp_flash_job *job = &esp_flash_job;
+	struct flash_bank *bank;
+	struct fileio *fileio = NULL;
+
+	if (job->state == ESP_FLASH_JOB_RUNNING) {
+		command_print(cmd, "Flash %s job is already running!", esp_flash_job_type_names[job->type]);
+		return ERROR_FAIL;
+	}
+
+	int retval = esp_algo_target_to_flash_bank(target, &bank, "flash", true);
+	if (retval != ERROR_OK)
+		return ERROR_FAIL;
+
+	if (offset > bank->size) {
+		command_print(cmd, "Offset 0x%8.8" PRIx32 " is out of range of the flash bank", offset);
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	if (offset & 0x3UL) {
+		command_print(cmd, "Unaligned offset!");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	if (size == 0 || size > bank->size - offset)
+		size = bank->size - offset;
+
+	if (type == ESP_FLASH_JOB_READ) {
+		retval = fileio_open(&fileio, file_name, FILEIO_WRITE, FILEIO_BINARY);
+	} else if (type == ESP_FLASH_JOB_VERIFY) {
+		size_t filesize;
+		retval = fileio_open(&fileio, file_name, FILEIO_READ, FILEIO_BINARY);
+		if (retval == ERROR_OK) {
+			retval = fileio_size(fileio, &filesize);
+			if (retval == ERROR_OK && filesize < size)
+				size = filesize;
+		}
+		if (retval == ERROR_OK && !strcmp(target->type->name, "esp32") && (size & 0x3)) {
+			LOG_WARNING("File size not divisible by 4. Not comparing the "
+				"last %" PRIu32 " bytes of the file", size & 0x3);
+			size &= ~0x3;
+		}
+	}
+	if (retval != ERROR_OK) {
+		command_print(cmd, "Could not open file '%s'", file_name);
+		if (fileio)
+			fileio_close(fileio);
+		return retval;
+	}
+
+	memset(job, 0, sizeof(*job));
+	job->type = type;
+	job->bank = bank;
+	job->offset = offset;
+	job->size = size;
+	job->fileio = fileio;
+	job->start_ms = timeval_ms();
+	job->event_ms = job->start_ms;
+	job->state = ESP_FLASH_JOB_RUNNING;
+	if (size == 0) {
+		esp_flash_job_finish(job, type == ESP_FLASH_JOB_HASH ? ESP_FLASH_JOB_FAILED : ESP_FLASH_JOB_DONE);
+		command_print(cmd, "Nothing to do");
+		return ERROR_OK;
+	}
+	job->buf = malloc(ESP_FLASH_JOB_BLOCK_SIZE);
+	if (!job->buf || (type == ESP_FLASH_JOB_HASH && tc_sha256_init(&job->sha256) != TC_CRYPTO_SUCCESS)) {
+		command_print(cmd, "Failed to init flash job!");
+		esp_flash_job_finish(job, ESP_FLASH_JOB_FAILED);
+		return ERROR_FAIL;
+	}
+	retval = target_register_named_timer_callback(esp_flash_job_step, 1, TARGET_TIMER_TYPE_PERIODIC, job,
+		"esp.flash_job");
+	if (retval != ERROR_OK) {
+		command_print(cmd, "Failed to register flash job callback!");
+		esp_flash_job_finish(job, ESP_FLASH_JOB_FAILED);
+		return retval;
+	}
+	command_print(cmd, "Started flash %s job: %" PRIu32 " bytes at 0x%8.8" PRIx32,
+		esp_flash_job_type_names[type], size, offset);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(esp_algo_flash_cmd_job_read)
+{
+	uint32_t offset = 0, size = 0;
+
+	if (CMD_ARGC < 1 || CMD_ARGC > 3)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC > 1)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], offset);
+	if (CMD_ARGC > 2)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[2], size);
+
+	return esp_flash_job_start(CMD, get_current_target(CMD_CTX), ESP_FLASH_JOB_READ, CMD_ARGV[0], offset, size);
+}
+
+COMMAND_HANDLER(esp_algo_flash_cmd_job_verify)
+{
+	uint32_t offset = 0;
+
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC > 1)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], offset);
+
+	return esp_flash_job_start(CMD, get_current_target(CMD_CTX), ESP_FLASH_JOB_VERIFY, CMD_ARGV[0], offset, 0);
+}
+
+COMMAND_HANDLER(esp_algo_flash_cmd_job_hash)
+{
+	uint32_t offset = 0, size = 0;
+
+	if (CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC > 0)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], offset);
+	if (CMD_ARGC > 1)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+
+	return esp_flash_job_start(CMD, get_current_target(CMD_CTX), ESP_FLASH_JOB_HASH, NULL, offset, size);
+}
+
+COMMAND_HANDLER(esp_algo_flash_cmd_job_status)
+{
+	struct esp_flash_job *job = &esp_flash_job;
+
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (job->state == ESP_FLASH_JOB_IDLE) {
+		command_print(CMD, "idle");
+		return ERROR_OK;
+	}
+	char extra[2 * TC_SHA256_DIGEST_SIZE + 2] = "";
+	if (job->state == ESP_FLASH_JOB_DONE && job->type == ESP_FLASH_JOB_HASH) {
+		extra[0] = ' ';
+		for (unsigned int i = 0; i < TC_SHA256_DIGEST_SIZE; i++)
+			sprintf(&extra[1 + 2 * i], "%02x", job->hash[i]);
+	} else if (job->mismatch_found) {
+		snprintf(extra, sizeof(extra), " mismatch 0x%8.8" PRIx32, job->mismatch);
+	}
+	command_print(CMD, "%s %s %" PRIu32 " %" PRIu32 "%s",
+		esp_flash_job_type_names[job->type],
+		esp_flash_job_state_names[job->state],
+		job->done,
+		job->size,
+		extra);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(esp_algo_flash_cmd_job_cancel)
+{
+	struct esp_flash_job *job = &esp_flash_job;
+
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (job->state != ESP_FLASH_JOB_RUNNING) {
+		command_print(CMD, "No flash job is running");
+		return ERROR_OK;
+	}
+	esp_flash_job_finish(job, ESP_FLASH_JOB_CANCELLED);
+	return ERROR_OK;
+}
+
 static COMMAND_HELPER(esp_algo_flash_parse_cmd_verify_bank_hash, struct target *target)
 {
 	if (CMD_ARGC < 2 || CMD_ARGC > 4)
@@ -1771,6 +2358,49 @@ COMMAND_HANDLER_SMP(esp_algo_flash_cmd_encryption, esp_algo_flash_cmd_set_encryp
 COMMAND_HANDLER_SMP(esp_algo_flash_cmd_compression, esp_algo_flash_cmd_set_compression)
 COMMAND_HANDLER_SMP(esp_algo_flash_cmd_appimage_flashoff, esp_algo_flash_cmd_appimage_flashoff_do)
 
+static const struct command_registration esp_flash_job_command_handlers[] = {
+	{
+		.name = "read",
+		.handler = esp_algo_flash_cmd_job_read,
+		.mode = COMMAND_EXEC,
+		.help = "Start background job reading flash contents to the file. "
+			"Size defaults to the rest of the flash bank.",
+		.usage = "filename [offset [size]]",
+	},
+	{
+		.name = "verify",
+		.handler = esp_algo_flash_cmd_job_verify,
+		.mode = COMMAND_EXEC,
+		.help = "Start background job comparing the file and the contents of the flash bank "
+			"block by block using SHA256 hash values.",
+		.usage = "filename [offset]",
+	},
+	{
+		.name = "hash",
+		.handler = esp_algo_flash_cmd_job_hash,
+		.mode = COMMAND_EXEC,
+		.help = "Start background job calculating SHA256 hash of flash contents. "
+			"Size defaults to the rest of the flash bank.",
+		.usage = "[offset [size]]",
+	},
+	{
+		.name = "status",
+		.handler = esp_algo_flash_cmd_job_status,
+		.mode = COMMAND_EXEC,
+		.help = "Print type, state, processed and total bytes of the last flash job. "
+			"Hash or mismatch offset is appended when available.",
+		.usage = "",
+	},
+	{
+		.name = "cancel",
+		.handler = esp_algo_flash_cmd_job_cancel,
+		.mode = COMMAND_EXEC,
+		.help = "Cancel running flash job.",
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
 const struct command_registration esp_flash_exec_flash_command_handlers[] = {
 	{
 		.name = "appimage_offset",
@@ -1820,5 +2450,12 @@ const struct command_registration esp_flash_exec_flash_command_handlers[] = {
 		.help = "Enable stub flasher logs",
 		.usage = "['on'|'off']",
 	},
+	{
+		.name = "flash_job",
+		.mode = COMMAND_EXEC,
+		.help = "Background flash read, verify and hash jobs",
+		.usage = "",
+		.chain = esp_flash_job_command_handlers,
+	},
 	COMMAND_REGISTRATION_DONE
 };
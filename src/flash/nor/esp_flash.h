@@ -150,6 +150,7 @@ int esp_algo_flash_init(struct esp_flash_bank *esp_info, uint32_t sec_sz,
 	const struct esp_flash_apptrace_hw *apptrace_hw,
 	const struct esp_algorithm_hw *stub_hw,
 	bool check_preloaded_binary);
+void esp_algo_flash_free_driver_priv(struct flash_bank *bank);
 int esp_algo_flash_protect(struct flash_bank *bank, int set, unsigned int first, unsigned int last);
 int esp_algo_flash_protect_check(struct flash_bank *bank);
 int esp_algo_flash_blank_check(struct flash_bank *bank);
@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/***************************************************************************
+ *   Lightweight counters of JTAG and target operations                    *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "perf_stats.h"
+#include "perf_trace.h"
+#include "command.h"
+#include "log.h"
+#include "time_support.h"
+
+bool perf_stats_enabled;
+
+/* counters updated at least once, in the order of their first use */
+static OOCD_LIST_HEAD(perf_counters);
+
+static FILE *perf_export_file;
+static unsigned int perf_export_period;
+static int64_t perf_export_next;
+
+int64_t perf_time_us(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+void perf_record(struct perf_counter *counter, int64_t start_us, uint64_t amount)
+{
+	int64_t elapsed = 0;
+
+	if (start_us) {
+		elapsed = perf_time_us() - start_us;
+		if (elapsed < 0)
+			elapsed = 0;
+		if (perf_trace_enabled)
+			perf_trace_add(counter->name, start_us, elapsed, amount);
+	}
+
+	if (!perf_stats_enabled)
+		return;
+
+	if (!counter->listed) {
+		list_add_tail(&counter->lh, &perf_counters);
+		counter->listed = true;
+	}
+
+	counter->count++;
+	counter->amount += amount;
+
+	if (!start_us)
+		return;
+
+	unsigned int bucket = 0;
+	while (bucket < PERF_HISTOGRAM_BUCKETS - 1 && (elapsed >> bucket))
+		bucket++;
+
+	counter->timed++;
+	counter->time_us += elapsed;
+	if ((uint64_t)elapsed > counter->max_us)
+		counter->max_us = elapsed;
+	counter->histogram[bucket]++;
+}
+
+static void perf_stats_reset(void)
+{
+	struct perf_counter *counter;
+
+	list_for_each_entry(counter, &perf_counters, lh) {
+		counter->count = 0;
+		counter->amount = 0;
+		counter->timed = 0;
+		counter->time_us = 0;
+		counter->max_us = 0;
+		memset(counter->histogram, 0, sizeof(counter->histogram));
+	}
+}
+
+static void perf_stats_export(void)
+{
+	struct perf_counter *counter;
+	int64_t now = timeval_ms();
+
+	list_for_each_entry(counter, &perf_counters, lh) {
+		fprintf(perf_export_file, "%" PRId64 ",%s,%" PRIu64 ",%" PRIu64 ",%s,%" PRIu64
+			",%" PRIu64 ",%" PRIu64 "\n",
+			now, counter->name, counter->count, counter->amount,
+			counter->unit ? counter->unit : "", counter->timed,
+			counter->time_us, counter->max_us);
+	}
+	fflush(perf_export_file);
+}
+
+static void perf_stats_close_export(void)
+{
+	if (!perf_export_file)
+		return;
+	perf_stats_export();
+	fclose(perf_export_file);
+	perf_export_file = NULL;
+}
+
+void perf_stats_poll(void)
+{
+	if (!perf_export_file || !perf_export_period)
+		return;
+
+	int64_t now = timeval_ms();
+	if (now < perf_export_next)
+		return;
+	perf_stats_export();
+	perf_export_next = now + perf_export_period;
+}
+
+void perf_stats_exit(void)
+{
+	perf_stats_close_export();
+}
+
+COMMAND_HANDLER(handle_perf_stats_collect_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_ON_OFF(CMD_ARGV[0], perf_stats_enabled);
+
+	command_print(CMD, "%s", perf_stats_enabled ? "on" : "off");
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_perf_stats_dump_command)
+{
+	bool histogram = false;
+	const char *prefix = NULL;
+
+	for (unsigned int i = 0; i < CMD_ARGC; i++) {
+		if (!strcmp(CMD_ARGV[i], "-histogram"))
+			histogram = true;
+		else if (!prefix)
+			prefix = CMD_ARGV[i];
+		else
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	if (list_empty(&perf_counters)) {
+		command_print(CMD, "no statistics collected%s",
+			perf_stats_enabled ? "" : ", enable them with 'perf_stats collect on'");
+		return ERROR_OK;
+	}
+
+	command_print(CMD, "%-24s %10s %14s %-6s %12s %10s %10s",
+		"name", "count", "amount", "unit", "time [ms]", "avg [us]", "max [us]");
+
+	struct perf_counter *counter;
+	list_for_each_entry(counter, &perf_counters, lh) {
+		if (prefix && strncmp(counter->name, prefix, strlen(prefix)))
+			continue;
+
+		if (!counter->timed) {
+			command_print(CMD, "%-24s %10" PRIu64 " %14" PRIu64 " %-6s",
+				counter->name, counter->count, counter->amount,
+				counter->unit ? counter->unit : "");
+			continue;
+		}
+
+		command_print(CMD, "%-24s %10" PRIu64 " %14" PRIu64 " %-6s %12.3f %10" PRIu64 " %10" PRIu64,
+			counter->name, counter->count, counter->amount,
+			counter->unit ? counter->unit : "",
+			counter->time_us / 1000.0, counter->time_us / counter->timed,
+			counter->max_us);
+
+		if (!histogram)
+			continue;
+
+		for (unsigned int i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+			if (!counter->histogram[i])
+				continue;
+			if (i == PERF_HISTOGRAM_BUCKETS - 1)
+				command_print(CMD, "    >= %8" PRIu64 " us: %" PRIu64,
+					(uint64_t)1 << (i - 1), counter->histogram[i]);
+			else
+				command_print(CMD, "    <  %8" PRIu64 " us: %" PRIu64,
+					(uint64_t)1 << i, counter->histogram[i]);
+		}
+	}
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_perf_stats_reset_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	perf_stats_reset();
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_perf_stats_export_command)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned int period = 0;
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], period);
+
+	perf_stats_close_export();
+	perf_export_period = 0;
+
+	if (!strcmp(CMD_ARGV[0], "off"))
+		return ERROR_OK;
+
+	perf_export_file = fopen(CMD_ARGV[0], "a");
+	if (!perf_export_file) {
+		command_print(CMD, "failed to open \"%s\"", CMD_ARGV[0]);
+		return ERROR_FAIL;
+	}
+	fprintf(perf_export_file, "time_ms,name,count,amount,unit,timed,time_us,max_us\n");
+
+	if (!period) {
+		/* one-shot export */
+		perf_stats_close_export();
+		return ERROR_OK;
+	}
+
+	perf_export_period = period;
+	perf_export_next = timeval_ms() + period;
+	return ERROR_OK;
+}
+
+static const struct command_registration perf_stats_subcommand_handlers[] = {
+	{
+		.name = "collect",
+		.handler = handle_perf_stats_collect_command,
+		.mode = COMMAND_ANY,
+		.help = "display or set whether the statistics are collected",
+		.usage = "['on'|'off']",
+	},
+	{
+		.name = "dump",
+		.handler = handle_perf_stats_dump_command,
+		.mode = COMMAND_ANY,
+		.help = "print the counters, optionally only those starting "
+			"with the given prefix",
+		.usage = "['-histogram'] [prefix]",
+	},
+	{
+		.name = "reset",
+		.handler = handle_perf_stats_reset_command,
+		.mode = COMMAND_ANY,
+		.help = "clear all counters",
+		.usage = "",
+	},
+	{
+		.name = "export",
+		.handler = handle_perf_stats_export_command,
+		.mode = COMMAND_ANY,
+		.help = "append the counters as CSV to a file, once or every "
+			"period_ms milliseconds until 'off' is given",
+		.usage = "(file_name ['period_ms'] | 'off')",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration perf_stats_command_handlers[] = {
+	{
+		.name = "perf_stats",
+		.mode = COMMAND_ANY,
+		.help = "statistics of JTAG, USB, target and GDB operations",
+		.chain = perf_stats_subcommand_handlers,
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int perf_stats_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, perf_stats_command_handlers);
+}
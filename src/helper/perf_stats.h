@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/***************************************************************************
+ *   Lightweight counters of JTAG and target operations                    *
+ ***************************************************************************/
+
+#ifndef OPENOCD_HELPER_PERF_STATS_H
+#define OPENOCD_HELPER_PERF_STATS_H
+
+#include "types.h"
+#include "list.h"
+
+struct command_context;
+
+/* bucket N counts events which took [2^(N-1), 2^N) us, the last one all longer */
+#define PERF_HISTOGRAM_BUCKETS	24
+
+/**
+ * Statistics of one kind of event. Counters are defined statically where the
+ * event happens and are listed by the 'perf_stats' commands once they have
+ * been updated for the first time.
+ */
+struct perf_counter {
+	char name[32];
+	/** what the amount counts, e.g. "bytes", or NULL if it is not used */
+	const char *unit;
+	/** number of events */
+	uint64_t count;
+	/** sum of the amounts passed with the events */
+	uint64_t amount;
+	/** number of events which were timed */
+	uint64_t timed;
+	uint64_t time_us;
+	uint64_t max_us;
+	uint64_t histogram[PERF_HISTOGRAM_BUCKETS];
+	bool listed;
+	struct list_head lh;
+};
+
+#define PERF_COUNTER_INIT(_name, _unit) { .name = (_name), .unit = (_unit) }
+
+extern bool perf_stats_enabled;
+/* set while timed events are recorded for the timeline, see perf_trace.h */
+extern bool perf_trace_enabled;
+
+/**
+ * @returns current time in us used for the measurements. It is wall-clock
+ * time from gettimeofday(), so a clock step can make a duration negative;
+ * such durations are recorded as 0.
+ */
+int64_t perf_time_us(void);
+void perf_record(struct perf_counter *counter, int64_t start_us, uint64_t amount);
+
+/** @returns start time to be passed to perf_end(), 0 if neither statistics nor trace are enabled */
+static inline int64_t perf_start(void)
+{
+	return (perf_stats_enabled || perf_trace_enabled) ? perf_time_us() : 0;
+}
+
+/** Count an event which started at @a start_us, record its duration and add it to the trace. */
+static inline void perf_end(struct perf_counter *counter, int64_t start_us, uint64_t amount)
+{
+	if (start_us)
+		perf_record(counter, start_us, amount);
+}
+
+/** Count an event without measuring its duration. */
+static inline void perf_count(struct perf_counter *counter, uint64_t amount)
+{
+	if (perf_stats_enabled)
+		perf_record(counter, 0, amount);
+}
+
+/** Write the statistics to the export file if its period elapsed, called from server_loop(). */
+void perf_stats_poll(void);
+void perf_stats_exit(void);
+int perf_stats_register_commands(struct command_context *cmd_ctx);
+
+#endif /* OPENOCD_HELPER_PERF_STATS_H */
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/***************************************************************************
+ *   Timeline of timed operations in Chrome trace format                   *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "perf_stats.h"
+#include "perf_trace.h"
+#include "command.h"
+#include "log.h"
+
+#define PERF_TRACE_DEFAULT_EVENTS	(256 * 1024)
+
+struct perf_trace_event {
+	const char *name;
+	int64_t start_us;
+	int64_t duration_us;
+	uint64_t amount;
+};
+
+bool perf_trace_enabled;
+
+/* OpenOCD handles everything from one thread, so a plain ring buffer is
+ * enough. Once it is full the oldest events are overwritten. */
+static struct perf_trace_event *perf_trace_events;
+static unsigned int perf_trace_size;
+static unsigned int perf_trace_head;
+static unsigned int perf_trace_count;
+static uint64_t perf_trace_dropped;
+static int64_t perf_trace_origin;
+static char *perf_trace_output;
+
+void perf_trace_add(const char *name, int64_t start_us, int64_t duration_us, uint64_t amount)
+{
+	if (!perf_trace_events)
+		return;
+
+	struct perf_trace_event *event = &perf_trace_events[perf_trace_head];
+	event->name = name;
+	event->start_us = start_us;
+	event->duration_us = duration_us;
+	event->amount = amount;
+
+	perf_trace_head = (perf_trace_head + 1) % perf_trace_size;
+	if (perf_trace_count < perf_trace_size)
+		perf_trace_count++;
+	else
+		perf_trace_dropped++;
+}
+
+static void perf_trace_put_string(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			fputc('\\', file);
+		fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+static int perf_trace_write(const char *filename)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file) {
+		LOG_ERROR("failed to open \"%s\"", filename);
+		return ERROR_FAIL;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%" PRIu64 "},"
+		"\"traceEvents\":[\n", perf_trace_dropped);
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+		"\"args\":{\"name\":\"openocd\"}}");
+
+	unsigned int first = (perf_trace_head + perf_trace_size - perf_trace_count) % perf_trace_size;
+	for (unsigned int i = 0; i < perf_trace_count; i++) {
+		const struct perf_trace_event *event = &perf_trace_events[(first + i) % perf_trace_size];
+		fprintf(file, ",\n{\"name\":");
+		perf_trace_put_string(file, event->name);
+		fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+			"\"ts\":%" PRId64 ",\"dur\":%" PRId64 ",\"args\":{\"amount\":%" PRIu64 "}}",
+			event->start_us - perf_trace_origin, event->duration_us, event->amount);
+	}
+	fprintf(file, "\n]}\n");
+
+	int retval = ferror(file) ? ERROR_FAIL : ERROR_OK;
+	if (fclose(file) != 0)
+		retval = ERROR_FAIL;
+	if (retval != ERROR_OK)
+		LOG_ERROR("failed to write \"%s\"", filename);
+	else
+		LOG_INFO("Wrote %u trace events to %s", perf_trace_count, filename);
+	return retval;
+}
+
+void perf_trace_exit(void)
+{
+	perf_trace_enabled = false;
+	if (perf_trace_output && perf_trace_count)
+		perf_trace_write(perf_trace_output);
+	free(perf_trace_output);
+	perf_trace_output = NULL;
+	free(perf_trace_events);
+	perf_trace_events = NULL;
+}
+
+COMMAND_HANDLER(handle_perf_trace_start_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned int size = PERF_TRACE_DEFAULT_EVENTS;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], size);
+	if (!size)
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+
+	perf_trace_enabled = false;
+	if (size != perf_trace_size || !perf_trace_events) {
+		free(perf_trace_events);
+		perf_trace_size = 0;
+		perf_trace_events = calloc(size, sizeof(*perf_trace_events));
+		if (!perf_trace_events) {
+			LOG_ERROR("Unable to allocate memory");
+			return ERROR_FAIL;
+		}
+		perf_trace_size = size;
+	}
+	perf_trace_head = 0;
+	perf_trace_count = 0;
+	perf_trace_dropped = 0;
+	perf_trace_origin = perf_time_us();
+	perf_trace_enabled = true;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_perf_trace_stop_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	perf_trace_enabled = false;
+	command_print(CMD, "%u events recorded, %" PRIu64 " dropped",
+		perf_trace_count, perf_trace_dropped);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_perf_trace_write_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	const char *filename = CMD_ARGC == 1 ? CMD_ARGV[0] : perf_trace_output;
+	if (!filename) {
+		command_print(CMD, "no file name given");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	if (!perf_trace_events) {
+		command_print(CMD, "trace was not started");
+		return ERROR_FAIL;
+	}
+
+	return perf_trace_write(filename);
+}
+
+COMMAND_HANDLER(handle_perf_trace_output_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		free(perf_trace_output);
+		perf_trace_output = NULL;
+		if (strcmp(CMD_ARGV[0], "off")) {
+			perf_trace_output = strdup(CMD_ARGV[0]);
+			if (!perf_trace_output) {
+				LOG_ERROR("Unable to allocate memory");
+				return ERROR_FAIL;
+			}
+		}
+	}
+
+	command_print(CMD, "%s", perf_trace_output ? perf_trace_output : "off");
+	return ERROR_OK;
+}
+
+static const struct command_registration perf_trace_subcommand_handlers[] = {
+	{
+		.name = "start",
+		.handler = handle_perf_trace_start_command,
+		.mode = COMMAND_ANY,
+		.help = "clear the trace buffer and start recording, keeping "
+			"at most the given number of the latest events",
+		.usage = "[max_events]",
+	},
+	{
+		.name = "stop",
+		.handler = handle_perf_trace_stop_command,
+		.mode = COMMAND_ANY,
+		.help = "stop recording",
+		.usage = "",
+	},
+	{
+		.name = "write",
+		.handler = handle_perf_trace_write_command,
+		.mode = COMMAND_ANY,
+		.help = "write the recorded events as Chrome trace JSON",
+		.usage = "[file_name]",
+	},
+	{
+		.name = "output",
+		.handler = handle_perf_trace_output_command,
+		.mode = COMMAND_ANY,
+		.help = "display or set the file the trace is written to on exit",
+		.usage = "[file_name | 'off']",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration perf_trace_command_handlers[] = {
+	{
+		.name = "perf_trace",
+		.mode = COMMAND_ANY,
+		.help = "timeline of JTAG, target, GDB and server activity",
+		.chain = perf_trace_subcommand_handlers,
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int perf_trace_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, perf_trace_command_handlers);
+}
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/***************************************************************************
+ *   Timeline of timed operations in Chrome trace format                   *
+ ***************************************************************************/
+
+#ifndef OPENOCD_HELPER_PERF_TRACE_H
+#define OPENOCD_HELPER_PERF_TRACE_H
+
+#include "types.h"
+
+struct command_context;
+
+/**
+ * Add a complete event to the trace buffer. Called by perf_record() for
+ * every timed event of a perf_counter while tracing is enabled, so all
+ * operations measured with perf_start()/perf_end() appear on the timeline.
+ * @a name must stay valid until the trace is written.
+ */
+void perf_trace_add(const char *name, int64_t start_us, int64_t duration_us, uint64_t amount);
+
+/** Write the trace to the file set by 'perf_trace output', if any. */
+void perf_trace_exit(void);
+int perf_trace_register_commands(struct command_context *cmd_ctx);
+
+#endif /* OPENOCD_HELPER_PERF_TRACE_H */
@@ -26,6 +26,7 @@
 #include <transport/transport.h>
 #include <helper/jep106.h>
 #include "helper/system.h"
+#include <helper/perf_stats.h>
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -404,6 +405,11 @@ void jtag_add_plain_ir_scan(int num_bits, const uint8_t *out_bits, uint8_t *in_b
 	int retval = interface_jtag_add_plain_ir_scan(
 			num_bits, out_bits, in_bits, state);
 	jtag_set_error(retval);
+
+	/* the instructions of the TAPs are unknown now, make sure that code
+	 * comparing cur_instr before skipping an IR scan does not skip the next one */
+	for (struct jtag_tap *tap = jtag_all_taps(); tap; tap = tap->next_tap)
+		buf_set_ones(tap->cur_instr, tap->ir_length);
 }
 
 static int jtag_check_value_inner(uint8_t *captured, uint8_t *in_check_value,
@@ -940,6 +946,9 @@ void jtag_check_value_mask(struct scan_field *field, uint8_t *value, uint8_t *ma
 	jtag_set_error(retval);
 }
 
+static struct perf_counter jtag_execute_queue_perf = PERF_COUNTER_INIT("jtag.execute_queue", NULL);
+static struct perf_counter jtag_scan_perf = PERF_COUNTER_INIT("jtag.scan", "bits");
+
 int default_interface_jtag_execute_queue(void)
 {
 	if (!is_adapter_initialized()) {
@@ -963,6 +972,14 @@ int default_interface_jtag_execute_queue(void)
 	}
 
 	struct jtag_command *cmd = jtag_command_queue_get();
+
+	if (perf_stats_enabled) {
+		for (struct jtag_command *c = cmd; c; c = c->next) {
+			if (c->type == JTAG_SCAN)
+				perf_count(&jtag_scan_perf, jtag_scan_size(c->cmd.scan));
+		}
+	}
+
 	int result = adapter_driver->jtag_ops->execute_queue(cmd);
 
 	while (LOG_LEVEL_IS(LOG_LVL_DEBUG_IO) && cmd) {
@@ -1028,8 +1045,11 @@ int default_interface_jtag_execute_queue(void)
 
 void jtag_execute_queue_noclear(void)
 {
+	int64_t start = perf_start();
+
 	jtag_flush_queue_count++;
 	jtag_set_error(interface_jtag_execute_queue());
+	perf_end(&jtag_execute_queue_perf, start, 0);
 
 	if (jtag_flush_queue_sleep > 0) {
 		/* For debug purposes it can be useful to test performance
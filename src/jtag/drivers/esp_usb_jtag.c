@@ -183,6 +183,16 @@ struct jtag_proto_caps_speed_apb {
  *to be read, we have multiple buffers to store those before the bitq interface reads them out. */
 #define IN_BUF_CT 8
 
+/* Out buffers are sent using asynchronous transfers, so that the next buffer can be filled while
+ * the previous ones are still on their way to the adapter. This is the number of OUT_BUF_SZ-sized
+ * buffers (and transfers) in the ring. */
+#define OUT_XFER_CT 4
+/* IN transfers are kept submitted to the device all the time, so that TDO data is pulled off the
+ * adapter as soon as it is available instead of when we get around to asking for it. */
+#define IN_XFER_CT 8
+/* Granularity of waiting for USB events, in ms. */
+#define XFER_POLL_MS 100
+
 /*
  * comment from libusb:
  * As per the USB 3.0 specs, the current maximum limit for the depth is 7.
@@ -191,14 +201,46 @@ struct jtag_proto_caps_speed_apb {
 
 #define ESP_USB_INTERFACE       1
 
+/* One asynchronous USB transfer in the OUT or IN ring */
+struct esp_usb_jtag_xfer {
+	struct libusb_transfer *transfer;
+	uint8_t *buf;
+	unsigned int len;			/* bytes to send; 0 if this OUT transfer has been reaped */
+	unsigned int done_len;		/* bytes sent or received so far */
+	enum libusb_transfer_status status;
+	bool busy;					/* submitted, completion callback not called yet */
+};
+
+/* Transfer statistics, see `espusbjtag stats` */
+struct esp_usb_jtag_stats {
+	int64_t start_ms;
+	uint64_t out_bytes;
+	uint64_t in_bytes;
+	uint64_t clocks;			/* TCK cycles queued */
+	uint64_t captured_bits;
+	uint64_t nibbles;			/* command nibbles queued, see esp_usb_jtag_command_add_raw() */
+	uint64_t rep_nibbles;		/* ...of which CMD_REP */
+	uint64_t tdi_merged;		/* don't-care TDI bits changed to extend a run */
+	unsigned int out_xfers;
+	unsigned int in_xfers;
+	unsigned int out_waits;		/* times the OUT ring was full */
+	unsigned int max_out_inflight;
+};
+
 /* Private data */
 struct esp_usb_jtag {
 	struct libusb_device_handle *usb_device;
 	uint32_t base_speed_khz;
 	uint16_t div_min;
 	uint16_t div_max;
-	uint8_t out_buf[OUT_BUF_SZ];
-	unsigned int out_buf_pos_nibbles;			/* write position in out_buf */
+	uint8_t out_buf[OUT_XFER_CT][OUT_BUF_SZ];
+	unsigned int cur_out_buf;					/* out_buf being filled */
+	unsigned int out_buf_pos_nibbles;			/* write position in out_buf[cur_out_buf] */
+	struct esp_usb_jtag_xfer out_xfer[OUT_XFER_CT];
+
+	uint8_t in_xfer_buf[IN_XFER_CT][IN_BUF_SZ];
+	struct esp_usb_jtag_xfer in_xfer[IN_XFER_CT];
+	unsigned int cur_in_xfer;					/* oldest submitted IN transfer */
 
 	uint8_t in_buf[IN_BUF_CT][IN_BUF_SZ];
 	unsigned int in_buf_size_bits[IN_BUF_CT];	/* size in bits of the data stored in an in_buf */
@@ -211,6 +253,12 @@ struct esp_usb_jtag {
 	unsigned int prev_cmd;		/* previous command, stored here for RLEing. */
 	int prev_cmd_repct;			/* Amount of repetitions of that command we have seen until now */
 
+	/* TAP state as followed from the TMS values we clock out. Only trusted after a run of
+	 * five TMS=1 clocks put the TAP in TAP_RESET. */
+	enum tap_state tap_state;
+	bool tap_state_valid;
+	unsigned int tms_ones;		/* consecutive TMS=1 clocks */
+
 	/* This is the total number of in bits we need to read, including in unsent commands */
 	unsigned int pending_in_bits;
 	FILE *logfile;			/* If non-NULL, we log communication traces here. */
@@ -218,6 +266,8 @@ struct esp_usb_jtag {
 	unsigned int hw_in_fifo_len;
 	char *serial[256 + 1];	/* device serial */
 
+	struct esp_usb_jtag_stats stats;
+
 	struct bitq_interface bitq_interface;
 };
 
@@ -352,7 +402,147 @@ static int esp_usb_jtag_revive_device(struct libusb_device_handle *usb_device)
 	return ERROR_OK;
 }
 
-/* Try to receive from USB endpoint into the current priv->in_buf */
+static LIBUSB_CALL void esp_usb_jtag_out_cb(struct libusb_transfer *transfer)
+{
+	struct esp_usb_jtag_xfer *xfer = transfer->user_data;
+
+	xfer->done_len += transfer->actual_length;
+	xfer->status = transfer->status;
+	if (transfer->status == LIBUSB_TRANSFER_COMPLETED && xfer->done_len < xfer->len) {
+		/* Short write, send the remainder */
+		transfer->buffer = xfer->buf + xfer->done_len;
+		transfer->length = xfer->len - xfer->done_len;
+		if (libusb_submit_transfer(transfer) == LIBUSB_SUCCESS)
+			return;
+		xfer->status = LIBUSB_TRANSFER_ERROR;
+	}
+	perf_count(&jtag_libusb_out_perf, xfer->done_len);
+	xfer->busy = false;
+}
+
+static LIBUSB_CALL void esp_usb_jtag_in_cb(struct libusb_transfer *transfer)
+{
+	struct esp_usb_jtag_xfer *xfer = transfer->user_data;
+
+	xfer->done_len = transfer->actual_length;
+	xfer->status = transfer->status;
+	perf_count(&jtag_libusb_in_perf, xfer->done_len);
+	xfer->busy = false;
+}
+
+/* Handles USB events until the transfer completes or `timeout_ms` expires */
+static int esp_usb_jtag_wait_xfer(struct esp_usb_jtag_xfer *xfer, unsigned int timeout_ms)
+{
+	int64_t start = timeval_ms();
+
+	while (xfer->busy) {
+		int ret = jtag_libusb_handle_events_timeout_completed(XFER_POLL_MS, NULL);
+		if (ret != LIBUSB_SUCCESS && ret != LIBUSB_ERROR_INTERRUPTED) {
+			LOG_ERROR("esp_usb_jtag: libusb_handle_events() failed with %s", libusb_error_name(ret));
+			return ERROR_FAIL;
+		}
+		if (xfer->busy && timeval_ms() - start > timeout_ms) {
+			LOG_ERROR("esp_usb_jtag: USB transfer timed out");
+			return ERROR_TIMEOUT_REACHED;
+		}
+	}
+	return ERROR_OK;
+}
+
+static int esp_usb_jtag_submit_in(struct esp_usb_jtag_xfer *xfer)
+{
+	xfer->done_len = 0;
+	xfer->busy = true;
+	int ret = libusb_submit_transfer(xfer->transfer);
+	if (ret != LIBUSB_SUCCESS) {
+		xfer->busy = false;
+		LOG_ERROR("esp_usb_jtag: failed to submit IN transfer (%s)", libusb_error_name(ret));
+		return ERROR_FAIL;
+	}
+	return ERROR_OK;
+}
+
+/* Waits for a submitted OUT transfer to finish so that its buffer can be reused. */
+static int esp_usb_jtag_reap_out(struct esp_usb_jtag_xfer *xfer)
+{
+	if (xfer->len == 0)
+		return ERROR_OK;
+
+	if (xfer->busy)
+		priv->stats.out_waits++;
+	/* libusb times the transfer out by itself, this is just a safety net */
+	int ret = esp_usb_jtag_wait_xfer(xfer, 2 * LIBUSB_TIMEOUT_MS);
+	if (ret == ERROR_OK) {
+		if (priv->logfile)
+			log_cmds(xfer->buf, xfer->len, xfer->done_len);
+		if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
+			LOG_DEBUG("esp_usb_jtag: usb sent only %d out of %d bytes.", xfer->done_len, xfer->len);
+			ret = xfer->status == LIBUSB_TRANSFER_TIMED_OUT ? ERROR_TIMEOUT_REACHED : ERROR_FAIL;
+		}
+	}
+	xfer->len = 0;
+	if (ret != ERROR_OK) {
+		int reset_ret = esp_usb_jtag_revive_device(priv->usb_device);
+		if (reset_ret != ERROR_OK)
+			LOG_ERROR("esp_usb_jtag: failed to revive USB device!");
+	}
+	return ret;
+}
+
+/* Waits for all OUT transfers in flight, oldest first */
+static int esp_usb_jtag_reap_all_out(void)
+{
+	for (unsigned int i = 1; i <= OUT_XFER_CT; i++) {
+		int ret = esp_usb_jtag_reap_out(&priv->out_xfer[(priv->cur_out_buf + i) % OUT_XFER_CT]);
+		if (ret != ERROR_OK)
+			return ret;
+	}
+	return ERROR_OK;
+}
+
+static void esp_usb_jtag_free_xfers(struct esp_usb_jtag_xfer *xfers, unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++) {
+		if (xfers[i].busy)
+			libusb_cancel_transfer(xfers[i].transfer);
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		/* A cancelled transfer still gets its callback, wait for it before freeing */
+		if (xfers[i].busy && esp_usb_jtag_wait_xfer(&xfers[i], LIBUSB_TIMEOUT_MS) != ERROR_OK)
+			LOG_WARNING("esp_usb_jtag: could not cancel USB transfer");
+		libusb_free_transfer(xfers[i].transfer);
+		xfers[i].transfer = NULL;
+		xfers[i].busy = false;
+	}
+}
+
+static int esp_usb_jtag_alloc_xfers(void)
+{
+	for (unsigned int i = 0; i < OUT_XFER_CT; i++) {
+		struct esp_usb_jtag_xfer *xfer = &priv->out_xfer[i];
+		xfer->buf = priv->out_buf[i];
+		xfer->transfer = libusb_alloc_transfer(0);
+		if (!xfer->transfer)
+			return ERROR_FAIL;
+		libusb_fill_bulk_transfer(xfer->transfer, priv->usb_device, priv->write_ep, xfer->buf,
+			0, esp_usb_jtag_out_cb, xfer, LIBUSB_TIMEOUT_MS);
+	}
+	for (unsigned int i = 0; i < IN_XFER_CT; i++) {
+		struct esp_usb_jtag_xfer *xfer = &priv->in_xfer[i];
+		xfer->buf = priv->in_xfer_buf[i];
+		xfer->transfer = libusb_alloc_transfer(0);
+		if (!xfer->transfer)
+			return ERROR_FAIL;
+		/* No libusb timeout: these wait for the adapter for as long as it takes */
+		libusb_fill_bulk_transfer(xfer->transfer, priv->usb_device, priv->read_ep, xfer->buf,
+			IN_BUF_SZ, esp_usb_jtag_in_cb, xfer, 0);
+		if (esp_usb_jtag_submit_in(xfer) != ERROR_OK)
+			return ERROR_FAIL;
+	}
+	return ERROR_OK;
+}
+
+/* Receive the next packet from the IN transfer ring into the current priv->in_buf */
 static int esp_usb_jtag_recv_buf(void)
 {
 	if (priv->in_buf_size_bits[priv->cur_in_buf_wr] != 0) {
@@ -361,7 +551,7 @@ static int esp_usb_jtag_recv_buf(void)
 			priv->in_buf_size_bits[priv->cur_in_buf_wr]);
 	}
 
-	unsigned int recvd = 0, ct = (priv->pending_in_bits + 7) / 8;
+	unsigned int ct = (priv->pending_in_bits + 7) / 8;
 	if (ct > IN_BUF_SZ)
 		ct = IN_BUF_SZ;
 	if (ct == 0) {
@@ -371,80 +561,94 @@ static int esp_usb_jtag_recv_buf(void)
 		return ERROR_OK;
 	}
 
-	priv->in_buf_size_bits[priv->cur_in_buf_wr] = 0;
-	while (recvd < ct) {
-		unsigned int tr;
-		int ret = jtag_libusb_bulk_read(priv->usb_device,
-			priv->read_ep,
-			(char *)priv->in_buf[priv->cur_in_buf_wr] + recvd,
-			ct,
-			LIBUSB_TIMEOUT_MS,	/*ms*/
-			(int *)&tr);
-		if (priv->logfile)
-			log_resp(priv->in_buf[priv->cur_in_buf_wr], ct, tr);
-		if (ret != ERROR_OK) {
-			int reset_ret = esp_usb_jtag_revive_device(priv->usb_device);
-			if (reset_ret != ERROR_OK)
-				LOG_ERROR("esp_usb_jtag: failed to revive USB device!");
-			return ret;
-		}
-		if (tr == 0) {
-			/* Sometimes the hardware returns 0 bytes instead of NAKking the transaction. Ignore this. */
-			return ERROR_FAIL;
-		}
+	struct esp_usb_jtag_xfer *xfer = &priv->in_xfer[priv->cur_in_xfer];
+	int ret = esp_usb_jtag_wait_xfer(xfer, LIBUSB_TIMEOUT_MS);
+	if (ret == ERROR_OK && xfer->status != LIBUSB_TRANSFER_COMPLETED)
+		ret = xfer->status == LIBUSB_TRANSFER_TIMED_OUT ? ERROR_TIMEOUT_REACHED : ERROR_FAIL;
+	if (priv->logfile)
+		log_resp(xfer->buf, ct, ret == ERROR_OK ? xfer->done_len : 0);
+	if (ret != ERROR_OK) {
+		int reset_ret = esp_usb_jtag_revive_device(priv->usb_device);
+		if (reset_ret != ERROR_OK)
+			LOG_ERROR("esp_usb_jtag: failed to revive USB device!");
+		return ret;
+	}
 
-		if (tr != ct) {
-			/* Huh, short read? */
-			LOG_DEBUG("esp_usb_jtag: usb received only %d out of %d bytes.", tr, ct);
-		}
-		/* Adjust the amount of bits we still expect to read from the USB device after this. */
-		unsigned int bits_in_buf = priv->pending_in_bits;	/* initially assume we read
-									* everything that was pending */
-		if (bits_in_buf > tr * 8)
-			bits_in_buf = tr * 8;	/* ...but correct that if that was not the case. */
-		priv->pending_in_bits -= bits_in_buf;
-		priv->in_buf_size_bits[priv->cur_in_buf_wr] += bits_in_buf;
-		recvd += tr;
+	unsigned int tr = xfer->done_len;
+	/* Hand the transfer back to the device right away, it goes to the tail of the ring. */
+	priv->cur_in_xfer = (priv->cur_in_xfer + 1) % IN_XFER_CT;
+	if (tr == 0) {
+		/* Sometimes the hardware returns 0 bytes instead of NAKking the transaction. Ignore this. */
+		esp_usb_jtag_submit_in(xfer);
+		return ERROR_FAIL;
 	}
+	if (tr != ct) {
+		/* Short read; the rest will arrive in the next packet. */
+		LOG_DEBUG("esp_usb_jtag: usb received only %d out of %d bytes.", tr, ct);
+	}
+	memcpy(priv->in_buf[priv->cur_in_buf_wr], xfer->buf, tr);
+	ret = esp_usb_jtag_submit_in(xfer);
+
+	/* Adjust the amount of bits we still expect to read from the USB device after this. */
+	unsigned int bits_in_buf = priv->pending_in_bits;	/* initially assume we read
+								* everything that was pending */
+	if (bits_in_buf > tr * 8)
+		bits_in_buf = tr * 8;	/* ...but correct that if that was not the case. */
+	priv->pending_in_bits -= bits_in_buf;
+	priv->in_buf_size_bits[priv->cur_in_buf_wr] = bits_in_buf;
+	priv->stats.in_bytes += tr;
+	priv->stats.in_xfers++;
+
 	/* next in buffer for the next time. */
 	priv->cur_in_buf_wr++;
 	if (priv->cur_in_buf_wr == IN_BUF_CT)
 		priv->cur_in_buf_wr = 0;
-	LOG_DEBUG_IO("esp_usb_jtag: In ep: received %d bytes; %d bytes (%d bits) left.", recvd,
+	LOG_DEBUG_IO("esp_usb_jtag: In ep: received %d bytes; %d bytes (%d bits) left.", tr,
 		(priv->pending_in_bits + 7) / 8, priv->pending_in_bits);
-	return ERROR_OK;
+	return ret;
 }
 
-/* Sends priv->out_buf to the USB device. */
+/* Queues priv->out_buf[priv->cur_out_buf] for sending to the USB device and switches to the next
+ * buffer of the ring, waiting for it if it is still in flight. */
 static int esp_usb_jtag_send_buf(void)
 {
 	unsigned int ct = priv->out_buf_pos_nibbles / 2;
-	unsigned int written = 0;
-
-	while (written < ct) {
-		int tr = 0, ret = jtag_libusb_bulk_write(priv->usb_device,
-			priv->write_ep,
-			(char *)priv->out_buf + written,
-			ct - written,
-			LIBUSB_TIMEOUT_MS,	/*ms*/
-			&tr);
-		LOG_DEBUG_IO("esp_usb_jtag: sent %d bytes.", tr);
-		if (priv->logfile)
-			log_cmds(priv->out_buf, ct, tr);
-		if (written + tr != ct) {
-			LOG_DEBUG("esp_usb_jtag: usb sent only %d out of %d bytes.",
-				written + tr,
-				ct);
-		}
-		if (ret != ERROR_OK) {
+
+	if (ct > 0) {
+		struct esp_usb_jtag_xfer *xfer = &priv->out_xfer[priv->cur_out_buf];
+		xfer->len = ct;
+		xfer->done_len = 0;
+		xfer->transfer->buffer = xfer->buf;
+		xfer->transfer->length = ct;
+		xfer->busy = true;
+		int ret = libusb_submit_transfer(xfer->transfer);
+		if (ret != LIBUSB_SUCCESS) {
+			xfer->busy = false;
+			xfer->len = 0;
+			LOG_ERROR("esp_usb_jtag: failed to submit OUT transfer (%s)", libusb_error_name(ret));
 			int reset_ret = esp_usb_jtag_revive_device(priv->usb_device);
 			if (reset_ret != ERROR_OK)
 				LOG_ERROR("esp_usb_jtag: failed to revive USB device!");
-			return ret;
+			return ERROR_FAIL;
+		}
+		LOG_DEBUG_IO("esp_usb_jtag: queued %d bytes.", ct);
+		priv->stats.out_bytes += ct;
+		priv->stats.out_xfers++;
+
+		unsigned int inflight = 0;
+		for (unsigned int i = 0; i < OUT_XFER_CT; i++) {
+			if (priv->out_xfer[i].busy)
+				inflight++;
 		}
-		written += tr;
+		if (inflight > priv->stats.max_out_inflight)
+			priv->stats.max_out_inflight = inflight;
+
+		priv->out_buf_pos_nibbles = 0;
+		priv->cur_out_buf = (priv->cur_out_buf + 1) % OUT_XFER_CT;
+		ret = esp_usb_jtag_reap_out(&priv->out_xfer[priv->cur_out_buf]);
+		if (ret != ERROR_OK)
+			return ret;
 	}
-	priv->out_buf_pos_nibbles = 0;
 
 	/* If there's more than a bufferful of data queuing up in the jtag adapters IN endpoint, empty
 	 * all but one buffer. */
@@ -459,15 +663,19 @@ static int esp_usb_jtag_send_buf(void)
 static int esp_usb_jtag_command_add_raw(unsigned int cmd)
 {
 	int ret = ERROR_OK;
+	uint8_t *out_buf = priv->out_buf[priv->cur_out_buf];
 
 	if ((priv->out_buf_pos_nibbles / 2) >= OUT_BUF_SZ)
 		return ERROR_FAIL;
 
 	if ((priv->out_buf_pos_nibbles & 1) == 0)
-		priv->out_buf[priv->out_buf_pos_nibbles / 2] = (cmd << 4);
+		out_buf[priv->out_buf_pos_nibbles / 2] = (cmd << 4);
 	else
-		priv->out_buf[priv->out_buf_pos_nibbles / 2] |= cmd;
+		out_buf[priv->out_buf_pos_nibbles / 2] |= cmd;
 	priv->out_buf_pos_nibbles++;
+	priv->stats.nibbles++;
+	if (cmd >= CMD_REP(0))
+		priv->stats.rep_nibbles++;
 
 	if (priv->out_buf_pos_nibbles == OUT_BUF_SZ * 2)
 		ret = esp_usb_jtag_send_buf();
@@ -518,14 +726,50 @@ static int esp_usb_jtag_command_add(unsigned int cmd)
 	return ERROR_OK;
 }
 
+/* Follows the TAP state machine through the clock that is about to be sent. Returns true if
+ * the TAP samples TDI on this clock. */
+static bool esp_usb_jtag_track_tap(int tms)
+{
+	/* Without a known state, every TDI bit matters */
+	bool tdi_used = !priv->tap_state_valid ||
+		priv->tap_state == TAP_DRSHIFT || priv->tap_state == TAP_IRSHIFT;
+
+	if (tms) {
+		if (++priv->tms_ones >= 5) {
+			/* Five TMS=1 clocks end up in TAP_RESET from any state */
+			priv->tap_state = TAP_RESET;
+			priv->tap_state_valid = true;
+		}
+	} else {
+		priv->tms_ones = 0;
+	}
+	if (priv->tap_state_valid)
+		priv->tap_state = tap_state_transition(priv->tap_state, tms);
+	return tdi_used;
+}
+
 /* Called by bitq interface to output a bit on tdi and perhaps read a bit from tdo */
 static int esp_usb_jtag_out(int tms, int tdi, int tdo_req)
 {
+	/* Outside of Shift-IR/Shift-DR the TDI value does not matter. Take the one of the previous
+	 * clock then, so that state moves and runtest cycles following a scan continue its run
+	 * instead of starting a new one. */
+	if (!esp_usb_jtag_track_tap(tms) && priv->prev_cmd_repct && priv->prev_cmd < CMD_RST(0)) {
+		int prev_tdi = (priv->prev_cmd & BIT(0)) ? 1 : 0;
+		if (prev_tdi != (tdi ? 1 : 0)) {
+			tdi = prev_tdi;
+			priv->stats.tdi_merged++;
+		}
+	}
+
 	int ret = esp_usb_jtag_command_add(CMD_CLK(tdo_req, tdi, tms));
 	if (ret != ERROR_OK)
 		return ret;
-	if (tdo_req)
+	priv->stats.clocks++;
+	if (tdo_req) {
 		priv->pending_in_bits++;
+		priv->stats.captured_bits++;
+	}
 	return ERROR_OK;
 }
 
@@ -561,7 +805,8 @@ static int esp_usb_jtag_flush(void)
 	while (priv->pending_in_bits > 0)
 		esp_usb_jtag_recv_buf();
 
-	return ERROR_OK;
+	/* Everything is expected to be on the adapter by now; check the outcome of the OUT transfers. */
+	return esp_usb_jtag_reap_all_out();
 }
 
 /* Called by bitq interface to sleep for a determined amount of time */
@@ -579,6 +824,11 @@ static int esp_usb_jtag_reset(int trst, int srst)
 {
 	/* TODO: handle trst using setup commands. Kind-of superfluous, however, as we can also do
 	 * a tap reset using tms, and it's also not implemented on other ESP32 chips with external JTAG. */
+	if (trst || srst) {
+		/* The TAP may be reset behind our back */
+		priv->tap_state_valid = false;
+		priv->tms_ones = 0;
+	}
 	return esp_usb_jtag_command_add(CMD_RST(srst));
 }
 
@@ -730,6 +980,13 @@ static int esp_usb_jtag_init(void)
 	/* TODO: grab from (future) descriptor if we ever have a device with larger IN buffers */
 	priv->hw_in_fifo_len = 4;
 
+	r = esp_usb_jtag_alloc_xfers();
+	if (r != ERROR_OK) {
+		LOG_ERROR("esp_usb_jtag: could not set up USB transfers!");
+		goto out;
+	}
+	priv->stats.start_ms = timeval_ms();
+
 	/* inform bridge board about the connected target chip for the specific operations
 	 * it is also safe to send this info to chips that have builtin usb jtag */
 	jtag_libusb_control_transfer(priv->usb_device,
@@ -747,6 +1004,8 @@ static int esp_usb_jtag_init(void)
 out:
 	free((void *)esp_usb_jtag_serial);
 	esp_usb_jtag_serial = NULL;
+	esp_usb_jtag_free_xfers(priv->in_xfer, IN_XFER_CT);
+	esp_usb_jtag_free_xfers(priv->out_xfer, OUT_XFER_CT);
 	if (priv->usb_device)
 		jtag_libusb_close(priv->usb_device);
 	bitq_interface = NULL;
@@ -760,6 +1019,8 @@ static int esp_usb_jtag_quit(void)
 	esp_usb_jtag_serial = NULL;
 	if (!priv->usb_device)
 		return ERROR_OK;
+	esp_usb_jtag_free_xfers(priv->in_xfer, IN_XFER_CT);
+	esp_usb_jtag_free_xfers(priv->out_xfer, OUT_XFER_CT);
 	jtag_libusb_close(priv->usb_device);
 	bitq_cleanup();
 	bitq_interface = NULL;
@@ -955,6 +1216,49 @@ COMMAND_HANDLER(esp_usb_jtag_dev_list)
 	return ERROR_OK;
 }
 
+/* Bytes per ms happens to be the same as kB/s */
+static uint64_t esp_usb_jtag_rate_kbps(uint64_t bytes, int64_t ms)
+{
+	return ms > 0 ? bytes / ms : 0;
+}
+
+COMMAND_HANDLER(esp_usb_jtag_stats_cmd)
+{
+	struct esp_usb_jtag_stats *stats = &priv->stats;
+
+	if (!priv->usb_device)
+		return ERROR_FAIL;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		memset(stats, 0, sizeof(*stats));
+		stats->start_ms = timeval_ms();
+		return ERROR_OK;
+	}
+
+	int64_t elapsed = timeval_ms() - stats->start_ms;
+	command_print(CMD, "elapsed:        %" PRId64 " ms", elapsed);
+	command_print(CMD, "out:            %" PRIu64 " bytes in %u transfers, %" PRIu64 " kB/s",
+		stats->out_bytes, stats->out_xfers, esp_usb_jtag_rate_kbps(stats->out_bytes, elapsed));
+	command_print(CMD, "in:             %" PRIu64 " bytes in %u transfers, %" PRIu64 " kB/s",
+		stats->in_bytes, stats->in_xfers, esp_usb_jtag_rate_kbps(stats->in_bytes, elapsed));
+	command_print(CMD, "tck:            %" PRIu64 " cycles (%" PRIu64 " kB/s), %" PRIu64 " bits captured",
+		stats->clocks, esp_usb_jtag_rate_kbps(stats->clocks / 8, elapsed), stats->captured_bits);
+	command_print(CMD, "out in flight:  %u max of %u, ring full %u times",
+		stats->max_out_inflight, OUT_XFER_CT, stats->out_waits);
+	/* Nibbles per TCK cycle, in thousandths; 1000 means no compression at all */
+	uint64_t milli = stats->clocks ? stats->nibbles * 1000 / stats->clocks : 0;
+	command_print(CMD, "encoding:       %" PRIu64 " nibbles (%" PRIu64 " repeats), %" PRIu64 ".%03" PRIu64
+		" nibbles/bit, %" PRIu64 " don't-care TDI bits merged",
+		stats->nibbles, stats->rep_nibbles, milli / 1000, milli % 1000, stats->tdi_merged);
+
+	return ERROR_OK;
+}
+
 static const struct command_registration esp_usb_jtag_subcommands[] = {
 	{
 		.name = "tdo",
@@ -977,6 +1281,13 @@ static const struct command_registration esp_usb_jtag_subcommands[] = {
 		.help = "Log USB comms to file",
 		.usage = "logfile.txt"
 	},
+	{
+		.name = "stats",
+		.handler = &esp_usb_jtag_stats_cmd,
+		.mode = COMMAND_EXEC,
+		.help = "Show or reset USB transfer statistics",
+		.usage = "['reset']"
+	},
 	{
 		.name = "vid_pid",
 		.handler = &esp_usb_jtag_vid_pid,
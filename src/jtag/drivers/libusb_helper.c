@@ -26,6 +26,9 @@
 static struct libusb_context *jtag_libusb_context; /**< Libusb context **/
 static struct libusb_device **devs; /**< The usb device list **/
 
+struct perf_counter jtag_libusb_out_perf = PERF_COUNTER_INIT("usb.out", "bytes");
+struct perf_counter jtag_libusb_in_perf = PERF_COUNTER_INIT("usb.in", "bytes");
+
 static int jtag_libusb_error(int err)
 {
 	switch (err) {
@@ -329,9 +332,13 @@ int jtag_libusb_control_transfer(struct libusb_device_handle *dev, uint8_t reque
 		uint8_t request, uint16_t value, uint16_t index, char *bytes,
 		uint16_t size, unsigned int timeout, int *transferred)
 {
+	int64_t start = perf_start();
 	int retval = libusb_control_transfer(dev, request_type, request, value, index,
 				(unsigned char *)bytes, size, timeout);
 
+	perf_end(request_type & LIBUSB_ENDPOINT_IN ? &jtag_libusb_in_perf : &jtag_libusb_out_perf,
+		start, retval > 0 ? retval : 0);
+
 	if (retval < 0) {
 		LOG_ERROR("libusb_control_transfer error: %s", libusb_error_name(retval));
 		if (transferred)
@@ -352,8 +359,10 @@ int jtag_libusb_bulk_write(struct libusb_device_handle *dev, int ep, char *bytes
 
 	*transferred = 0;
 
+	int64_t start = perf_start();
 	ret = libusb_bulk_transfer(dev, ep, (unsigned char *)bytes, size,
 				   transferred, timeout);
+	perf_end(&jtag_libusb_out_perf, start, *transferred);
 	if (ret != LIBUSB_SUCCESS) {
 		LOG_ERROR("libusb_bulk_write error: %s", libusb_error_name(ret));
 		return jtag_libusb_error(ret);
@@ -369,8 +378,10 @@ int jtag_libusb_bulk_read(struct libusb_device_handle *dev, int ep, char *bytes,
 
 	*transferred = 0;
 
+	int64_t start = perf_start();
 	ret = libusb_bulk_transfer(dev, ep, (unsigned char *)bytes, size,
 				   transferred, timeout);
+	perf_end(&jtag_libusb_in_perf, start, *transferred);
 	if (ret != LIBUSB_SUCCESS) {
 		LOG_ERROR("libusb_bulk_read error: %s", libusb_error_name(ret));
 		return jtag_libusb_error(ret);
@@ -545,6 +556,16 @@ int jtag_libusb_handle_events_completed(int *completed)
 	return libusb_handle_events_completed(jtag_libusb_context, completed);
 }
 
+int jtag_libusb_handle_events_timeout_completed(unsigned int timeout_ms, int *completed)
+{
+	struct timeval tv = {
+		.tv_sec = timeout_ms / 1000,
+		.tv_usec = (timeout_ms % 1000) * 1000,
+	};
+
+	return libusb_handle_events_timeout_completed(jtag_libusb_context, &tv, completed);
+}
+
 static enum {
 	DEV_MEM_NOT_YET_DECIDED,
 	DEV_MEM_AVAILABLE,
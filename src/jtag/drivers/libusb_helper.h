@@ -10,6 +10,7 @@
 #define OPENOCD_JTAG_DRIVERS_LIBUSB_HELPER_H
 
 #include <libusb.h>
+#include <helper/perf_stats.h>
 
 /* When we debug a target that works as a USB device, halting the target causes the
  * USB communication with the USB host to become unresponsive. The host will try
@@ -25,6 +26,10 @@
  */
 #define LIBUSB_TIMEOUT_MS	(6000)
 
+/* USB transfers to and from the adapter, see 'perf_stats dump usb' */
+extern struct perf_counter jtag_libusb_out_perf;
+extern struct perf_counter jtag_libusb_in_perf;
+
 /* this callback should return a non NULL value only when the serial could not
  * be retrieved by the standard 'libusb_get_string_descriptor_ascii' */
 typedef char * (*adapter_get_alternate_serial_fn)(struct libusb_device_handle *device,
@@ -69,6 +74,7 @@ int jtag_libusb_get_pid(struct libusb_device *dev, uint16_t *pid);
 int jtag_libusb_get_serial(struct libusb_device_handle *devh, const char **serial);
 libusb_device *jtag_libusb_find_device(const uint16_t vids[], const uint16_t pids[], const char *serial);
 int jtag_libusb_handle_events_completed(int *completed);
+int jtag_libusb_handle_events_timeout_completed(unsigned int timeout_ms, int *completed);
 
 /**
  * Attempts to allocate a block of persistent DMA memory suitable for transfers
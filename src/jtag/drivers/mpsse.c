@@ -941,11 +941,14 @@ error_check:
 			ctx->read_count);
 		retval = ERROR_FAIL;
 	} else if (ctx->read_count) {
+		perf_count(&jtag_libusb_out_perf, write_result.transferred);
+		perf_count(&jtag_libusb_in_perf, read_result.transferred);
 		ctx->write_count = 0;
 		ctx->read_count = 0;
 		bit_copy_execute(&ctx->read_queue);
 		retval = ERROR_OK;
 	} else {
+		perf_count(&jtag_libusb_out_perf, write_result.transferred);
 		ctx->write_count = 0;
 		bit_copy_discard(&ctx->read_queue);
 		retval = ERROR_OK;
@@ -0,0 +1,1357 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/***************************************************************************
+ *   In-process RISC-V DTM / Debug Module simulator                        *
+ *   Copyright (C) 2026 Espressif Systems (Shanghai) Co. Ltd.              *
+ ***************************************************************************/
+
+/*
+ * This adapter driver does not talk to any hardware. It simulates a single
+ * JTAG DTM (IDCODE/DTMCS/DMI) in front of a RISC-V Debug Module 0.13 with
+ * dmcontrol/dmstatus, abstract commands (access register, access memory),
+ * a program buffer with implicit ebreak, abstractauto and System Bus Access.
+ * The harts share one RAM which is also visible through SBA.
+ *
+ * Busy behaviour is modelled with latencies counted in Run-Test/Idle cycles:
+ * a DMI operation, an abstract command or a system bus access completes only
+ * after the configured number of idle cycles has elapsed, so the busy/retry
+ * paths of riscv-013.c (dmi busy, cmderr busy, sbbusyerror) are exercised in
+ * the same way as on silicon. Together with the scan and byte counters this
+ * allows comparing scans-per-KB of every memory access method.
+ *
+ * Harts do not execute code while running. Program buffer instructions are
+ * interpreted (loads, stores, addi, CSR accesses, fences, ebreak); a resume
+ * with dcsr.step set completes immediately with dpc += 4.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <jtag/interface.h>
+#include <jtag/commands.h>
+#include <target/riscv/debug_defines.h>
+#include <target/riscv/encoding.h>
+#include <target/riscv/field_helpers.h>
+#include "bitbang.h"
+
+#define RVSIM_MAX_HARTS			4
+#define RVSIM_MAX_MEM_REGIONS	16
+#define RVSIM_DATA_MAX			12
+#define RVSIM_PROGBUF_MAX		16
+#define RVSIM_PROGBUF_MAX_STEPS	64
+
+#define RVSIM_IR_LEN			5
+#define RVSIM_IR_BYPASS			0x1F
+#define RVSIM_DTMCS_LEN			32
+#define RVSIM_DMI_DATA_OFFSET	DTM_DMI_DATA_OFFSET
+#define RVSIM_DMI_ADDR_OFFSET	DTM_DMI_ADDRESS_OFFSET
+#define RVSIM_HARTSEL_MASK		0x3FF
+
+#define RVSIM_DEFAULT_IDCODE	0x10e31913
+#define RVSIM_RESET_PC			0x40000000
+
+#define RVSIM_REGNO_GPR_FIRST	0x1000
+#define RVSIM_REGNO_GPR_LAST	0x101F
+#define RVSIM_REGNO_CSR_LAST	0x0FFF
+
+enum rvsim_latency {
+	RVSIM_LATENCY_DMI,
+	RVSIM_LATENCY_ABSTRACT,
+	RVSIM_LATENCY_SBA,
+	RVSIM_LATENCY_NUM
+};
+
+static const char * const rvsim_latency_names[RVSIM_LATENCY_NUM] = {
+	[RVSIM_LATENCY_DMI] = "dmi",
+	[RVSIM_LATENCY_ABSTRACT] = "abstract",
+	[RVSIM_LATENCY_SBA] = "sba",
+};
+
+struct rvsim_mem_region {
+	uint64_t base;
+	uint32_t size;
+	uint8_t *data;
+};
+
+struct rvsim_hart {
+	uint64_t x[32];
+	uint64_t pc;
+	uint64_t dcsr;
+	uint64_t dpc;
+	uint64_t dscratch[2];
+	uint64_t mstatus;
+	uint64_t mie;
+	uint64_t mtvec;
+	uint64_t mscratch;
+	uint64_t mepc;
+	uint64_t mcause;
+	uint64_t mtval;
+	bool halted;
+	bool resumeack;
+	bool havereset;
+	bool resethaltreq;
+};
+
+struct rvsim_dm {
+	uint32_t dmcontrol;
+	uint32_t data[RVSIM_DATA_MAX];
+	uint32_t progbuf[RVSIM_PROGBUF_MAX];
+	uint32_t command;
+	uint32_t cmderr;
+	uint32_t abstractauto;
+	uint64_t abstract_busy_until;
+	uint32_t sbcs;
+	uint64_t sbaddress;
+	uint64_t sbdata;
+	uint64_t sba_busy_until;
+};
+
+struct rvsim_stats {
+	uint64_t tck;
+	uint64_t idle_cycles;
+	uint64_t ir_scans;
+	uint64_t ir_bits;
+	uint64_t dr_scans;
+	uint64_t dr_bits;
+	uint64_t dtmcs_scans;
+	uint64_t dmi_reads;
+	uint64_t dmi_writes;
+	uint64_t dmi_nops;
+	uint64_t dmi_busy;
+	uint64_t dmi_resets;
+	uint64_t abstract_regs;
+	uint64_t abstract_mems;
+	uint64_t abstract_busy;
+	uint64_t abstract_errors;
+	uint64_t progbuf_runs;
+	uint64_t progbuf_insns;
+	uint64_t sba_reads;
+	uint64_t sba_writes;
+	uint64_t sba_busy;
+	uint64_t mem_read_bytes;
+	uint64_t mem_write_bytes;
+	uint64_t halts;
+	uint64_t resumes;
+	uint64_t steps;
+};
+
+/* configuration */
+static uint32_t rvsim_idcode = RVSIM_DEFAULT_IDCODE;
+static unsigned int rvsim_xlen = 32;
+static unsigned int rvsim_num_harts = 1;
+static unsigned int rvsim_abits = 7;
+static unsigned int rvsim_dtmcs_idle;
+static unsigned int rvsim_datacount = 2;
+static unsigned int rvsim_progbufsize = 2;
+static bool rvsim_sba_enabled = true;
+static unsigned int rvsim_latency[RVSIM_LATENCY_NUM];
+static struct rvsim_mem_region rvsim_mem[RVSIM_MAX_MEM_REGIONS];
+static unsigned int rvsim_mem_num;
+
+/* simulated state */
+static struct rvsim_hart rvsim_harts[RVSIM_MAX_HARTS];
+static struct rvsim_dm rvsim_dm;
+static struct rvsim_stats rvsim_stats;
+
+static enum tap_state rvsim_state = TAP_RESET;
+static int rvsim_tck;
+static int rvsim_tdo;
+static uint8_t rvsim_ir;
+static uint8_t rvsim_ir_shift;
+static uint64_t rvsim_dr_shift;
+static unsigned int rvsim_dr_len;
+
+/* DMI state: result of the last accepted operation and sticky busy flag */
+static uint64_t rvsim_dmi_result;
+static uint64_t rvsim_dmi_busy_until;
+static bool rvsim_dmi_sticky_busy;
+
+static uint64_t rvsim_xmask(void)
+{
+	return rvsim_xlen == 64 ? UINT64_MAX : UINT32_MAX;
+}
+
+static bool rvsim_is_busy(uint64_t busy_until)
+{
+	return rvsim_stats.idle_cycles < busy_until;
+}
+
+static uint64_t rvsim_busy_until(enum rvsim_latency latency)
+{
+	return rvsim_stats.idle_cycles + rvsim_latency[latency];
+}
+
+static uint8_t *rvsim_mem_ptr(uint64_t addr, unsigned int size)
+{
+	for (unsigned int i = 0; i < rvsim_mem_num; i++) {
+		struct rvsim_mem_region *m = &rvsim_mem[i];
+		if (addr >= m->base && addr - m->base + size <= m->size)
+			return &m->data[addr - m->base];
+	}
+	return NULL;
+}
+
+static bool rvsim_mem_read(uint64_t addr, unsigned int size, uint64_t *val)
+{
+	const uint8_t *p = rvsim_mem_ptr(addr, size);
+	if (!p || (addr & (size - 1)))
+		return false;
+	*val = 0;
+	for (unsigned int i = 0; i < size; i++)
+		*val |= (uint64_t)p[i] << (8 * i);
+	rvsim_stats.mem_read_bytes += size;
+	return true;
+}
+
+static bool rvsim_mem_write(uint64_t addr, unsigned int size, uint64_t val)
+{
+	uint8_t *p = rvsim_mem_ptr(addr, size);
+	if (!p || (addr & (size - 1)))
+		return false;
+	for (unsigned int i = 0; i < size; i++)
+		p[i] = val >> (8 * i);
+	rvsim_stats.mem_write_bytes += size;
+	return true;
+}
+
+static unsigned int rvsim_hartsel(void)
+{
+	return get_field(rvsim_dm.dmcontrol, DM_DMCONTROL_HARTSELLO) & RVSIM_HARTSEL_MASK;
+}
+
+static struct rvsim_hart *rvsim_selected_hart(void)
+{
+	unsigned int hartsel = rvsim_hartsel();
+	return hartsel < rvsim_num_harts ? &rvsim_harts[hartsel] : NULL;
+}
+
+static void rvsim_hart_halt(struct rvsim_hart *hart, unsigned int cause)
+{
+	hart->dpc = hart->pc;
+	hart->dcsr = set_field(hart->dcsr, CSR_DCSR_CAUSE, cause);
+	hart->halted = true;
+	rvsim_stats.halts++;
+}
+
+static void rvsim_hart_resume(struct rvsim_hart *hart)
+{
+	hart->resumeack = true;
+	if (get_field(hart->dcsr, CSR_DCSR_STEP)) {
+		/* Pretend one 32-bit instruction was executed */
+		hart->pc = (hart->dpc + 4) & rvsim_xmask();
+		rvsim_stats.steps++;
+		rvsim_hart_halt(hart, CSR_DCSR_CAUSE_STEP);
+		return;
+	}
+	hart->pc = hart->dpc;
+	hart->halted = false;
+	rvsim_stats.resumes++;
+}
+
+static void rvsim_hart_reset(struct rvsim_hart *hart)
+{
+	bool resethaltreq = hart->resethaltreq;
+
+	memset(hart, 0, sizeof(*hart));
+	hart->pc = RVSIM_RESET_PC;
+	hart->dcsr = field_value(CSR_DCSR_DEBUGVER, 4) | field_value(CSR_DCSR_PRV, PRV_M);
+	hart->havereset = true;
+	hart->resethaltreq = resethaltreq;
+	if (resethaltreq)
+		rvsim_hart_halt(hart, CSR_DCSR_CAUSE_RESETHALTREQ);
+}
+
+static uint64_t rvsim_misa(void)
+{
+	uint64_t ext = BIT('I' - 'A') | BIT('M' - 'A') | BIT('A' - 'A') | BIT('C' - 'A');
+	if (rvsim_xlen == 64)
+		return (2ULL << 62) | ext;
+	return (1ULL << 30) | ext;
+}
+
+static uint64_t *rvsim_csr_ptr(struct rvsim_hart *hart, unsigned int csr)
+{
+	switch (csr) {
+	case CSR_MSTATUS:
+		return &hart->mstatus;
+	case CSR_MIE:
+		return &hart->mie;
+	case CSR_MTVEC:
+		return &hart->mtvec;
+	case CSR_MSCRATCH:
+		return &hart->mscratch;
+	case CSR_MEPC:
+		return &hart->mepc;
+	case CSR_MCAUSE:
+		return &hart->mcause;
+	case CSR_MTVAL:
+		return &hart->mtval;
+	case CSR_DCSR:
+		return &hart->dcsr;
+	case CSR_DPC:
+		return &hart->dpc;
+	case CSR_DSCRATCH0:
+		return &hart->dscratch[0];
+	case CSR_DSCRATCH1:
+		return &hart->dscratch[1];
+	default:
+		return NULL;
+	}
+}
+
+static bool rvsim_csr_read(struct rvsim_hart *hart, unsigned int csr, uint64_t *val)
+{
+	uint64_t *p = rvsim_csr_ptr(hart, csr);
+	if (p) {
+		*val = *p;
+		return true;
+	}
+	switch (csr) {
+	case CSR_MISA:
+		*val = rvsim_misa();
+		return true;
+	case CSR_MIP:
+	case CSR_MVENDORID:
+	case CSR_MARCHID:
+	case CSR_MIMPID:
+		*val = 0;
+		return true;
+	case CSR_MHARTID:
+		*val = hart - rvsim_harts;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool rvsim_csr_write(struct rvsim_hart *hart, unsigned int csr, uint64_t val)
+{
+	uint64_t *p = rvsim_csr_ptr(hart, csr);
+	if (p) {
+		if (csr == CSR_DCSR) {
+			/* debugver and cause are read-only */
+			const uint64_t ro = CSR_DCSR_DEBUGVER | CSR_DCSR_CAUSE;
+			val = (hart->dcsr & ro) | (val & ~ro);
+		}
+		*p = val & rvsim_xmask();
+		return true;
+	}
+	/* misa and mip are WARL with no writable bits here, the IDs are read-only */
+	return csr == CSR_MISA || csr == CSR_MIP;
+}
+
+static uint64_t rvsim_sext(uint64_t val, unsigned int bits)
+{
+	if (bits >= 64)
+		return val;
+	uint64_t sign = 1ULL << (bits - 1);
+	val &= (sign << 1) - 1;
+	return (val ^ sign) - sign;
+}
+
+/* Execute a single program buffer instruction. Returns false on exception. */
+static bool rvsim_exec_insn(struct rvsim_hart *hart, uint32_t insn, bool *ebreak)
+{
+	unsigned int rd = (insn >> 7) & 0x1F;
+	unsigned int rs1 = (insn >> 15) & 0x1F;
+	unsigned int rs2 = (insn >> 20) & 0x1F;
+	unsigned int csr = insn >> 20;
+	int64_t imm_i = (int32_t)insn >> 20;
+	int64_t imm_s = ((int32_t)insn >> 25 << 5) | ((insn >> 7) & 0x1F);
+	uint64_t addr_i = (hart->x[rs1] + imm_i) & rvsim_xmask();
+	uint64_t addr_s = (hart->x[rs1] + imm_s) & rvsim_xmask();
+	uint64_t result = 0;
+	bool write_rd = false;
+	bool ok = true;
+
+	rvsim_stats.progbuf_insns++;
+
+	if (insn == MATCH_EBREAK) {
+		*ebreak = true;
+		return true;
+	}
+	if ((insn & MASK_FENCE) == MATCH_FENCE || (insn & MASK_FENCE) == MATCH_FENCE_I)
+		return true;
+
+	switch (insn & MASK_LB) {
+	case MATCH_LB:
+		ok = rvsim_mem_read(addr_i, 1, &result);
+		result = rvsim_sext(result, 8);
+		write_rd = true;
+		break;
+	case MATCH_LH:
+		ok = rvsim_mem_read(addr_i, 2, &result);
+		result = rvsim_sext(result, 16);
+		write_rd = true;
+		break;
+	case MATCH_LW:
+		ok = rvsim_mem_read(addr_i, 4, &result);
+		result = rvsim_sext(result, 32);
+		write_rd = true;
+		break;
+	case MATCH_LBU:
+		ok = rvsim_mem_read(addr_i, 1, &result);
+		write_rd = true;
+		break;
+	case MATCH_LHU:
+		ok = rvsim_mem_read(addr_i, 2, &result);
+		write_rd = true;
+		break;
+	case MATCH_LWU:
+		ok = rvsim_xlen == 64 && rvsim_mem_read(addr_i, 4, &result);
+		write_rd = true;
+		break;
+	case MATCH_LD:
+		ok = rvsim_xlen == 64 && rvsim_mem_read(addr_i, 8, &result);
+		write_rd = true;
+		break;
+	case MATCH_SB:
+		ok = rvsim_mem_write(addr_s, 1, hart->x[rs2]);
+		break;
+	case MATCH_SH:
+		ok = rvsim_mem_write(addr_s, 2, hart->x[rs2]);
+		break;
+	case MATCH_SW:
+		ok = rvsim_mem_write(addr_s, 4, hart->x[rs2]);
+		break;
+	case MATCH_SD:
+		ok = rvsim_xlen == 64 && rvsim_mem_write(addr_s, 8, hart->x[rs2]);
+		break;
+	case MATCH_ADDI:
+		result = hart->x[rs1] + imm_i;
+		write_rd = true;
+		break;
+	case MATCH_CSRRW:
+	case MATCH_CSRRS:
+	case MATCH_CSRRC:
+	case MATCH_CSRRWI:
+	case MATCH_CSRRSI:
+	case MATCH_CSRRCI: {
+		uint32_t op = insn & MASK_CSRRW;
+		uint64_t src = (op == MATCH_CSRRWI || op == MATCH_CSRRSI || op == MATCH_CSRRCI) ?
+			rs1 : hart->x[rs1];
+		uint64_t old = 0;
+		bool is_write = op == MATCH_CSRRW || op == MATCH_CSRRWI;
+		if (!is_write || rd != 0)
+			ok = rvsim_csr_read(hart, csr, &old);
+		if (ok && (is_write || rs1 != 0)) {
+			uint64_t new_val = src;
+			if (op == MATCH_CSRRS || op == MATCH_CSRRSI)
+				new_val = old | src;
+			else if (op == MATCH_CSRRC || op == MATCH_CSRRCI)
+				new_val = old & ~src;
+			ok = rvsim_csr_write(hart, csr, new_val);
+		}
+		result = old;
+		write_rd = true;
+		break;
+	}
+	default:
+		LOG_DEBUG("riscv_sim: unsupported instruction 0x%08" PRIx32, insn);
+		ok = false;
+		break;
+	}
+
+	if (ok && write_rd && rd != 0)
+		hart->x[rd] = result & rvsim_xmask();
+	return ok;
+}
+
+static uint32_t rvsim_exec_progbuf(struct rvsim_hart *hart)
+{
+	rvsim_stats.progbuf_runs++;
+	for (unsigned int i = 0, steps = 0; steps < RVSIM_PROGBUF_MAX_STEPS; i++, steps++) {
+		bool ebreak = false;
+		/* impebreak: an ebreak follows the last program buffer word */
+		if (i >= rvsim_progbufsize)
+			return DM_ABSTRACTCS_CMDERR_NONE;
+		if (!rvsim_exec_insn(hart, rvsim_dm.progbuf[i], &ebreak))
+			return DM_ABSTRACTCS_CMDERR_EXCEPTION;
+		if (ebreak)
+			return DM_ABSTRACTCS_CMDERR_NONE;
+	}
+	return DM_ABSTRACTCS_CMDERR_EXCEPTION;
+}
+
+static uint64_t rvsim_data_get(unsigned int index, unsigned int bits)
+{
+	uint64_t val = rvsim_dm.data[index];
+	if (bits > 32 && index + 1 < RVSIM_DATA_MAX)
+		val |= (uint64_t)rvsim_dm.data[index + 1] << 32;
+	return val;
+}
+
+static void rvsim_data_set(unsigned int index, unsigned int bits, uint64_t val)
+{
+	rvsim_dm.data[index] = val;
+	if (bits > 32 && index + 1 < RVSIM_DATA_MAX)
+		rvsim_dm.data[index + 1] = val >> 32;
+}
+
+static uint32_t rvsim_access_register(uint32_t command)
+{
+	struct rvsim_hart *hart = rvsim_selected_hart();
+	unsigned int bits = 8 << get_field(command, AC_ACCESS_REGISTER_AARSIZE);
+	unsigned int regno = get_field(command, AC_ACCESS_REGISTER_REGNO);
+	uint32_t cmderr = DM_ABSTRACTCS_CMDERR_NONE;
+
+	rvsim_stats.abstract_regs++;
+	if (!hart || !hart->halted)
+		return DM_ABSTRACTCS_CMDERR_HALT_RESUME;
+
+	if (get_field(command, AC_ACCESS_REGISTER_TRANSFER)) {
+		if (bits > rvsim_xlen || bits < 32)
+			return DM_ABSTRACTCS_CMDERR_NOT_SUPPORTED;
+		bool write = get_field(command, AC_ACCESS_REGISTER_WRITE);
+		uint64_t val = rvsim_data_get(0, bits);
+		bool ok = true;
+		if (regno >= RVSIM_REGNO_GPR_FIRST && regno <= RVSIM_REGNO_GPR_LAST) {
+			unsigned int r = regno - RVSIM_REGNO_GPR_FIRST;
+			if (write) {
+				if (r != 0)
+					hart->x[r] = val & rvsim_xmask();
+			} else {
+				val = hart->x[r];
+			}
+		} else if (regno <= RVSIM_REGNO_CSR_LAST) {
+			if (write)
+				ok = rvsim_csr_write(hart, regno, val);
+			else
+				ok = rvsim_csr_read(hart, regno, &val);
+		} else {
+			/* no FPRs or custom registers */
+			ok = false;
+		}
+		if (!ok)
+			return DM_ABSTRACTCS_CMDERR_EXCEPTION;
+		if (!write)
+			rvsim_data_set(0, bits, val);
+	}
+
+	if (get_field(command, AC_ACCESS_REGISTER_POSTEXEC))
+		cmderr = rvsim_exec_progbuf(hart);
+
+	if (get_field(command, AC_ACCESS_REGISTER_AARPOSTINCREMENT))
+		rvsim_dm.command = set_field(command, AC_ACCESS_REGISTER_REGNO, (regno + 1) & 0xFFFF);
+	return cmderr;
+}
+
+static uint32_t rvsim_access_memory(uint32_t command)
+{
+	unsigned int size = 1 << get_field(command, AC_ACCESS_MEMORY_AAMSIZE);
+	/* arg0 is in data0 (data0-1 for XLEN=64), arg1 follows it */
+	unsigned int arg1 = rvsim_xlen / 32;
+	uint64_t addr = rvsim_data_get(arg1, rvsim_xlen);
+	uint64_t val = 0;
+	bool ok;
+
+	rvsim_stats.abstract_mems++;
+	if (size * 8 > rvsim_xlen)
+		return DM_ABSTRACTCS_CMDERR_NOT_SUPPORTED;
+	if (get_field(command, AC_ACCESS_MEMORY_WRITE)) {
+		ok = rvsim_mem_write(addr, size, rvsim_data_get(0, size * 8));
+	} else {
+		ok = rvsim_mem_read(addr, size, &val);
+		if (ok)
+			rvsim_data_set(0, size * 8, val);
+	}
+	if (!ok)
+		return DM_ABSTRACTCS_CMDERR_BUS;
+	if (get_field(command, AC_ACCESS_MEMORY_AAMPOSTINCREMENT))
+		rvsim_data_set(arg1, rvsim_xlen, (addr + size) & rvsim_xmask());
+	return DM_ABSTRACTCS_CMDERR_NONE;
+}
+
+static void rvsim_exec_command(void)
+{
+	uint32_t command = rvsim_dm.command;
+	uint32_t cmderr;
+
+	switch (get_field(command, AC_ACCESS_REGISTER_CMDTYPE)) {
+	case 0:
+		cmderr = rvsim_access_register(command);
+		break;
+	case 2:
+		cmderr = rvsim_access_memory(command);
+		break;
+	default:
+		cmderr = DM_ABSTRACTCS_CMDERR_NOT_SUPPORTED;
+		break;
+	}
+	if (cmderr != DM_ABSTRACTCS_CMDERR_NONE) {
+		rvsim_stats.abstract_errors++;
+		rvsim_dm.cmderr = cmderr;
+	}
+	rvsim_dm.abstract_busy_until = rvsim_busy_until(RVSIM_LATENCY_ABSTRACT);
+}
+
+/* Accesses to abstract command registers while a command runs fail with cmderr=busy */
+static bool rvsim_abstract_check_busy(void)
+{
+	if (!rvsim_is_busy(rvsim_dm.abstract_busy_until))
+		return false;
+	if (rvsim_dm.cmderr == DM_ABSTRACTCS_CMDERR_NONE)
+		rvsim_dm.cmderr = DM_ABSTRACTCS_CMDERR_BUSY;
+	rvsim_stats.abstract_busy++;
+	return true;
+}
+
+static void rvsim_autoexec(uint32_t mask)
+{
+	if ((rvsim_dm.abstractauto & mask) && rvsim_dm.cmderr == DM_ABSTRACTCS_CMDERR_NONE)
+		rvsim_exec_command();
+}
+
+static unsigned int rvsim_sba_size(void)
+{
+	return 1 << get_field(rvsim_dm.sbcs, DM_SBCS_SBACCESS);
+}
+
+static bool rvsim_sba_can_start(void)
+{
+	if (rvsim_is_busy(rvsim_dm.sba_busy_until)) {
+		rvsim_dm.sbcs |= DM_SBCS_SBBUSYERROR;
+		rvsim_stats.sba_busy++;
+		return false;
+	}
+	return !(rvsim_dm.sbcs & (DM_SBCS_SBBUSYERROR | DM_SBCS_SBERROR));
+}
+
+static void rvsim_sba_access(bool write)
+{
+	unsigned int size = rvsim_sba_size();
+	uint32_t sberror = DM_SBCS_SBERROR_NONE;
+	bool ok;
+
+	if (size * 8 > rvsim_xlen) {
+		sberror = DM_SBCS_SBERROR_SIZE;
+	} else if (rvsim_dm.sbaddress & (size - 1)) {
+		sberror = DM_SBCS_SBERROR_ALIGNMENT;
+	} else {
+		if (write) {
+			rvsim_stats.sba_writes++;
+			ok = rvsim_mem_write(rvsim_dm.sbaddress, size, rvsim_dm.sbdata);
+		} else {
+			rvsim_stats.sba_reads++;
+			ok = rvsim_mem_read(rvsim_dm.sbaddress, size, &rvsim_dm.sbdata);
+		}
+		if (!ok)
+			sberror = DM_SBCS_SBERROR_ADDRESS;
+	}
+	if (sberror != DM_SBCS_SBERROR_NONE) {
+		rvsim_dm.sbcs = set_field(rvsim_dm.sbcs, DM_SBCS_SBERROR, sberror);
+		return;
+	}
+	if (get_field(rvsim_dm.sbcs, DM_SBCS_SBAUTOINCREMENT))
+		rvsim_dm.sbaddress = (rvsim_dm.sbaddress + size) & rvsim_xmask();
+	rvsim_dm.sba_busy_until = rvsim_busy_until(RVSIM_LATENCY_SBA);
+}
+
+static uint32_t rvsim_dmstatus(void)
+{
+	uint32_t dmstatus = field_value32(DM_DMSTATUS_VERSION, DM_DMSTATUS_VERSION_0_13) |
+		DM_DMSTATUS_AUTHENTICATED | DM_DMSTATUS_HASRESETHALTREQ;
+	struct rvsim_hart *hart = rvsim_selected_hart();
+
+	if (rvsim_progbufsize < RVSIM_PROGBUF_MAX)
+		dmstatus |= DM_DMSTATUS_IMPEBREAK;
+	if (!hart)
+		return dmstatus | DM_DMSTATUS_ANYNONEXISTENT | DM_DMSTATUS_ALLNONEXISTENT;
+	if (hart->halted)
+		dmstatus |= DM_DMSTATUS_ANYHALTED | DM_DMSTATUS_ALLHALTED;
+	else
+		dmstatus |= DM_DMSTATUS_ANYRUNNING | DM_DMSTATUS_ALLRUNNING;
+	if (hart->resumeack)
+		dmstatus |= DM_DMSTATUS_ANYRESUMEACK | DM_DMSTATUS_ALLRESUMEACK;
+	if (hart->havereset)
+		dmstatus |= DM_DMSTATUS_ANYHAVERESET | DM_DMSTATUS_ALLHAVERESET;
+	return dmstatus;
+}
+
+static uint32_t rvsim_sbcs(void)
+{
+	if (!rvsim_sba_enabled)
+		return 0;
+	uint32_t sbcs = rvsim_dm.sbcs | field_value32(DM_SBCS_SBVERSION, DM_SBCS_SBVERSION_1_0) |
+		field_value32(DM_SBCS_SBASIZE, rvsim_xlen) |
+		DM_SBCS_SBACCESS8 | DM_SBCS_SBACCESS16 | DM_SBCS_SBACCESS32;
+	if (rvsim_xlen == 64)
+		sbcs |= DM_SBCS_SBACCESS64;
+	if (rvsim_is_busy(rvsim_dm.sba_busy_until))
+		sbcs |= DM_SBCS_SBBUSY;
+	return sbcs;
+}
+
+static void rvsim_dm_reset(void)
+{
+	memset(&rvsim_dm, 0, sizeof(rvsim_dm));
+	rvsim_dm.sbcs = field_value32(DM_SBCS_SBACCESS, DM_SBCS_SBACCESS_32BIT);
+}
+
+static uint32_t rvsim_dm_read(unsigned int addr)
+{
+	uint32_t val = 0;
+
+	if (addr != DM_DMCONTROL && !get_field(rvsim_dm.dmcontrol, DM_DMCONTROL_DMACTIVE))
+		return 0;
+
+	if (addr >= DM_DATA0 && addr < DM_DATA0 + rvsim_datacount) {
+		unsigned int i = addr - DM_DATA0;
+		val = rvsim_dm.data[i];
+		if (!rvsim_abstract_check_busy())
+			rvsim_autoexec(field_value32(DM_ABSTRACTAUTO_AUTOEXECDATA, BIT(i)));
+		return val;
+	}
+	if (addr >= DM_PROGBUF0 && addr < DM_PROGBUF0 + rvsim_progbufsize) {
+		unsigned int i = addr - DM_PROGBUF0;
+		val = rvsim_dm.progbuf[i];
+		if (!rvsim_abstract_check_busy())
+			rvsim_autoexec(field_value32(DM_ABSTRACTAUTO_AUTOEXECPROGBUF, BIT(i)));
+		return val;
+	}
+
+	switch (addr) {
+	case DM_DMCONTROL:
+		return rvsim_dm.dmcontrol & (DM_DMCONTROL_HARTSELLO | DM_DMCONTROL_NDMRESET |
+				DM_DMCONTROL_DMACTIVE);
+	case DM_DMSTATUS:
+		return rvsim_dmstatus();
+	case DM_HARTINFO:
+		return field_value32(DM_HARTINFO_NSCRATCH, 2);
+	case DM_ABSTRACTCS:
+		val = field_value32(DM_ABSTRACTCS_PROGBUFSIZE, rvsim_progbufsize) |
+			field_value32(DM_ABSTRACTCS_DATACOUNT, rvsim_datacount) |
+			field_value32(DM_ABSTRACTCS_CMDERR, rvsim_dm.cmderr);
+		if (rvsim_is_busy(rvsim_dm.abstract_busy_until))
+			val |= DM_ABSTRACTCS_BUSY;
+		return val;
+	case DM_COMMAND:
+		return 0;
+	case DM_ABSTRACTAUTO:
+		return rvsim_dm.abstractauto;
+	case DM_HALTSUM0:
+		for (unsigned int i = 0; i < rvsim_num_harts; i++)
+			if (rvsim_harts[i].halted)
+				val |= BIT(i);
+		return val;
+	case DM_HALTSUM1:
+		/* bit 0 summarizes harts 0..31 */
+		return rvsim_dm_read(DM_HALTSUM0) ? BIT(0) : 0;
+	case DM_SBCS:
+		return rvsim_sbcs();
+	case DM_SBADDRESS0:
+		return rvsim_sba_enabled ? (uint32_t)rvsim_dm.sbaddress : 0;
+	case DM_SBADDRESS1:
+		return rvsim_sba_enabled && rvsim_xlen == 64 ? rvsim_dm.sbaddress >> 32 : 0;
+	case DM_SBDATA0:
+		if (!rvsim_sba_enabled)
+			return 0;
+		val = rvsim_dm.sbdata;
+		if (rvsim_sba_can_start() && get_field(rvsim_dm.sbcs, DM_SBCS_SBREADONDATA))
+			rvsim_sba_access(false);
+		return val;
+	case DM_SBDATA1:
+		return rvsim_sba_enabled && rvsim_xlen == 64 ? rvsim_dm.sbdata >> 32 : 0;
+	default:
+		/* nextdm, dmcs2, authdata, confstrptr etc. read as zero */
+		return 0;
+	}
+}
+
+static void rvsim_dmcontrol_write(uint32_t val)
+{
+	bool was_ndmreset = get_field(rvsim_dm.dmcontrol, DM_DMCONTROL_NDMRESET);
+
+	if (!get_field(val, DM_DMCONTROL_DMACTIVE)) {
+		rvsim_dm_reset();
+		return;
+	}
+	/* hasel and hartselhi are not implemented */
+	rvsim_dm.dmcontrol = val & (DM_DMCONTROL_HARTSELLO | DM_DMCONTROL_NDMRESET |
+			DM_DMCONTROL_DMACTIVE);
+	rvsim_dm.dmcontrol = set_field(rvsim_dm.dmcontrol, DM_DMCONTROL_HARTSELLO,
+			get_field(val, DM_DMCONTROL_HARTSELLO) & RVSIM_HARTSEL_MASK);
+
+	if (get_field(val, DM_DMCONTROL_NDMRESET)) {
+		for (unsigned int i = 0; i < rvsim_num_harts; i++)
+			rvsim_hart_reset(&rvsim_harts[i]);
+		return;
+	} else if (was_ndmreset) {
+		/* harts leave reset now; resethaltreq was handled by rvsim_hart_reset() */
+		LOG_DEBUG("riscv_sim: ndmreset released");
+	}
+
+	struct rvsim_hart *hart = rvsim_selected_hart();
+	if (!hart)
+		return;
+	if (get_field(val, DM_DMCONTROL_HARTRESET))
+		rvsim_hart_reset(hart);
+	if (get_field(val, DM_DMCONTROL_ACKHAVERESET))
+		hart->havereset = false;
+	if (get_field(val, DM_DMCONTROL_SETRESETHALTREQ))
+		hart->resethaltreq = true;
+	if (get_field(val, DM_DMCONTROL_CLRRESETHALTREQ))
+		hart->resethaltreq = false;
+	if (get_field(val, DM_DMCONTROL_HALTREQ)) {
+		if (!hart->halted)
+			rvsim_hart_halt(hart, CSR_DCSR_CAUSE_HALTREQ);
+	} else if (get_field(val, DM_DMCONTROL_RESUMEREQ)) {
+		hart->resumeack = false;
+		if (hart->halted)
+			rvsim_hart_resume(hart);
+	}
+}
+
+static void rvsim_dm_write(unsigned int addr, uint32_t val)
+{
+	if (addr == DM_DMCONTROL) {
+		rvsim_dmcontrol_write(val);
+		return;
+	}
+	if (!get_field(rvsim_dm.dmcontrol, DM_DMCONTROL_DMACTIVE))
+		return;
+
+	if (addr >= DM_DATA0 && addr < DM_DATA0 + rvsim_datacount) {
+		unsigned int i = addr - DM_DATA0;
+		if (rvsim_abstract_check_busy())
+			return;
+		rvsim_dm.data[i] = val;
+		rvsim_autoexec(field_value32(DM_ABSTRACTAUTO_AUTOEXECDATA, BIT(i)));
+		return;
+	}
+	if (addr >= DM_PROGBUF0 && addr < DM_PROGBUF0 + rvsim_progbufsize) {
+		unsigned int i = addr - DM_PROGBUF0;
+		if (rvsim_abstract_check_busy())
+			return;
+		rvsim_dm.progbuf[i] = val;
+		rvsim_autoexec(field_value32(DM_ABSTRACTAUTO_AUTOEXECPROGBUF, BIT(i)));
+		return;
+	}
+
+	switch (addr) {
+	case DM_ABSTRACTCS:
+		if (rvsim_abstract_check_busy())
+			return;
+		/* cmderr is write-1-to-clear */
+		rvsim_dm.cmderr &= ~get_field(val, DM_ABSTRACTCS_CMDERR);
+		break;
+	case DM_COMMAND:
+		if (rvsim_abstract_check_busy())
+			return;
+		if (rvsim_dm.cmderr != DM_ABSTRACTCS_CMDERR_NONE)
+			return;
+		rvsim_dm.command = val;
+		rvsim_exec_command();
+		break;
+	case DM_ABSTRACTAUTO:
+		if (rvsim_abstract_check_busy())
+			return;
+		rvsim_dm.abstractauto = val & (DM_ABSTRACTAUTO_AUTOEXECPROGBUF |
+				DM_ABSTRACTAUTO_AUTOEXECDATA);
+		break;
+	case DM_SBCS: {
+		if (!rvsim_sba_enabled)
+			break;
+		const uint32_t rw = DM_SBCS_SBREADONADDR | DM_SBCS_SBACCESS |
+			DM_SBCS_SBAUTOINCREMENT | DM_SBCS_SBREADONDATA;
+		uint32_t sbcs = (rvsim_dm.sbcs & ~rw) | (val & rw);
+		if (val & DM_SBCS_SBBUSYERROR)
+			sbcs &= ~DM_SBCS_SBBUSYERROR;
+		sbcs &= ~(val & DM_SBCS_SBERROR);
+		rvsim_dm.sbcs = sbcs;
+		break;
+	}
+	case DM_SBADDRESS0:
+		if (!rvsim_sba_enabled || !rvsim_sba_can_start())
+			break;
+		rvsim_dm.sbaddress = (rvsim_dm.sbaddress & ~0xFFFFFFFFULL) | val;
+		if (get_field(rvsim_dm.sbcs, DM_SBCS_SBREADONADDR))
+			rvsim_sba_access(false);
+		break;
+	case DM_SBADDRESS1:
+		if (!rvsim_sba_enabled || rvsim_xlen != 64 || !rvsim_sba_can_start())
+			break;
+		rvsim_dm.sbaddress = (rvsim_dm.sbaddress & 0xFFFFFFFFULL) | ((uint64_t)val << 32);
+		break;
+	case DM_SBDATA0:
+		if (!rvsim_sba_enabled || !rvsim_sba_can_start())
+			break;
+		rvsim_dm.sbdata = (rvsim_dm.sbdata & ~0xFFFFFFFFULL) | val;
+		rvsim_sba_access(true);
+		break;
+	case DM_SBDATA1:
+		if (!rvsim_sba_enabled || rvsim_xlen != 64 || !rvsim_sba_can_start())
+			break;
+		rvsim_dm.sbdata = (rvsim_dm.sbdata & 0xFFFFFFFFULL) | ((uint64_t)val << 32);
+		break;
+	default:
+		break;
+	}
+}
+
+static uint32_t rvsim_dtmcs(void)
+{
+	return field_value32(DTM_DTMCS_VERSION, DTM_DTMCS_VERSION_1_0) |
+		field_value32(DTM_DTMCS_ABITS, rvsim_abits) |
+		field_value32(DTM_DTMCS_IDLE, rvsim_dtmcs_idle) |
+		field_value32(DTM_DTMCS_DMISTAT, rvsim_dmi_sticky_busy ? DTM_DMI_OP_BUSY : 0);
+}
+
+static void rvsim_capture_dr(void)
+{
+	switch (rvsim_ir) {
+	case DTM_IDCODE:
+		rvsim_dr_len = 32;
+		rvsim_dr_shift = rvsim_idcode;
+		break;
+	case DTM_DTMCS:
+		rvsim_dr_len = RVSIM_DTMCS_LEN;
+		rvsim_dr_shift = rvsim_dtmcs();
+		break;
+	case DTM_DMI:
+		rvsim_dr_len = RVSIM_DMI_ADDR_OFFSET + rvsim_abits;
+		if (!rvsim_dmi_sticky_busy && rvsim_is_busy(rvsim_dmi_busy_until)) {
+			/* previous operation still in progress, this scan will be ignored */
+			rvsim_dmi_sticky_busy = true;
+			rvsim_stats.dmi_busy++;
+		}
+		if (rvsim_dmi_sticky_busy)
+			rvsim_dr_shift = (rvsim_dmi_result & ~(uint64_t)DTM_DMI_OP) | DTM_DMI_OP_BUSY;
+		else
+			rvsim_dr_shift = rvsim_dmi_result;
+		break;
+	default:
+		rvsim_dr_len = 1;
+		rvsim_dr_shift = 0;
+		break;
+	}
+}
+
+static void rvsim_update_dr(void)
+{
+	uint64_t dr = rvsim_dr_shift;
+
+	switch (rvsim_ir) {
+	case DTM_DTMCS:
+		rvsim_stats.dtmcs_scans++;
+		if (dr & (DTM_DTMCS_DMIRESET | DTM_DTMCS_DTMHARDRESET)) {
+			rvsim_dmi_sticky_busy = false;
+			rvsim_stats.dmi_resets++;
+		}
+		break;
+	case DTM_DMI: {
+		if (rvsim_dmi_sticky_busy)
+			break;
+		unsigned int op = get_field(dr, DTM_DMI_OP);
+		unsigned int addr = (dr >> RVSIM_DMI_ADDR_OFFSET) & ((1U << rvsim_abits) - 1);
+		uint32_t data = (dr >> RVSIM_DMI_DATA_OFFSET) & 0xFFFFFFFF;
+		if (op == DTM_DMI_OP_READ) {
+			rvsim_stats.dmi_reads++;
+			data = rvsim_dm_read(addr);
+		} else if (op == DTM_DMI_OP_WRITE) {
+			rvsim_stats.dmi_writes++;
+			rvsim_dm_write(addr, data);
+		} else {
+			rvsim_stats.dmi_nops++;
+			break;
+		}
+		rvsim_dmi_result = ((uint64_t)addr << RVSIM_DMI_ADDR_OFFSET) |
+			((uint64_t)data << RVSIM_DMI_DATA_OFFSET) | DTM_DMI_OP_SUCCESS;
+		rvsim_dmi_busy_until = rvsim_busy_until(RVSIM_LATENCY_DMI);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void rvsim_clock(int tms, int tdi)
+{
+	enum tap_state state = rvsim_state;
+
+	rvsim_stats.tck++;
+
+	/* Actions are taken on the rising edge, based on the state being left */
+	switch (state) {
+	case TAP_RESET:
+		rvsim_ir = DTM_IDCODE;
+		break;
+	case TAP_IDLE:
+		rvsim_stats.idle_cycles++;
+		break;
+	case TAP_DRCAPTURE:
+		rvsim_capture_dr();
+		break;
+	case TAP_IRCAPTURE:
+		rvsim_ir_shift = 0x01;
+		break;
+	case TAP_DRSHIFT:
+		rvsim_stats.dr_bits++;
+		rvsim_dr_shift = (rvsim_dr_shift >> 1) | ((uint64_t)tdi << (rvsim_dr_len - 1));
+		break;
+	case TAP_IRSHIFT:
+		rvsim_stats.ir_bits++;
+		rvsim_ir_shift = (rvsim_ir_shift >> 1) | (tdi << (RVSIM_IR_LEN - 1));
+		break;
+	default:
+		break;
+	}
+
+	rvsim_state = tap_state_transition(state, tms);
+
+	if (rvsim_state == state)
+		return;
+	if (rvsim_state == TAP_DRUPDATE) {
+		rvsim_stats.dr_scans++;
+		rvsim_update_dr();
+	} else if (rvsim_state == TAP_IRUPDATE) {
+		rvsim_stats.ir_scans++;
+		rvsim_ir = rvsim_ir_shift;
+	}
+}
+
+static enum bb_value rvsim_read(void)
+{
+	return rvsim_tdo ? BB_HIGH : BB_LOW;
+}
+
+static int rvsim_write(int tck, int tms, int tdi)
+{
+	if (tck != rvsim_tck) {
+		if (tck)
+			rvsim_clock(tms, tdi);
+		rvsim_tck = tck;
+	}
+	if (rvsim_state == TAP_DRSHIFT)
+		rvsim_tdo = rvsim_dr_shift & 1;
+	else if (rvsim_state == TAP_IRSHIFT)
+		rvsim_tdo = rvsim_ir_shift & 1;
+	else
+		rvsim_tdo = 0;
+	return ERROR_OK;
+}
+
+static int rvsim_reset(int trst, int srst)
+{
+	if (trst || (srst && (jtag_get_reset_config() & RESET_SRST_PULLS_TRST)))
+		rvsim_state = TAP_RESET;
+	if (srst) {
+		for (unsigned int i = 0; i < rvsim_num_harts; i++)
+			rvsim_hart_reset(&rvsim_harts[i]);
+	}
+	return ERROR_OK;
+}
+
+static const struct bitbang_interface rvsim_bitbang = {
+	.read = &rvsim_read,
+	.write = &rvsim_write,
+};
+
+static int rvsim_khz(int khz, int *jtag_speed)
+{
+	*jtag_speed = khz;
+	return ERROR_OK;
+}
+
+static int rvsim_speed_div(int speed, int *khz)
+{
+	*khz = speed;
+	return ERROR_OK;
+}
+
+static int rvsim_speed(int speed)
+{
+	return ERROR_OK;
+}
+
+static int rvsim_init(void)
+{
+	memset(&rvsim_stats, 0, sizeof(rvsim_stats));
+	rvsim_dm_reset();
+	for (unsigned int i = 0; i < rvsim_num_harts; i++) {
+		memset(&rvsim_harts[i], 0, sizeof(rvsim_harts[i]));
+		rvsim_hart_reset(&rvsim_harts[i]);
+	}
+	rvsim_dmi_result = 0;
+	rvsim_dmi_busy_until = 0;
+	rvsim_dmi_sticky_busy = false;
+	rvsim_state = TAP_RESET;
+	bitbang_interface = &rvsim_bitbang;
+
+	LOG_INFO("riscv_sim: RV%u, %u hart(s), datacount=%u progbufsize=%u sba=%s",
+		rvsim_xlen, rvsim_num_harts, rvsim_datacount, rvsim_progbufsize,
+		rvsim_sba_enabled ? "on" : "off");
+	return ERROR_OK;
+}
+
+static int rvsim_quit(void)
+{
+	for (unsigned int i = 0; i < rvsim_mem_num; i++) {
+		free(rvsim_mem[i].data);
+		rvsim_mem[i].data = NULL;
+	}
+	rvsim_mem_num = 0;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_memory_command)
+{
+	uint64_t base;
+	uint32_t size;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	COMMAND_PARSE_NUMBER(u64, CMD_ARGV[0], base);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	if (size == 0 || (base & 7) || (size & 7)) {
+		command_print(CMD, "memory region must be 8-byte aligned and non-empty");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	if (rvsim_mem_num == RVSIM_MAX_MEM_REGIONS) {
+		command_print(CMD, "too many memory regions (max %d)", RVSIM_MAX_MEM_REGIONS);
+		return ERROR_FAIL;
+	}
+	uint8_t *data = calloc(size, 1);
+	if (!data) {
+		LOG_ERROR("riscv_sim: failed to allocate %" PRIu32 " bytes", size);
+		return ERROR_FAIL;
+	}
+	rvsim_mem[rvsim_mem_num].base = base;
+	rvsim_mem[rvsim_mem_num].size = size;
+	rvsim_mem[rvsim_mem_num].data = data;
+	rvsim_mem_num++;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_harts_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	unsigned int num;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], num);
+	if (num == 0 || num > RVSIM_MAX_HARTS) {
+		command_print(CMD, "number of harts must be 1..%d", RVSIM_MAX_HARTS);
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	rvsim_num_harts = num;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_xlen_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	unsigned int xlen;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], xlen);
+	if (xlen != 32 && xlen != 64) {
+		command_print(CMD, "xlen must be 32 or 64");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	rvsim_xlen = xlen;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_idcode_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], rvsim_idcode);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_abstract_command)
+{
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	unsigned int datacount, progbufsize;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], datacount);
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], progbufsize);
+	if (datacount == 0 || datacount > RVSIM_DATA_MAX || progbufsize > RVSIM_PROGBUF_MAX) {
+		command_print(CMD, "datacount must be 1..%d and progbufsize 0..%d",
+			RVSIM_DATA_MAX, RVSIM_PROGBUF_MAX);
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	rvsim_datacount = datacount;
+	rvsim_progbufsize = progbufsize;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_sba_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	COMMAND_PARSE_ON_OFF(CMD_ARGV[0], rvsim_sba_enabled);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_idle_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	unsigned int idle;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], idle);
+	if (idle > 7) {
+		command_print(CMD, "dtmcs.idle must be 0..7");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	rvsim_dtmcs_idle = idle;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(rvsim_handle_latency_command)
+{
+	if (CMD_ARGC == 0) {
+		for (unsigned int i = 0; i < RVSIM_LATENCY_NUM; i++)
+			command_print(CMD, "%-8s %u", rvsim_latency_names[i], rvsim_latency[i]);
+		return ERROR_OK;
+	}
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	for (unsigned int i = 0; i < RVSIM_LATENCY_NUM; i++) {
+		if (strcmp(CMD_ARGV[0], rvsim_latency_names[i]) == 0) {
+			COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], rvsim_latency[i]);
+			return ERROR_OK;
+		}
+	}
+	command_print(CMD, "unknown latency class '%s'", CMD_ARGV[0]);
+	return ERROR_COMMAND_ARGUMENT_INVALID;
+}
+
+COMMAND_HANDLER(rvsim_handle_stats_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		memset(&rvsim_stats, 0, sizeof(rvsim_stats));
+		/* busy deadlines are relative to the idle cycle counter */
+		rvsim_dmi_busy_until = 0;
+		rvsim_dm.abstract_busy_until = 0;
+		rvsim_dm.sba_busy_until = 0;
+		return ERROR_OK;
+	}
+
+	const struct rvsim_stats *st = &rvsim_stats;
+	command_print(CMD, "TCK cycles:          %" PRIu64 " (%" PRIu64 " in Run-Test/Idle)",
+		st->tck, st->idle_cycles);
+	command_print(CMD, "IR scans / bits:     %" PRIu64 " / %" PRIu64, st->ir_scans, st->ir_bits);
+	command_print(CMD, "DR scans / bits:     %" PRIu64 " / %" PRIu64, st->dr_scans, st->dr_bits);
+	command_print(CMD, "DMI read/write/nop:  %" PRIu64 " / %" PRIu64 " / %" PRIu64,
+		st->dmi_reads, st->dmi_writes, st->dmi_nops);
+	command_print(CMD, "DMI busy / dmireset: %" PRIu64 " / %" PRIu64, st->dmi_busy, st->dmi_resets);
+	command_print(CMD, "abstract reg/mem:    %" PRIu64 " / %" PRIu64 " (%" PRIu64 " busy, %" PRIu64 " errors)",
+		st->abstract_regs, st->abstract_mems, st->abstract_busy, st->abstract_errors);
+	command_print(CMD, "progbuf runs/insns:  %" PRIu64 " / %" PRIu64, st->progbuf_runs, st->progbuf_insns);
+	command_print(CMD, "SBA read/write/busy: %" PRIu64 " / %" PRIu64 " / %" PRIu64,
+		st->sba_reads, st->sba_writes, st->sba_busy);
+	command_print(CMD, "memory read/write:   %" PRIu64 " / %" PRIu64 " bytes",
+		st->mem_read_bytes, st->mem_write_bytes);
+	command_print(CMD, "halts/resumes/steps: %" PRIu64 " / %" PRIu64 " / %" PRIu64,
+		st->halts, st->resumes, st->steps);
+	uint64_t mem_bytes = st->mem_read_bytes + st->mem_write_bytes;
+	if (mem_bytes)
+		command_print(CMD, "DR scans per KiB:    %" PRIu64 ", TCK per KiB: %" PRIu64,
+			st->dr_scans * 1024 / mem_bytes, st->tck * 1024 / mem_bytes);
+	return ERROR_OK;
+}
+
+static const struct command_registration rvsim_subcommand_handlers[] = {
+	{
+		.name = "memory",
+		.handler = &rvsim_handle_memory_command,
+		.mode = COMMAND_CONFIG,
+		.help = "add a zero-initialized RAM region shared by all harts and SBA",
+		.usage = "address size",
+	},
+	{
+		.name = "harts",
+		.handler = &rvsim_handle_harts_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the number of harts behind the debug module (default: 1)",
+		.usage = "num",
+	},
+	{
+		.name = "xlen",
+		.handler = &rvsim_handle_xlen_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the register width of the simulated harts (default: 32)",
+		.usage = "32|64",
+	},
+	{
+		.name = "idcode",
+		.handler = &rvsim_handle_idcode_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the IDCODE of the simulated DTM",
+		.usage = "idcode",
+	},
+	{
+		.name = "abstract",
+		.handler = &rvsim_handle_abstract_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the number of data and program buffer registers (default: 2 2)",
+		.usage = "datacount progbufsize",
+	},
+	{
+		.name = "sba",
+		.handler = &rvsim_handle_sba_command,
+		.mode = COMMAND_CONFIG,
+		.help = "enable or disable System Bus Access (default: on)",
+		.usage = "on|off",
+	},
+	{
+		.name = "idle",
+		.handler = &rvsim_handle_idle_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the dtmcs.idle hint reported by the DTM (default: 0)",
+		.usage = "cycles",
+	},
+	{
+		.name = "latency",
+		.handler = &rvsim_handle_latency_command,
+		.mode = COMMAND_ANY,
+		.help = "show or set the number of Run-Test/Idle cycles an operation stays busy",
+		.usage = "[('dmi'|'abstract'|'sba') cycles]",
+	},
+	{
+		.name = "stats",
+		.handler = &rvsim_handle_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "print or reset the scan/DMI/memory counters",
+		.usage = "['reset']",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration rvsim_command_handlers[] = {
+	{
+		.name = "riscv_sim",
+		.mode = COMMAND_ANY,
+		.help = "RISC-V debug module simulator commands",
+		.chain = rvsim_subcommand_handlers,
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static struct jtag_interface rvsim_interface = {
+	.supported = DEBUG_CAP_TMS_SEQ,
+	.execute_queue = &bitbang_execute_queue,
+};
+
+struct adapter_driver riscv_sim_adapter_driver = {
+	.name = "riscv_sim",
+	.transport_ids = TRANSPORT_JTAG,
+	.transport_preferred_id = TRANSPORT_JTAG,
+	.commands = rvsim_command_handlers,
+
+	.init = &rvsim_init,
+	.quit = &rvsim_quit,
+	.reset = &rvsim_reset,
+	.speed = &rvsim_speed,
+	.khz = &rvsim_khz,
+	.speed_div = &rvsim_speed_div,
+
+	.jtag_ops = &rvsim_interface,
+};
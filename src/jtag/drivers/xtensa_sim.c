@@ -0,0 +1,808 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/***************************************************************************
+ *   In-process Xtensa TAP / debug module simulator                        *
+ *   Copyright (C) 2026 Espressif Systems (Shanghai) Co. Ltd.              *
+ ***************************************************************************/
+
+/*
+ * This adapter driver does not talk to any hardware. It simulates a JTAG chain
+ * of Xtensa LX TAPs, each with a Nexus (NAR/NDR) debug module, a register file
+ * and a shared RAM. It implements just enough of the OCD instruction set to
+ * service the instructions injected by src/target/xtensa/xtensa.c (RSR/WSR/XSR,
+ * RUR/WUR, RFR/WFR, L32I/S32I and friends, LDDR32.P/SDDR32.P, ROTW, RFDO, JX)
+ * and counts every TCK, scan, bit and debug module access, so that memory,
+ * register and flash-stub paths can be benchmarked deterministically without
+ * silicon.
+ *
+ * Only little-endian cores are supported. Running code is not simulated: on
+ * resume the PC stays where it is until a debug interrupt halts the core again,
+ * and a resume with ICOUNTLEVEL set completes a 3-byte "step" immediately.
+ *
+ * The TRAX trace unit has a small trace RAM. As no code runs, stopping a trace
+ * "records" a fixed sequence of numbered messages, one more than a wrap of the
+ * trace RAM, so that a dump can be checked for order and completeness.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <jtag/interface.h>
+#include <jtag/commands.h>
+#include <target/xtensa/xtensa_debug_module.h>
+#include "bitbang.h"
+
+#define XTSIM_MAX_CORES			4
+#define XTSIM_MAX_MEM_REGIONS	16
+#define XTSIM_AREGS_NUM			64
+#define XTSIM_NAR_NUM			128
+
+#define XTSIM_IR_LEN			5
+#define XTSIM_IR_PWRCTL			0x08
+#define XTSIM_IR_PWRSTAT		0x09
+#define XTSIM_IR_NARSEL			0x1C
+#define XTSIM_IR_IDCODE			0x1E
+#define XTSIM_IR_BYPASS			0x1F
+
+#define XTSIM_NAR_LEN			8
+#define XTSIM_NDR_LEN			32
+#define XTSIM_PWR_LEN			8
+
+/* JTAG (8-bit) flavour of the PWRCTL/PWRSTAT bits, see xtensa_debug_module.h */
+#define XTSIM_PWRCTL_CORERESET		BIT(4)
+#define XTSIM_PWRSTAT_DOMAINS_ON	(BIT(0) | BIT(1) | BIT(2))
+#define XTSIM_PWRSTAT_COREWASRESET	BIT(4)
+#define XTSIM_PWRSTAT_DEBUGWASRESET	BIT(6)
+
+/* Special registers the simulator has to know about */
+#define XTSIM_SR_WINDOWBASE		0x48
+#define XTSIM_SR_DDR			0x68
+#define XTSIM_SR_EPC_BASE		0xB0
+#define XTSIM_SR_DEBUGCAUSE		0xE9
+#define XTSIM_SR_ICOUNT			0xEC
+#define XTSIM_SR_ICOUNTLEVEL	0xED
+#define XTSIM_SR_EXCCAUSE		0xE8
+
+#define XTSIM_EXCCAUSE_LOAD_STORE_ERROR	3
+#define XTSIM_RESET_PC			0x40000400
+#define XTSIM_DEFAULT_IDCODE	0x120034e5
+#define XTSIM_DEFAULT_DBGLEVEL	6
+
+#define XTSIM_TRAX_WORDS		256
+#define XTSIM_TRAX_MEMSZ		10		/* log2 of the trace RAM size in bytes */
+/* Number of messages recorded by a trace, the oldest ones are overwritten */
+#define XTSIM_TRAX_MSGS			(XTSIM_TRAX_WORDS + 16)
+#define XTSIM_TRAX_MSG(n)		(0x54520000 | (n))
+
+struct xtsim_mem_region {
+	uint32_t base;
+	uint32_t size;
+	uint8_t *data;
+};
+
+struct xtsim_core {
+	uint32_t ar[XTSIM_AREGS_NUM];
+	uint32_t sr[256];
+	uint32_t ur[256];
+	uint32_t fr[16];
+	uint32_t ddr;
+	uint32_t dir[8];
+	uint32_t dcr;
+	uint32_t dsr;
+	uint32_t nar[XTSIM_NAR_NUM];	/* backing store for all other NAR registers */
+	uint8_t pwrctl;
+	uint8_t pwrstat;
+	bool halted;
+	uint32_t trax[XTSIM_TRAX_WORDS];
+	uint32_t traxctrl;
+	uint32_t traxaddr;
+	bool tracing;
+};
+
+struct xtsim_tap {
+	uint8_t ir;
+	uint8_t ir_shift;
+	uint64_t dr_shift;
+	unsigned int dr_len;
+	/* NARSEL alternates between the NAR and the NDR on every Update-DR */
+	bool ndr_selected;
+	uint8_t nar;
+	struct xtsim_core core;
+};
+
+struct xtsim_stats {
+	uint64_t tck;
+	uint64_t ir_scans;
+	uint64_t ir_bits;
+	uint64_t dr_scans;
+	uint64_t dr_bits;
+	uint64_t nar_reads;
+	uint64_t nar_writes;
+	uint64_t pwr_accesses;
+	uint64_t insns;
+	uint64_t ddrexec;
+	uint64_t exceptions;
+	uint64_t mem_read_bytes;
+	uint64_t mem_write_bytes;
+	uint64_t resumes;
+	uint64_t steps;
+	uint64_t halts;
+};
+
+static struct xtsim_tap xtsim_taps[XTSIM_MAX_CORES];
+static unsigned int xtsim_num_cores = 1;
+static uint32_t xtsim_idcode = XTSIM_DEFAULT_IDCODE;
+static unsigned int xtsim_dbglevel = XTSIM_DEFAULT_DBGLEVEL;
+static struct xtsim_mem_region xtsim_mem[XTSIM_MAX_MEM_REGIONS];
+static unsigned int xtsim_mem_num;
+static struct xtsim_stats xtsim_stats;
+
+static enum tap_state xtsim_state = TAP_RESET;
+static int xtsim_tck;
+static int xtsim_tdo;
+
+/* Table of debug register offsets; the NAR numbers index the simulated registers */
+static const struct xtensa_dm_reg_offsets xtsim_dm_regs[XDMREG_NUM] = XTENSA_DM_REG_OFFSETS;
+
+static uint8_t *xtsim_mem_ptr(uint32_t addr, uint32_t size)
+{
+	for (unsigned int i = 0; i < xtsim_mem_num; i++) {
+		struct xtsim_mem_region *m = &xtsim_mem[i];
+		if (addr >= m->base && size <= m->size && addr - m->base <= m->size - size)
+			return &m->data[addr - m->base];
+	}
+	return NULL;
+}
+
+static uint32_t *xtsim_ar(struct xtsim_core *core, unsigned int idx)
+{
+	unsigned int wb = core->sr[XTSIM_SR_WINDOWBASE];
+	return &core->ar[(wb * 4 + idx) % XTSIM_AREGS_NUM];
+}
+
+static uint32_t *xtsim_sr(struct xtsim_core *core, unsigned int sr)
+{
+	return (sr == XTSIM_SR_DDR) ? &core->ddr : &core->sr[sr];
+}
+
+static uint32_t *xtsim_pc(struct xtsim_core *core)
+{
+	return &core->sr[XTSIM_SR_EPC_BASE + xtsim_dbglevel];
+}
+
+static void xtsim_halt(struct xtsim_core *core, uint32_t cause)
+{
+	core->halted = true;
+	core->dsr |= OCDDSR_STOPPED;
+	core->dcr &= ~OCDDCR_DEBUGINTERRUPT;
+	core->sr[XTSIM_SR_DEBUGCAUSE] = cause;
+	xtsim_stats.halts++;
+}
+
+static void xtsim_core_reset(struct xtsim_core *core)
+{
+	memset(core->ar, 0, sizeof(core->ar));
+	memset(core->sr, 0, sizeof(core->sr));
+	memset(core->ur, 0, sizeof(core->ur));
+	memset(core->fr, 0, sizeof(core->fr));
+	core->ddr = 0;
+	*xtsim_pc(core) = XTSIM_RESET_PC;
+	core->halted = false;
+	core->dsr = OCDDSR_DBGMODPOWERON;
+	core->pwrstat |= XTSIM_PWRSTAT_COREWASRESET;
+}
+
+static void xtsim_resume(struct xtsim_core *core)
+{
+	if (core->sr[XTSIM_SR_ICOUNTLEVEL] > 0) {
+		/* Pretend one 24-bit instruction was executed */
+		*xtsim_pc(core) += 3;
+		core->sr[XTSIM_SR_ICOUNT] = 0;
+		xtsim_stats.steps++;
+		xtsim_halt(core, DEBUGCAUSE_IC);
+		return;
+	}
+	core->halted = false;
+	core->dsr &= ~OCDDSR_STOPPED;
+	xtsim_stats.resumes++;
+	if (core->dcr & OCDDCR_DEBUGINTERRUPT)
+		xtsim_halt(core, DEBUGCAUSE_DI);
+}
+
+static bool xtsim_load(struct xtsim_core *core, uint32_t addr, unsigned int size, uint32_t *val)
+{
+	const uint8_t *p = xtsim_mem_ptr(addr & ~(size - 1), size);
+	if (!p) {
+		core->sr[XTSIM_SR_EXCCAUSE] = XTSIM_EXCCAUSE_LOAD_STORE_ERROR;
+		return false;
+	}
+	*val = 0;
+	for (unsigned int i = 0; i < size; i++)
+		*val |= (uint32_t)p[i] << (8 * i);
+	xtsim_stats.mem_read_bytes += size;
+	return true;
+}
+
+static bool xtsim_store(struct xtsim_core *core, uint32_t addr, unsigned int size, uint32_t val)
+{
+	uint8_t *p = xtsim_mem_ptr(addr & ~(size - 1), size);
+	if (!p) {
+		core->sr[XTSIM_SR_EXCCAUSE] = XTSIM_EXCCAUSE_LOAD_STORE_ERROR;
+		return false;
+	}
+	for (unsigned int i = 0; i < size; i++)
+		p[i] = val >> (8 * i);
+	xtsim_stats.mem_write_bytes += size;
+	return true;
+}
+
+/* Execute the 24-bit little-endian instruction held in DIR0 */
+static void xtsim_exec(struct xtsim_core *core)
+{
+	uint32_t ins = core->dir[0] & 0xFFFFFF;
+	unsigned int t = (ins >> 4) & 0xF;
+	unsigned int s = (ins >> 8) & 0xF;
+	unsigned int r = (ins >> 12) & 0xF;
+	unsigned int sr = (ins >> 8) & 0xFF;
+	unsigned int imm8 = (ins >> 16) & 0xFF;
+	bool ok = true;
+	uint32_t val;
+
+	xtsim_stats.insns++;
+	if (!core->halted) {
+		core->dsr |= OCDDSR_EXECOVERRUN;
+		return;
+	}
+
+	if ((ins & 0xFF000F) == 0x030000) {			/* RSR */
+		*xtsim_ar(core, t) = *xtsim_sr(core, sr);
+	} else if ((ins & 0xFF000F) == 0x130000) {	/* WSR */
+		*xtsim_sr(core, sr) = *xtsim_ar(core, t);
+	} else if ((ins & 0xFF000F) == 0x610000) {	/* XSR */
+		val = *xtsim_sr(core, sr);
+		*xtsim_sr(core, sr) = *xtsim_ar(core, t);
+		*xtsim_ar(core, t) = val;
+	} else if ((ins & 0xFF000F) == 0xE30000) {	/* RUR */
+		*xtsim_ar(core, r) = core->ur[(ins >> 4) & 0xFF];
+	} else if ((ins & 0xFF000F) == 0xF30000) {	/* WUR */
+		core->ur[sr] = *xtsim_ar(core, t);
+	} else if ((ins & 0xFF00FF) == 0xFA0040) {	/* RFR */
+		*xtsim_ar(core, r) = core->fr[s];
+	} else if ((ins & 0xFF00FF) == 0xFA0050) {	/* WFR */
+		core->fr[r] = *xtsim_ar(core, s);
+	} else if ((ins & 0xFFF0FF) == 0x0070E0) {	/* LDDR32.P */
+		ok = xtsim_load(core, *xtsim_ar(core, s), 4, &core->ddr);
+		if (ok)
+			*xtsim_ar(core, s) += 4;
+	} else if ((ins & 0xFFF0FF) == 0x0070F0) {	/* SDDR32.P */
+		ok = xtsim_store(core, *xtsim_ar(core, s), 4, core->ddr);
+		if (ok)
+			*xtsim_ar(core, s) += 4;
+	} else if ((ins & 0x00F00F) == 0x007002) {	/* cache ops (IHI, DHWB, DHWBI, ...) */
+		/* no caches are simulated */
+	} else if ((ins & 0x00F00F) == 0x002002) {	/* L32I */
+		ok = xtsim_load(core, *xtsim_ar(core, s) + imm8 * 4, 4, &val);
+		if (ok)
+			*xtsim_ar(core, t) = val;
+	} else if ((ins & 0x00F00F) == 0x001002) {	/* L16UI */
+		ok = xtsim_load(core, *xtsim_ar(core, s) + imm8 * 2, 2, &val);
+		if (ok)
+			*xtsim_ar(core, t) = val;
+	} else if ((ins & 0x00F00F) == 0x000002) {	/* L8UI */
+		ok = xtsim_load(core, *xtsim_ar(core, s) + imm8, 1, &val);
+		if (ok)
+			*xtsim_ar(core, t) = val;
+	} else if ((ins & 0x00F00F) == 0x006002) {	/* S32I */
+		ok = xtsim_store(core, *xtsim_ar(core, s) + imm8 * 4, 4, *xtsim_ar(core, t));
+	} else if ((ins & 0x00F00F) == 0x005002) {	/* S16I */
+		ok = xtsim_store(core, *xtsim_ar(core, s) + imm8 * 2, 2, *xtsim_ar(core, t));
+	} else if ((ins & 0x00F00F) == 0x004002) {	/* S8I */
+		ok = xtsim_store(core, *xtsim_ar(core, s) + imm8, 1, *xtsim_ar(core, t));
+	} else if ((ins & 0xFFFF0F) == 0x002000) {	/* ISYNC, RSYNC, ESYNC, DSYNC */
+		/* nothing to synchronize */
+	} else if ((ins & 0xFFFF0F) == 0x408000) {	/* ROTW */
+		int n = (t & 0x8) ? (int)t - 16 : (int)t;
+		unsigned int wb_num = XTSIM_AREGS_NUM / 4;
+		core->sr[XTSIM_SR_WINDOWBASE] = (core->sr[XTSIM_SR_WINDOWBASE] + wb_num + n) % wb_num;
+	} else if ((ins & 0xFFF0FF) == 0x0000A0) {	/* JX */
+		*xtsim_pc(core) = *xtsim_ar(core, s);
+	} else if ((ins & 0xFFFFEF) == 0xF1E000) {	/* RFDO, RFDD */
+		xtsim_resume(core);
+	} else {
+		LOG_DEBUG("xtensa_sim: unsupported instruction 0x%06" PRIx32, ins);
+		ok = false;
+	}
+
+	if (ok) {
+		core->dsr |= OCDDSR_EXECDONE;
+	} else {
+		core->dsr |= OCDDSR_EXECDONE | OCDDSR_EXECEXCEPTION;
+		xtsim_stats.exceptions++;
+	}
+}
+
+static void xtsim_traxctrl_write(struct xtsim_core *core, uint32_t val)
+{
+	if ((val & TRAXCTRL_TREN) && !(core->traxctrl & TRAXCTRL_TREN))
+		core->tracing = true;
+	if ((val & TRAXCTRL_TRSTP) && core->tracing) {
+		for (uint32_t n = 0; n < XTSIM_TRAX_MSGS; n++)
+			core->trax[n % XTSIM_TRAX_WORDS] = XTSIM_TRAX_MSG(n);
+		core->traxaddr = ((XTSIM_TRAX_MSGS / XTSIM_TRAX_WORDS) << TRAXADDR_TWRAP_SHIFT) |
+			(XTSIM_TRAX_MSGS % XTSIM_TRAX_WORDS);
+		core->tracing = false;
+	}
+	core->traxctrl = val & ~TRAXCTRL_TRSTP;
+}
+
+/* TRAXDATA reads the trace RAM at TRAXADDR and advances it */
+static uint32_t xtsim_traxdata_read(struct xtsim_core *core)
+{
+	uint32_t taddr = core->traxaddr & TRAXADDR_TADDR_MASK;
+	uint32_t val = core->trax[taddr % XTSIM_TRAX_WORDS];
+
+	core->traxaddr = (core->traxaddr & ~TRAXADDR_TADDR_MASK) | ((taddr + 1) % XTSIM_TRAX_WORDS);
+	return val;
+}
+
+static uint32_t xtsim_nar_read(struct xtsim_core *core, unsigned int nar)
+{
+	uint32_t val;
+
+	xtsim_stats.nar_reads++;
+	if (nar == xtsim_dm_regs[XDMREG_OCDID].nar)
+		return xtsim_idcode;
+	if (nar == xtsim_dm_regs[XDMREG_DSR].nar)
+		return core->dsr;
+	if (nar == xtsim_dm_regs[XDMREG_DCRSET].nar || nar == xtsim_dm_regs[XDMREG_DCRCLR].nar)
+		return core->dcr;
+	if (nar == xtsim_dm_regs[XDMREG_DDR].nar)
+		return core->ddr;
+	if (nar == xtsim_dm_regs[XDMREG_DDREXEC].nar) {
+		val = core->ddr;
+		xtsim_stats.ddrexec++;
+		xtsim_exec(core);
+		return val;
+	}
+	if (nar >= xtsim_dm_regs[XDMREG_DIR0].nar && nar <= xtsim_dm_regs[XDMREG_DIR7].nar)
+		return core->dir[nar - xtsim_dm_regs[XDMREG_DIR0].nar];
+	if (nar == xtsim_dm_regs[XDMREG_TRAXCTRL].nar)
+		return core->traxctrl;
+	if (nar == xtsim_dm_regs[XDMREG_TRAXSTAT].nar)
+		return (core->tracing ? TRAXSTAT_TRACT : 0) | (XTSIM_TRAX_MEMSZ << TRAXSTAT_MEMSZ_SHIFT);
+	if (nar == xtsim_dm_regs[XDMREG_TRAXDATA].nar)
+		return xtsim_traxdata_read(core);
+	if (nar == xtsim_dm_regs[XDMREG_TRAXADDR].nar)
+		return core->traxaddr;
+	if (nar == xtsim_dm_regs[XDMREG_MEMADDRSTART].nar)
+		return 0;
+	if (nar == xtsim_dm_regs[XDMREG_MEMADDREND].nar)
+		return XTSIM_TRAX_WORDS - 1;
+	return core->nar[nar % XTSIM_NAR_NUM];
+}
+
+static void xtsim_nar_write(struct xtsim_core *core, unsigned int nar, uint32_t val)
+{
+	xtsim_stats.nar_writes++;
+	if (nar == xtsim_dm_regs[XDMREG_DSR].nar) {
+		/* status bits are write-one-to-clear */
+		core->dsr &= ~(val & ~(OCDDSR_STOPPED | OCDDSR_DBGMODPOWERON));
+	} else if (nar == xtsim_dm_regs[XDMREG_DCRSET].nar) {
+		core->dcr |= val;
+		if ((val & OCDDCR_DEBUGINTERRUPT) && !core->halted)
+			xtsim_halt(core, DEBUGCAUSE_DI);
+	} else if (nar == xtsim_dm_regs[XDMREG_DCRCLR].nar) {
+		core->dcr &= ~val;
+	} else if (nar == xtsim_dm_regs[XDMREG_DDR].nar) {
+		core->ddr = val;
+	} else if (nar == xtsim_dm_regs[XDMREG_DDREXEC].nar) {
+		core->ddr = val;
+		xtsim_stats.ddrexec++;
+		xtsim_exec(core);
+	} else if (nar == xtsim_dm_regs[XDMREG_DIR0EXEC].nar) {
+		core->dir[0] = val;
+		xtsim_exec(core);
+	} else if (nar >= xtsim_dm_regs[XDMREG_DIR0].nar && nar <= xtsim_dm_regs[XDMREG_DIR7].nar) {
+		core->dir[nar - xtsim_dm_regs[XDMREG_DIR0].nar] = val;
+	} else if (nar == xtsim_dm_regs[XDMREG_TRAXCTRL].nar) {
+		xtsim_traxctrl_write(core, val);
+	} else if (nar == xtsim_dm_regs[XDMREG_TRAXADDR].nar) {
+		core->traxaddr = val;
+	} else {
+		core->nar[nar % XTSIM_NAR_NUM] = val;
+	}
+}
+
+static void xtsim_pwrctl_write(struct xtsim_core *core, uint8_t val)
+{
+	bool was_in_reset = core->pwrctl & XTSIM_PWRCTL_CORERESET;
+	core->pwrctl = val;
+	if (val & XTSIM_PWRCTL_CORERESET) {
+		xtsim_core_reset(core);
+	} else if (was_in_reset) {
+		/* Core leaves reset; it halts right away if a debug interrupt is pending */
+		if (core->dcr & OCDDCR_DEBUGINTERRUPT)
+			xtsim_halt(core, DEBUGCAUSE_DI);
+	}
+}
+
+static void xtsim_capture_dr(struct xtsim_tap *tap)
+{
+	struct xtsim_core *core = &tap->core;
+
+	switch (tap->ir) {
+	case XTSIM_IR_IDCODE:
+		tap->dr_len = 32;
+		tap->dr_shift = xtsim_idcode;
+		break;
+	case XTSIM_IR_PWRCTL:
+		tap->dr_len = XTSIM_PWR_LEN;
+		tap->dr_shift = core->pwrctl;
+		break;
+	case XTSIM_IR_PWRSTAT:
+		tap->dr_len = XTSIM_PWR_LEN;
+		if (core->pwrctl & XTSIM_PWRCTL_CORERESET)
+			core->pwrstat |= XTSIM_PWRSTAT_COREWASRESET;
+		tap->dr_shift = core->pwrstat | XTSIM_PWRSTAT_DOMAINS_ON;
+		break;
+	case XTSIM_IR_NARSEL:
+		if (tap->ndr_selected) {
+			tap->dr_len = XTSIM_NDR_LEN;
+			/* Reads have side effects (DDREXEC), so only do them for read accesses */
+			tap->dr_shift = (tap->nar & 1) ? 0 : xtsim_nar_read(core, tap->nar >> 1);
+		} else {
+			tap->dr_len = XTSIM_NAR_LEN;
+			tap->dr_shift = 0;
+		}
+		break;
+	default:
+		tap->dr_len = 1;
+		tap->dr_shift = 0;
+		break;
+	}
+}
+
+static void xtsim_update_dr(struct xtsim_tap *tap)
+{
+	struct xtsim_core *core = &tap->core;
+	uint32_t val = (uint32_t)tap->dr_shift;
+
+	switch (tap->ir) {
+	case XTSIM_IR_PWRCTL:
+		xtsim_stats.pwr_accesses++;
+		xtsim_pwrctl_write(core, val);
+		break;
+	case XTSIM_IR_PWRSTAT:
+		xtsim_stats.pwr_accesses++;
+		core->pwrstat &= ~val;
+		break;
+	case XTSIM_IR_NARSEL:
+		if (tap->ndr_selected) {
+			if (tap->nar & 1)
+				xtsim_nar_write(core, tap->nar >> 1, val);
+		} else {
+			tap->nar = val;
+		}
+		tap->ndr_selected = !tap->ndr_selected;
+		break;
+	default:
+		break;
+	}
+}
+
+static void xtsim_clock(int tms, int tdi)
+{
+	enum tap_state state = xtsim_state;
+	int in = tdi;
+
+	xtsim_stats.tck++;
+
+	/* Actions are taken on the rising edge, based on the state being left */
+	switch (state) {
+	case TAP_RESET:
+		for (unsigned int i = 0; i < xtsim_num_cores; i++) {
+			xtsim_taps[i].ir = XTSIM_IR_IDCODE;
+			xtsim_taps[i].ndr_selected = false;
+		}
+		break;
+	case TAP_DRCAPTURE:
+		for (unsigned int i = 0; i < xtsim_num_cores; i++)
+			xtsim_capture_dr(&xtsim_taps[i]);
+		break;
+	case TAP_IRCAPTURE:
+		for (unsigned int i = 0; i < xtsim_num_cores; i++)
+			xtsim_taps[i].ir_shift = 0x01;
+		break;
+	case TAP_DRSHIFT:
+		xtsim_stats.dr_bits++;
+		/* TDI enters the TAP farthest from TDO, see jtag_tap_next_enabled() order */
+		for (int i = xtsim_num_cores - 1; i >= 0; i--) {
+			struct xtsim_tap *tap = &xtsim_taps[i];
+			int out = tap->dr_shift & 1;
+			tap->dr_shift = (tap->dr_shift >> 1) | ((uint64_t)in << (tap->dr_len - 1));
+			in = out;
+		}
+		break;
+	case TAP_IRSHIFT:
+		xtsim_stats.ir_bits++;
+		for (int i = xtsim_num_cores - 1; i >= 0; i--) {
+			struct xtsim_tap *tap = &xtsim_taps[i];
+			int out = tap->ir_shift & 1;
+			tap->ir_shift = (tap->ir_shift >> 1) | (in << (XTSIM_IR_LEN - 1));
+			in = out;
+		}
+		break;
+	default:
+		break;
+	}
+
+	xtsim_state = tap_state_transition(state, tms);
+
+	if (xtsim_state == state)
+		return;
+	switch (xtsim_state) {
+	case TAP_DRUPDATE:
+		xtsim_stats.dr_scans++;
+		for (unsigned int i = 0; i < xtsim_num_cores; i++)
+			xtsim_update_dr(&xtsim_taps[i]);
+		break;
+	case TAP_IRUPDATE:
+		xtsim_stats.ir_scans++;
+		for (unsigned int i = 0; i < xtsim_num_cores; i++) {
+			xtsim_taps[i].ir = xtsim_taps[i].ir_shift;
+			xtsim_taps[i].ndr_selected = false;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static enum bb_value xtsim_read(void)
+{
+	return xtsim_tdo ? BB_HIGH : BB_LOW;
+}
+
+static int xtsim_write(int tck, int tms, int tdi)
+{
+	if (tck != xtsim_tck) {
+		if (tck)
+			xtsim_clock(tms, tdi);
+		xtsim_tck = tck;
+	}
+	/* TDO presents the LSB of the TAP nearest to it while shifting */
+	if (xtsim_state == TAP_DRSHIFT)
+		xtsim_tdo = xtsim_taps[0].dr_shift & 1;
+	else if (xtsim_state == TAP_IRSHIFT)
+		xtsim_tdo = xtsim_taps[0].ir_shift & 1;
+	else
+		xtsim_tdo = 0;
+	return ERROR_OK;
+}
+
+static int xtsim_reset(int trst, int srst)
+{
+	if (trst || (srst && (jtag_get_reset_config() & RESET_SRST_PULLS_TRST)))
+		xtsim_state = TAP_RESET;
+	if (srst) {
+		for (unsigned int i = 0; i < xtsim_num_cores; i++)
+			xtsim_core_reset(&xtsim_taps[i].core);
+	}
+	return ERROR_OK;
+}
+
+static const struct bitbang_interface xtsim_bitbang = {
+	.read = &xtsim_read,
+	.write = &xtsim_write,
+};
+
+static int xtsim_khz(int khz, int *jtag_speed)
+{
+	*jtag_speed = khz;
+	return ERROR_OK;
+}
+
+static int xtsim_speed_div(int speed, int *khz)
+{
+	*khz = speed;
+	return ERROR_OK;
+}
+
+static int xtsim_speed(int speed)
+{
+	return ERROR_OK;
+}
+
+static int xtsim_init(void)
+{
+	for (unsigned int i = 0; i < xtsim_num_cores; i++) {
+		struct xtsim_core *core = &xtsim_taps[i].core;
+		memset(&xtsim_taps[i], 0, sizeof(xtsim_taps[i]));
+		core->pwrstat = XTSIM_PWRSTAT_DEBUGWASRESET;
+		xtsim_core_reset(core);
+	}
+	memset(&xtsim_stats, 0, sizeof(xtsim_stats));
+	xtsim_state = TAP_RESET;
+	bitbang_interface = &xtsim_bitbang;
+
+	LOG_INFO("xtensa_sim: %u core(s), %u memory region(s)", xtsim_num_cores, xtsim_mem_num);
+	return ERROR_OK;
+}
+
+static int xtsim_quit(void)
+{
+	for (unsigned int i = 0; i < xtsim_mem_num; i++) {
+		free(xtsim_mem[i].data);
+		xtsim_mem[i].data = NULL;
+	}
+	xtsim_mem_num = 0;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(xtsim_handle_memory_command)
+{
+	uint32_t base, size;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], base);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	if (size == 0 || (base & 3) || (size & 3)) {
+		command_print(CMD, "memory region must be word-aligned and non-empty");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	if (xtsim_mem_num == XTSIM_MAX_MEM_REGIONS) {
+		command_print(CMD, "too many memory regions (max %d)", XTSIM_MAX_MEM_REGIONS);
+		return ERROR_FAIL;
+	}
+	uint8_t *data = calloc(size, 1);
+	if (!data) {
+		LOG_ERROR("xtensa_sim: failed to allocate %" PRIu32 " bytes", size);
+		return ERROR_FAIL;
+	}
+	xtsim_mem[xtsim_mem_num].base = base;
+	xtsim_mem[xtsim_mem_num].size = size;
+	xtsim_mem[xtsim_mem_num].data = data;
+	xtsim_mem_num++;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(xtsim_handle_cores_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	unsigned int num;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], num);
+	if (num == 0 || num > XTSIM_MAX_CORES) {
+		command_print(CMD, "number of cores must be 1..%d", XTSIM_MAX_CORES);
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	xtsim_num_cores = num;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(xtsim_handle_idcode_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], xtsim_idcode);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(xtsim_handle_debuglevel_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	unsigned int level;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], level);
+	if (level < 2 || level > 7) {
+		command_print(CMD, "debug level must be 2..7");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	xtsim_dbglevel = level;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(xtsim_handle_stats_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		memset(&xtsim_stats, 0, sizeof(xtsim_stats));
+		return ERROR_OK;
+	}
+
+	const struct xtsim_stats *st = &xtsim_stats;
+	uint64_t nar_accesses = st->nar_reads + st->nar_writes;
+	command_print(CMD, "TCK cycles:         %" PRIu64, st->tck);
+	command_print(CMD, "IR scans / bits:    %" PRIu64 " / %" PRIu64, st->ir_scans, st->ir_bits);
+	command_print(CMD, "DR scans / bits:    %" PRIu64 " / %" PRIu64, st->dr_scans, st->dr_bits);
+	command_print(CMD, "NDR reads / writes: %" PRIu64 " / %" PRIu64, st->nar_reads, st->nar_writes);
+	command_print(CMD, "PWR accesses:       %" PRIu64, st->pwr_accesses);
+	command_print(CMD, "instructions:       %" PRIu64 " (%" PRIu64 " via DDREXEC, %" PRIu64 " exceptions)",
+		st->insns, st->ddrexec, st->exceptions);
+	command_print(CMD, "memory read/write:  %" PRIu64 " / %" PRIu64 " bytes",
+		st->mem_read_bytes, st->mem_write_bytes);
+	command_print(CMD, "resumes/steps/halts: %" PRIu64 " / %" PRIu64 " / %" PRIu64,
+		st->resumes, st->steps, st->halts);
+	if (nar_accesses)
+		command_print(CMD, "TCK per NDR access: %" PRIu64, st->tck / nar_accesses);
+	uint64_t mem_bytes = st->mem_read_bytes + st->mem_write_bytes;
+	if (mem_bytes)
+		command_print(CMD, "TCK per memory byte: %" PRIu64, st->tck / mem_bytes);
+	return ERROR_OK;
+}
+
+static const struct command_registration xtsim_subcommand_handlers[] = {
+	{
+		.name = "memory",
+		.handler = &xtsim_handle_memory_command,
+		.mode = COMMAND_CONFIG,
+		.help = "add a zero-initialized RAM region shared by all simulated cores",
+		.usage = "address size",
+	},
+	{
+		.name = "cores",
+		.handler = &xtsim_handle_cores_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the number of simulated Xtensa TAPs in the chain (default: 1)",
+		.usage = "num",
+	},
+	{
+		.name = "idcode",
+		.handler = &xtsim_handle_idcode_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the IDCODE and OCDID of the simulated TAPs (default: 0x120034e5)",
+		.usage = "idcode",
+	},
+	{
+		.name = "debuglevel",
+		.handler = &xtsim_handle_debuglevel_command,
+		.mode = COMMAND_CONFIG,
+		.help = "set the debug interrupt level, must match the core config (default: 6)",
+		.usage = "level",
+	},
+	{
+		.name = "stats",
+		.handler = &xtsim_handle_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "print or reset the scan/bit/instruction counters",
+		.usage = "['reset']",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration xtsim_command_handlers[] = {
+	{
+		.name = "xtensa_sim",
+		.mode = COMMAND_ANY,
+		.help = "Xtensa TAP simulator commands",
+		.chain = xtsim_subcommand_handlers,
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static struct jtag_interface xtsim_interface = {
+	.supported = DEBUG_CAP_TMS_SEQ,
+	.execute_queue = &bitbang_execute_queue,
+};
+
+struct adapter_driver xtensa_sim_adapter_driver = {
+	.name = "xtensa_sim",
+	.transport_ids = TRANSPORT_JTAG,
+	.transport_preferred_id = TRANSPORT_JTAG,
+	.commands = xtsim_command_handlers,
+
+	.init = &xtsim_init,
+	.quit = &xtsim_quit,
+	.reset = &xtsim_reset,
+	.speed = &xtsim_speed,
+	.khz = &xtsim_khz,
+	.speed_div = &xtsim_speed_div,
+
+	.jtag_ops = &xtsim_interface,
+};
@@ -134,6 +134,9 @@ struct adapter_driver *adapter_drivers[] = {
 #if BUILD_REMOTE_BITBANG == 1
 		&remote_bitbang_adapter_driver,
 #endif
+#if BUILD_RISCV_SIM == 1
+		&riscv_sim_adapter_driver,
+#endif
 #if BUILD_RLINK == 1
 		&rlink_adapter_driver,
 #endif
@@ -165,8 +168,11 @@ struct adapter_driver *adapter_drivers[] = {
 		&xds110_adapter_driver,
 #endif
 #if BUILD_XLNX_XVC == 1
-	&xlnx_pcie_xvc_adapter_driver,
-	&xlnx_axi_xvc_adapter_driver,
+		&xlnx_pcie_xvc_adapter_driver,
+		&xlnx_axi_xvc_adapter_driver,
+#endif
+#if BUILD_XTENSA_SIM == 1
+		&xtensa_sim_adapter_driver,
 #endif
 
 		NULL,
@@ -40,6 +40,8 @@
 #include <jtag/jtag.h>
 #include "rtos/rtos.h"
 #include "target/smp.h"
+#include <helper/perf_stats.h>
+#include <helper/time_support.h>
 
 /**
  * @file
@@ -66,6 +68,28 @@ struct target_desc_format {
 	uint32_t tdesc_length;
 };
 
+/* 'm' packet that is read from the target in several server_loop() iterations */
+struct gdb_mem_read {
+	uint8_t *buffer;	/* NULL if no read is in progress */
+	target_addr_t address;
+	uint32_t length;
+	uint32_t done;
+	/* target state when the read started, it is aborted if that changes */
+	enum target_state target_state;
+	bool aborted;
+	/* perf_start() of the packet and its size, the whole read is accounted to it */
+	int64_t perf_start;
+	int perf_packet_size;
+};
+
+/* qXfer:threads:read reply, kept until the thread list changes */
+struct thread_list_cache {
+	char *xml;
+	int length;
+	int size;
+	uint32_t hash;	/* of the thread details the XML was built from */
+};
+
 /* private connection data for GDB */
 struct gdb_connection {
 	char buffer[GDB_BUFFER_SIZE + 1]; /* Extra byte for null-termination */
@@ -97,8 +121,10 @@ struct gdb_connection {
 	bool extended_protocol;
 	/* temporarily used for target description support */
 	struct target_desc_format target_desc;
-	/* temporarily used for thread list support */
-	char *thread_list;
+	/* thread list support */
+	struct thread_list_cache thread_list;
+	/* memory read which is in progress, the reply is sent once it is completed */
+	struct gdb_mem_read mem_read;
 	/* flag to mask the output from gdb_log_callback() */
 	enum gdb_output_flag output_flag;
 	/* Unique index for this GDB connection. */
@@ -143,6 +169,14 @@ static int gdb_report_data_abort;
  * default. */
 static int gdb_report_register_access_error;
 
+/* Maximum time in ms spent on a memory read before other services and
+ * connections are handled. The rest of the read is done in the next
+ * iterations of server_loop(). Zero reads everything at once. */
+static unsigned int gdb_max_chunk_time = 100;
+/* Reads up to this size are done in one call, longer ones in blocks of this
+ * size and alignment with the timeout checked in between */
+#define GDB_MEM_READ_BLOCK_SIZE 4096
+
 /* set if we are sending target descriptions to gdb
  * via qXfer:features:read packet */
 /* enabled by default */
@@ -1032,7 +1066,8 @@ static int gdb_new_connection(struct connection *connection)
 	gdb_connection->extended_protocol = false;
 	gdb_connection->target_desc.tdesc = NULL;
 	gdb_connection->target_desc.tdesc_length = 0;
-	gdb_connection->thread_list = NULL;
+	memset(&gdb_connection->thread_list, 0, sizeof(gdb_connection->thread_list));
+	memset(&gdb_connection->mem_read, 0, sizeof(gdb_connection->mem_read));
 	gdb_connection->output_flag = GDB_OUTPUT_NO;
 	gdb_connection->unique_index = next_unique_id++;
 
@@ -1148,6 +1183,8 @@ static int gdb_connection_closed(struct connection *connection)
 	/* if this connection registered a debug-message receiver delete it */
 	delete_debug_msg_receiver(connection->cmd_ctx, target);
 
+	free(gdb_connection->thread_list.xml);
+	free(gdb_connection->mem_read.buffer);
 	free(connection->priv);
 	connection->priv = NULL;
 
@@ -1315,6 +1352,11 @@ static int gdb_get_registers_packet(struct connection *connection,
 
 	reg_packet_p = reg_packet;
 
+	/* Let the target fetch the registers in one go where it can; whatever is
+	 * left invalid is read one by one below. */
+	if (target_read_register_set(target, reg_list, reg_list_size) != ERROR_OK)
+		LOG_DEBUG("Couldn't prefetch the register set, reading registers one by one.");
+
 	for (i = 0; i < reg_list_size; i++) {
 		if (!reg_list[i] || !reg_list[i]->exist || reg_list[i]->hidden)
 			continue;
@@ -1541,48 +1583,28 @@ static int gdb_error(struct connection *connection, int retval)
 	return ERROR_OK;
 }
 
-static int gdb_read_memory_packet(struct connection *connection,
-		char const *packet, int packet_size)
-{
-	struct target *target = get_available_target_from_connection(connection);
-	char *separator;
-	uint64_t addr = 0;
-	uint32_t len = 0;
-
-	uint8_t *buffer;
-	char *hex_buffer;
-
-	int retval = ERROR_OK;
-
-	/* skip command character */
-	packet++;
-
-	addr = strtoull(packet, &separator, 16);
-
-	if (*separator != ',') {
-		LOG_ERROR("incomplete read memory packet received, dropping connection");
-		return ERROR_SERVER_REMOTE_CLOSED;
-	}
+/* per packet type, indexed by the first character of the packet */
+static struct perf_counter gdb_packet_perf[128];
 
-	len = strtoul(separator + 1, NULL, 16);
+static struct perf_counter *gdb_get_packet_perf(char type)
+{
+	struct perf_counter *counter = &gdb_packet_perf[type & 0x7f];
 
-	if (!len) {
-		LOG_WARNING("invalid read memory packet received (len == 0)");
-		gdb_put_packet(connection, "", 0);
-		return ERROR_OK;
+	if (!counter->name[0]) {
+		snprintf(counter->name, sizeof(counter->name), "gdb.packet.%c",
+			isprint((unsigned char)type) ? type : '?');
+		counter->unit = "bytes";
 	}
+	return counter;
+}
 
-	buffer = malloc(len);
-
-	LOG_DEBUG("addr: 0x%16.16" PRIx64 ", len: 0x%8.8" PRIx32, addr, len);
-
-	retval = ERROR_NOT_IMPLEMENTED;
-	if (target->rtos)
-		retval = rtos_read_buffer(target, addr, len, buffer);
-	if (retval == ERROR_NOT_IMPLEMENTED)
-		retval = target_read_buffer(target, addr, len, buffer);
+static int gdb_read_memory_finish(struct connection *connection, int retval)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	struct gdb_mem_read *mem_read = &gdb_con->mem_read;
+	uint32_t len = mem_read->length;
 
-	if ((retval != ERROR_OK) && !gdb_report_data_abort) {
+	if ((retval != ERROR_OK) && !gdb_report_data_abort && !mem_read->aborted) {
 		/* TODO : Here we have to lie and send back all zero's lest stack traces won't work.
 		 * At some point this might be fixed in GDB, in which case this code can be removed.
 		 *
@@ -1596,14 +1618,14 @@ static int gdb_read_memory_packet(struct connection *connection,
 		 * For now, the default is to fix up things to make current GDB versions work.
 		 * This can be overwritten using the "gdb report_data_abort <'enable'|'disable'>" command.
 		 */
-		memset(buffer, 0, len);
+		memset(mem_read->buffer, 0, len);
 		retval = ERROR_OK;
 	}
 
 	if (retval == ERROR_OK) {
-		hex_buffer = malloc(len * 2 + 1);
+		char *hex_buffer = malloc(len * 2 + 1);
 
-		size_t pkt_len = hexify(hex_buffer, buffer, len, len * 2 + 1);
+		size_t pkt_len = hexify(hex_buffer, mem_read->buffer, len, len * 2 + 1);
 
 		gdb_put_packet(connection, hex_buffer, pkt_len);
 
@@ -1611,11 +1633,106 @@ static int gdb_read_memory_packet(struct connection *connection,
 	} else
 		retval = gdb_error(connection, retval);
 
-	free(buffer);
+	free(mem_read->buffer);
+	mem_read->buffer = NULL;
+	perf_end(gdb_get_packet_perf('m'), mem_read->perf_start, mem_read->perf_packet_size);
+	gdb_con->output_flag = GDB_OUTPUT_NO;
+	/* resume processing of the packets received in the meantime */
+	connection->input_pending = gdb_con->buf_cnt > 0;
 
 	return retval;
 }
 
+/* Continue the memory read in progress for at most gdb_max_chunk_time ms. The
+ * reply is sent when the whole range is read. */
+static int gdb_read_memory_continue(struct connection *connection)
+{
+	struct target *target = get_available_target_from_connection(connection);
+	struct gdb_connection *gdb_con = connection->priv;
+	struct gdb_mem_read *mem_read = &gdb_con->mem_read;
+	int64_t start = timeval_ms();
+	int retval = ERROR_OK;
+
+	gdb_con->output_flag = GDB_OUTPUT_NOTIF;
+
+	while (mem_read->done < mem_read->length) {
+		target_addr_t addr = mem_read->address + mem_read->done;
+		uint32_t size = mem_read->length - mem_read->done;
+
+		if (target->state != mem_read->target_state) {
+			/* e.g. resumed or reset by a timer callback between two blocks */
+			LOG_TARGET_WARNING(target, "Target state changed, aborting GDB memory read");
+			mem_read->aborted = true;
+			retval = ERROR_TARGET_NOT_HALTED;
+			break;
+		}
+
+		if (gdb_max_chunk_time && mem_read->length > GDB_MEM_READ_BLOCK_SIZE)
+			size = MIN(size, GDB_MEM_READ_BLOCK_SIZE - (addr % GDB_MEM_READ_BLOCK_SIZE));
+
+		retval = ERROR_NOT_IMPLEMENTED;
+		if (target->rtos)
+			retval = rtos_read_buffer(target, addr, size, mem_read->buffer + mem_read->done);
+		if (retval == ERROR_NOT_IMPLEMENTED)
+			retval = target_read_buffer(target, addr, size, mem_read->buffer + mem_read->done);
+		if (retval != ERROR_OK)
+			break;
+		mem_read->done += size;
+
+		if (mem_read->done < mem_read->length && timeval_ms() - start >= gdb_max_chunk_time) {
+			/* let server_loop() handle the other connections and call us again */
+			connection->input_pending = true;
+			return ERROR_OK;
+		}
+	}
+
+	return gdb_read_memory_finish(connection, retval);
+}
+
+static int gdb_read_memory_packet(struct connection *connection,
+		char const *packet, int packet_size)
+{
+	struct target *target = get_available_target_from_connection(connection);
+	struct gdb_connection *gdb_con = connection->priv;
+	char *separator;
+	uint64_t addr = 0;
+	uint32_t len = 0;
+
+	/* skip command character */
+	packet++;
+
+	addr = strtoull(packet, &separator, 16);
+
+	if (*separator != ',') {
+		LOG_ERROR("incomplete read memory packet received, dropping connection");
+		return ERROR_SERVER_REMOTE_CLOSED;
+	}
+
+	len = strtoul(separator + 1, NULL, 16);
+
+	if (!len) {
+		LOG_WARNING("invalid read memory packet received (len == 0)");
+		gdb_put_packet(connection, "", 0);
+		return ERROR_OK;
+	}
+
+	gdb_con->mem_read.buffer = malloc(len);
+	if (!gdb_con->mem_read.buffer) {
+		LOG_ERROR("Unable to allocate memory");
+		return gdb_error(connection, ERROR_FAIL);
+	}
+	gdb_con->mem_read.address = addr;
+	gdb_con->mem_read.length = len;
+	gdb_con->mem_read.done = 0;
+	gdb_con->mem_read.target_state = target->state;
+	gdb_con->mem_read.aborted = false;
+	gdb_con->mem_read.perf_start = 0;
+
+	LOG_DEBUG("addr: 0x%16.16" PRIx64 ", len: 0x%8.8" PRIx32, addr, len);
+
+	return gdb_read_memory_continue(connection);
+}
+
 static int gdb_write_memory_packet(struct connection *connection,
 		char const *packet, int packet_size)
 {
@@ -2798,13 +2915,53 @@ error:
 	return retval;
 }
 
-static int gdb_generate_thread_list(struct target *target, char **thread_list_out)
+static uint32_t gdb_thread_list_hash_bytes(uint32_t hash, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= 16777619;	/* FNV-1a */
+	}
+	return hash;
+}
+
+/* Hash everything the thread list XML is built from */
+static uint32_t gdb_thread_list_hash(const struct rtos *rtos)
+{
+	uint32_t hash = 2166136261;
+
+	if (!rtos)
+		return hash;
+
+	for (int i = 0; i < rtos->thread_count; i++) {
+		const struct thread_detail *thread_detail = &rtos->thread_details[i];
+
+		if (!thread_detail->exists)
+			continue;
+		hash = gdb_thread_list_hash_bytes(hash, &thread_detail->threadid,
+			sizeof(thread_detail->threadid));
+		/* include the terminators to tell name and extra info apart */
+		if (thread_detail->thread_name_str)
+			hash = gdb_thread_list_hash_bytes(hash, thread_detail->thread_name_str,
+				strlen(thread_detail->thread_name_str) + 1);
+		hash = gdb_thread_list_hash_bytes(hash, "", 1);
+		if (thread_detail->extra_info_str)
+			hash = gdb_thread_list_hash_bytes(hash, thread_detail->extra_info_str,
+				strlen(thread_detail->extra_info_str) + 1);
+		hash = gdb_thread_list_hash_bytes(hash, "", 1);
+	}
+	return hash;
+}
+
+/* Build the thread list XML into the buffer of @a cache, which is reused and
+ * only grows (by doubling) if the list got longer than ever before. */
+static int gdb_generate_thread_list(struct target *target, struct thread_list_cache *cache)
 {
 	struct rtos *rtos = target->rtos;
 	int retval = ERROR_OK;
-	char *thread_list = NULL;
+	char *thread_list = cache->xml;
 	int pos = 0;
-	int size = 0;
+	int size = cache->size;
 
 	xml_printf(&retval, &thread_list, &pos, &size,
 		   "<?xml version=\"1.0\"?>\n"
@@ -2846,28 +3003,43 @@ static int gdb_generate_thread_list(struct target *target, char **thread_list_ou
 	xml_printf(&retval, &thread_list, &pos, &size,
 		   "</threads>\n");
 
-	if (retval == ERROR_OK)
-		*thread_list_out = thread_list;
-	else
-		free(thread_list);
+	if (retval == ERROR_OK) {
+		cache->xml = thread_list;
+		cache->length = pos;
+		cache->size = size;
+	} else {
+		/* xml_printf() already freed the buffer */
+		cache->xml = NULL;
+		cache->length = 0;
+		cache->size = 0;
+	}
 
 	return retval;
 }
 
-static int gdb_get_thread_list_chunk(struct target *target, char **thread_list,
+static int gdb_get_thread_list_chunk(struct target *target, struct thread_list_cache *cache,
 		char **chunk, int32_t offset, uint32_t length)
 {
-	if (!*thread_list) {
-		int retval = gdb_generate_thread_list(target, thread_list);
-		if (retval != ERROR_OK) {
-			LOG_ERROR("Unable to Generate Thread List");
-			return ERROR_FAIL;
+	/* Each transfer starts at offset 0. The XML is only rebuilt if the threads
+	 * changed since the previous transfer, e.g. after rtos_update_threads() on a
+	 * halt; chunks of the same transfer are always served from the cache. */
+	if (offset == 0 || !cache->xml) {
+		uint32_t hash = gdb_thread_list_hash(target->rtos);
+		if (!cache->xml || hash != cache->hash) {
+			int retval = gdb_generate_thread_list(target, cache);
+			if (retval != ERROR_OK) {
+				LOG_ERROR("Unable to Generate Thread List");
+				return ERROR_FAIL;
+			}
+			cache->hash = hash;
 		}
 	}
 
-	size_t thread_list_length = strlen(*thread_list);
+	size_t thread_list_length = cache->length;
 	char transfer_type;
 
+	if (offset < 0 || (size_t)offset > thread_list_length)
+		offset = thread_list_length;
 	length = MIN(length, thread_list_length - offset);
 	if (length < (thread_list_length - offset))
 		transfer_type = 'm';
@@ -2885,15 +3057,9 @@ static int gdb_get_thread_list_chunk(struct target *target, char **thread_list,
 	}
 
 	(*chunk)[0] = transfer_type;
-	strncpy((*chunk) + 1, (*thread_list) + offset, length);
+	memcpy((*chunk) + 1, cache->xml + offset, length);
 	(*chunk)[1 + length] = '\0';
 
-	/* After gdb-server sends out last chunk, invalidate thread list. */
-	if (transfer_type == 'l') {
-		free(*thread_list);
-		*thread_list = NULL;
-	}
-
 	return ERROR_OK;
 }
 
@@ -3148,7 +3314,10 @@ static bool gdb_handle_vcont_packet(struct connection *connection, const char *p
 	if (parse[0] == '?') {
 		if (target->type->step) {
 			/* gdb doesn't accept c without C and s without S */
-			gdb_put_packet(connection, "vCont;c;C;s;S", 13);
+			if (target->type->step_range)
+				gdb_put_packet(connection, "vCont;c;C;s;S;r", 15);
+			else
+				gdb_put_packet(connection, "vCont;c;C;s;S", 13);
 			return true;
 		}
 		return false;
@@ -3185,15 +3354,28 @@ static bool gdb_handle_vcont_packet(struct connection *connection, const char *p
 		return true;
 	}
 
-	/* single-step or step-over-breakpoint */
-	if (parse[0] == 's') {
+	/* single-step, step-over-breakpoint or range step */
+	if (parse[0] == 's' || parse[0] == 'r') {
 		gdb_running_type = 's';
 		bool fake_step = false;
+		bool range_step = parse[0] == 'r';
+		target_addr_t range_start = 0, range_end = 0;
 
 		struct target *ct = target;
 		bool current_pc = true;
 		int64_t thread_id;
 		parse++;
+		if (range_step) {
+			/* rSTART,END: step while START <= PC < END */
+			char *endp;
+			range_start = strtoull(parse, &endp, 16);
+			if (*endp != ',') {
+				LOG_ERROR("Malformed vCont range step packet");
+				return false;
+			}
+			range_end = strtoull(endp + 1, &endp, 16);
+			parse = endp;
+		}
 		if (parse[0] == ':') {
 			char *endp;
 			parse++;
@@ -3249,7 +3431,11 @@ static bool gdb_handle_vcont_packet(struct connection *connection, const char *p
 			}
 		}
 
-		LOG_TARGET_DEBUG(ct, "single-step thread %" PRIx64, thread_id);
+		if (range_step)
+			LOG_TARGET_DEBUG(ct, "range-step thread %" PRIx64 " [" TARGET_ADDR_FMT ", " TARGET_ADDR_FMT ")",
+				thread_id, range_start, range_end);
+		else
+			LOG_TARGET_DEBUG(ct, "single-step thread %" PRIx64, thread_id);
 		gdb_connection->output_flag = GDB_OUTPUT_ALL;
 		target_call_event_callbacks(ct, TARGET_EVENT_GDB_START);
 
@@ -3289,7 +3475,10 @@ static bool gdb_handle_vcont_packet(struct connection *connection, const char *p
 			return true;
 		}
 
-		retval = target_step(ct, current_pc, 0, false);
+		if (range_step && ct->type->step_range)
+			retval = target_step_range(ct, range_start, range_end, false);
+		else
+			retval = target_step(ct, current_pc, 0, false);
 		if (retval == ERROR_TARGET_NOT_HALTED)
 			LOG_TARGET_INFO(ct, "target was not halted when step was requested");
 
@@ -3691,6 +3880,7 @@ static int gdb_input_inner(struct connection *connection)
 		if (packet_size > 0) {
 			gdb_log_incoming_packet(connection, gdb_packet_buffer);
 
+			int64_t start = perf_start();
 			retval = ERROR_OK;
 			switch (packet[0]) {
 				case 'T':	/* Is thread alive? */
@@ -3719,9 +3909,8 @@ static int gdb_input_inner(struct connection *connection)
 					retval = gdb_set_register_packet(connection, packet, packet_size);
 					break;
 				case 'm':
-					gdb_con->output_flag = GDB_OUTPUT_NOTIF;
+					/* output_flag is restored once the read completes */
 					retval = gdb_read_memory_packet(connection, packet, packet_size);
-					gdb_con->output_flag = GDB_OUTPUT_NO;
 					break;
 				case 'M':
 					gdb_con->output_flag = GDB_OUTPUT_NOTIF;
@@ -3872,6 +4061,13 @@ static int gdb_input_inner(struct connection *connection)
 					gdb_put_packet(connection, "", 0);
 					break;
 			}
+			if (gdb_con->mem_read.buffer) {
+				/* accounted once the memory read in progress completes */
+				gdb_con->mem_read.perf_start = start;
+				gdb_con->mem_read.perf_packet_size = packet_size;
+			} else {
+				perf_end(gdb_get_packet_perf(packet[0]), start, packet_size);
+			}
 
 			/* if a packet handler returned an error, exit input loop */
 			if (retval != ERROR_OK)
@@ -3897,6 +4093,9 @@ static int gdb_input_inner(struct connection *connection)
 			}
 		}
 
+		/* the following packets wait for the reply to the memory read */
+		if (gdb_con->mem_read.buffer)
+			break;
 	} while (gdb_con->buf_cnt > 0);
 
 	return ERROR_OK;
@@ -3904,8 +4103,13 @@ static int gdb_input_inner(struct connection *connection)
 
 static int gdb_input(struct connection *connection)
 {
-	int retval = gdb_input_inner(connection);
 	struct gdb_connection *gdb_con = connection->priv;
+	int retval;
+
+	if (gdb_con->mem_read.buffer)
+		retval = gdb_read_memory_continue(connection);
+	else
+		retval = gdb_input_inner(connection);
 	if (retval == ERROR_SERVER_REMOTE_CLOSED)
 		return retval;
 
@@ -4144,6 +4348,18 @@ COMMAND_HANDLER(handle_gdb_report_data_abort_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_gdb_max_chunk_time_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], gdb_max_chunk_time);
+
+	command_print(CMD, "%u ms", gdb_max_chunk_time);
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_gdb_report_register_access_error)
 {
 	if (CMD_ARGC != 1)
@@ -4273,6 +4489,14 @@ static const struct command_registration gdb_subcommand_handlers[] = {
 		.help = "enable or disable reporting data aborts",
 		.usage = "('enable'|'disable')"
 	},
+	{
+		.name = "max_chunk_time",
+		.handler = handle_gdb_max_chunk_time_command,
+		.mode = COMMAND_ANY,
+		.help = "display or set the maximum time in ms spent on a memory "
+			"read before other connections are served, 0 reads at once",
+		.usage = "[ms]",
+	},
 	{
 		.name = "report_register_access_error",
 		.handler = handle_gdb_report_register_access_error,
@@ -16,6 +16,7 @@
 #endif
 
 #include "server.h"
+#include <helper/perf_stats.h>
 #include <helper/time_support.h>
 #include <target/target.h>
 #include <target/target_request.h>
@@ -428,6 +429,8 @@ void server_keep_clients_alive(void)
 				s->keep_client_alive(c);
 }
 
+static struct perf_counter server_loop_perf = PERF_COUNTER_INIT("server.loop", NULL);
+
 int server_loop(struct command_context *command_context)
 {
 	struct service *service;
@@ -471,6 +474,9 @@ int server_loop(struct command_context *command_context)
 					PORTABLE_FD_SET(c->fd, &read_fds);
 					if (c->fd > fd_max)
 						fd_max = c->fd;
+					/* don't sleep in select() if a connection has more work queued */
+					if (c->input_pending)
+						poll_ok = true;
 				}
 			}
 		}
@@ -516,6 +522,9 @@ int server_loop(struct command_context *command_context)
 #endif
 		}
 
+		/* measure the work done in this iteration, not the wait in select() */
+		int64_t loop_start = perf_start();
+
 		if (retval == 0) {
 			/* Execute callbacks of expired timers when
 			 * - there was nothing to do if poll_ok was true
@@ -525,6 +534,7 @@ int server_loop(struct command_context *command_context)
 			target_call_timer_callbacks();
 			next_event = target_timer_next_event();
 			process_jim_events(command_context);
+			perf_stats_poll();
 
 			FD_ZERO(&read_fds);	/* eCos leaves read_fds unchanged in this case!  */
 
@@ -592,6 +602,8 @@ int server_loop(struct command_context *command_context)
 			}
 		}
 
+		perf_end(&server_loop_perf, loop_start, 0);
+
 #ifdef _WIN32
 		MSG msg;
 		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
@@ -803,7 +803,6 @@ struct reg_cache *armv7m_build_reg_cache(struct target *target)
 	struct armv7m_common *armv7m = target_to_armv7m(target);
 	struct arm *arm = &armv7m->arm;
 	int num_regs = ARMV7M_NUM_REGS;
-	struct reg_cache **cache_p = register_get_last_cache_p(&target->reg_cache);
 	struct reg_cache *cache = malloc(sizeof(struct reg_cache));
 	struct reg *reg_list = calloc(num_regs, sizeof(struct reg));
 	struct arm_reg *arch_info = calloc(num_regs, sizeof(struct arm_reg));
@@ -815,7 +814,6 @@ struct reg_cache *armv7m_build_reg_cache(struct target *target)
 	cache->next = NULL;
 	cache->reg_list = reg_list;
 	cache->num_regs = num_regs;
-	(*cache_p) = cache;
 
 	for (i = 0; i < num_regs; i++) {
 		arch_info[i].num = armv7m_regs[i].id;
@@ -861,6 +859,7 @@ struct reg_cache *armv7m_build_reg_cache(struct target *target)
 	arm->cpsr = reg_list + ARMV7M_XPSR;
 	arm->pc = reg_list + ARMV7M_PC;
 	arm->core_cache = cache;
+	register_link_cache(&target->reg_cache, cache);
 
 	return cache;
 }
@@ -887,6 +886,7 @@ void armv7m_free_reg_cache(struct target *target)
 
 	free(cache->reg_list[0].arch_info);
 	free(cache->reg_list);
+	register_cache_free_index(cache);
 	free(cache);
 
 	arm->core_cache = NULL;
@@ -1825,7 +1825,6 @@ struct reg_cache *armv8_build_reg_cache(struct target *target)
 	struct arm *arm = &armv8->arm;
 	int num_regs = ARMV8_NUM_REGS;
 	int num_regs32 = ARMV8_NUM_REGS32;
-	struct reg_cache **cache_p = register_get_last_cache_p(&target->reg_cache);
 	struct reg_cache *cache = malloc(sizeof(struct reg_cache));
 	struct reg_cache *cache32 = malloc(sizeof(struct reg_cache));
 	struct reg *reg_list = calloc(num_regs, sizeof(struct reg));
@@ -1917,7 +1916,7 @@ struct reg_cache *armv8_build_reg_cache(struct target *target)
 			LOG_ERROR("unable to allocate reg type list");
 	}
 
-	(*cache_p) = cache;
+	register_link_cache(&target->reg_cache, cache);
 	return cache;
 }
 
@@ -1950,6 +1949,7 @@ static void armv8_free_cache(struct reg_cache *cache, bool regs32)
 	if (!regs32)
 		free(cache->reg_list[0].arch_info);
 	free(cache->reg_list);
+	register_cache_free_index(cache);
 	free(cache);
 }
 
@@ -2588,7 +2588,7 @@ fail1:
 		target_write_u32(target, comparator->dwt_comparator_address + 8, 0);
 	}
 
-	*register_get_last_cache_p(&target->reg_cache) = cache;
+	register_link_cache(&target->reg_cache, cache);
 	cm->dwt_cache = cache;
 
 	LOG_TARGET_DEBUG(target, "DWT dwtcr 0x%" PRIx32 ", comp %d, watch%s",
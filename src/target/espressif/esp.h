@@ -104,6 +104,7 @@ struct esp_semihost_data {
 	bool need_resume;
 	struct esp_semihost_ops *ops;
 	struct list_head dir_map_list;
+	struct list_head file_list;	/* files with buffered bulk I/O data */
 };
 
 struct esp_flash_breakpoint_ops {
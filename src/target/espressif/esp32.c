@@ -653,6 +653,7 @@ struct target_type esp32_target = {
 	.halt = xtensa_halt,
 	.resume = esp_xtensa_smp_resume,
 	.step = esp_xtensa_smp_step,
+	.step_range = esp_xtensa_smp_step_range,
 
 	.assert_reset = esp_xtensa_smp_assert_reset,
 	.deassert_reset = esp_xtensa_smp_deassert_reset,
@@ -36,6 +36,7 @@
 #include "esp_riscv_apptrace.h"
 #include "esp32_apptrace.h"
 #include "esp32_sysview.h"
+#include "esp32_sysview_store.h"
 #include "segger_sysview.h"
 
 #define ESP32_APPTRACE_USER_BLOCK_CORE(_v_)     ((_v_) >> 15)
@@ -50,6 +51,10 @@
 
 #define ESP32_APPTRACE_TGT_STATE_TMO            5000
 #define ESP_APPTRACE_BLOCKS_POOL_SZ             10
+/* max time in ms the data may stay in the destination buffer */
+#define ESP32_APPTRACE_DEST_FLUSH_TMO           100
+/* max number of blocks read by one poll */
+#define ESP32_APPTRACE_POLL_BLOCKS_MAX          ESP_APPTRACE_BLOCKS_POOL_SZ
 
 #define ESP_APPTRACE_FILE_CMD_FOPEN             0x0
 #define ESP_APPTRACE_FILE_CMD_FCLOSE            0x1
@@ -59,8 +64,11 @@
 #define ESP_APPTRACE_FILE_CMD_FTELL             0x5
 #define ESP_APPTRACE_FILE_CMD_STOP              0x6	/* indicates that there is no files to transfer */
 #define ESP_APPTRACE_FILE_CMD_FEOF              0x7
+#define ESP_APPTRACE_FILE_CMD_BATCH             0x8	/* several commands packed in one block */
 
 #define ESP_GCOV_FILES_MAX_NUM                  512
+#define ESP_GCOV_FILE_MODE_MAX                  8
+#define ESP_GCOV_FILE_BUF_SZ                    (64 * 1024)
 
 struct esp32_apptrace_dest_file_data {
 	int fout;
@@ -90,8 +98,12 @@ struct esp32_apptrace_block {
 };
 
 struct esp32_gcov_cmd_data {
+	/* files open by target */
 	FILE * files[ESP_GCOV_FILES_MAX_NUM];
-	uint32_t files_num;
+	/* files closed by target, but kept open to be reused when target opens the same path again */
+	FILE * cached[ESP_GCOV_FILES_MAX_NUM];
+	char *paths[ESP_GCOV_FILES_MAX_NUM];
+	char modes[ESP_GCOV_FILES_MAX_NUM][ESP_GCOV_FILE_MODE_MAX];
 	bool wait4halt;
 	int prefix_strip;
 	char *prefix;
@@ -102,6 +114,7 @@ static int esp_gcov_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 	uint8_t *data,
 	uint32_t data_len);
 static int esp32_apptrace_data_processor(void *priv);
+static int esp32_apptrace_poll(void *priv);
 static int esp32_apptrace_get_data_info(struct esp32_apptrace_cmd_ctx *ctx,
 	struct esp32_apptrace_target_state *target_state,
 	uint32_t *fired_target_num);
@@ -321,16 +334,103 @@ int esp32_apptrace_dest_init(struct esp32_apptrace_dest dest[], const char *dest
 
 int esp32_apptrace_dest_cleanup(struct esp32_apptrace_dest dest[], unsigned int max_dests)
 {
+	int retval = ERROR_OK;
+
 	for (unsigned int i = 0; i < max_dests; i++) {
+		if (dest[i].buf) {
+			if (dest[i].priv) {
+				int res = esp32_apptrace_dest_flush(&dest[i]);
+				if (res != ERROR_OK)
+					retval = res;
+			}
+			free(dest[i].buf);
+			dest[i].buf = NULL;
+			dest[i].buf_size = 0;
+		}
 		if (dest[i].clean && dest[i].priv) {
 			int res = dest[i].clean(dest[i].priv);
 			dest[i].priv = NULL;
+			if (res != ERROR_OK)
+				retval = res;
+		}
+	}
+	return retval;
+}
+
+/* Small writes (e.g. SystemView packets of a few bytes) are collected in a
+ * per-destination buffer which is passed to the destination when it gets full,
+ * when esp32_apptrace_dest_flush() is called on timeout and on stop. */
+int esp32_apptrace_dest_buf_init(struct esp32_apptrace_dest *dest, uint32_t size)
+{
+	dest->buf = malloc(size);
+	if (!dest->buf) {
+		LOG_ERROR("apptrace: Failed to alloc %" PRIu32 " bytes for dest buffer!", size);
+		return ERROR_FAIL;
+	}
+	dest->buf_size = size;
+	dest->buf_len = 0;
+	return ERROR_OK;
+}
+
+static int esp32_apptrace_dest_write_direct(struct esp32_apptrace_dest *dest, uint8_t *data, uint32_t size)
+{
+	dest->writes++;
+	return dest->write(dest->priv, data, size);
+}
+
+int esp32_apptrace_dest_flush(struct esp32_apptrace_dest *dest)
+{
+	if (!dest->buf_len)
+		return ERROR_OK;
+
+	uint32_t len = dest->buf_len;
+	dest->buf_len = 0;
+	return esp32_apptrace_dest_write_direct(dest, dest->buf, len);
+}
+
+/* Write @a count pieces of data as one unit, e.g. a SystemView packet body
+ * followed by its rewritten timestamp delta. */
+int esp32_apptrace_dest_writev(struct esp32_apptrace_dest *dest, uint8_t *bufs[], const uint32_t lens[],
+	unsigned int count)
+{
+	uint32_t total = 0;
+
+	for (unsigned int i = 0; i < count; i++)
+		total += lens[i];
+
+	if (dest->buf && dest->buf_len + total > dest->buf_size) {
+		int res = esp32_apptrace_dest_flush(dest);
+		if (res != ERROR_OK)
 			return res;
+	}
+	if (!dest->buf || total > dest->buf_size) {
+		/* not buffered or too large to be buffered */
+		for (unsigned int i = 0; i < count; i++) {
+			if (!lens[i])
+				continue;
+			int res = esp32_apptrace_dest_write_direct(dest, bufs[i], lens[i]);
+			if (res != ERROR_OK)
+				return res;
 		}
+		return ERROR_OK;
+	}
+
+	if (!dest->buf_len)
+		dest->buf_time = timeval_ms();
+	for (unsigned int i = 0; i < count; i++) {
+		memcpy(dest->buf + dest->buf_len, bufs[i], lens[i]);
+		dest->buf_len += lens[i];
 	}
+	if (dest->buf_len == dest->buf_size)
+		return esp32_apptrace_dest_flush(dest);
 	return ERROR_OK;
 }
 
+int esp32_apptrace_dest_write(struct esp32_apptrace_dest *dest, uint8_t *data, uint32_t size)
+{
+	return esp32_apptrace_dest_writev(dest, &data, &size, 1);
+}
+
 /*********************************************************************
 *                 Trace data blocks management API
 **********************************************************************/
@@ -505,10 +605,11 @@ int esp32_apptrace_cmd_ctx_init(struct esp32_apptrace_cmd_ctx *cmd_ctx, struct c
 
 	cmd_ctx->running = 1;
 	if (cmd_ctx->mode != ESP_APPTRACE_CMD_MODE_SYNC) {
-		int res = target_register_timer_callback(esp32_apptrace_data_processor,
+		int res = target_register_named_timer_callback(esp32_apptrace_data_processor,
 			0,
 			TARGET_TIMER_TYPE_PERIODIC,
-			cmd_ctx);
+			cmd_ctx,
+			"esp.apptrace.process");
 		if (res != ERROR_OK) {
 			command_print(cmd, "Failed to start trace data timer callback (%d)!", res);
 			esp32_apptrace_blocks_pool_cleanup(cmd_ctx);
@@ -647,10 +748,51 @@ static int esp32_apptrace_cmd_cleanup(struct esp32_apptrace_cmd_ctx *cmd_ctx)
 	return ERROR_OK;
 }
 
+static inline bool is_sysview_mode(int mode)
+{
+	return mode == ESP_APPTRACE_CMD_MODE_SYSVIEW;
+}
+
+static unsigned int esp32_apptrace_dests_get(struct esp32_apptrace_cmd_ctx *ctx, struct esp32_apptrace_dest **dests)
+{
+	if (!ctx->cmd_priv)
+		return 0;
+	if (is_sysview_mode(ctx->mode)) {
+		*dests = ((struct esp32_sysview_cmd_data *)ctx->cmd_priv)->data_dests;
+		return ctx->cores_num;
+	}
+	*dests = &((struct esp32_apptrace_cmd_data *)ctx->cmd_priv)->data_dest;
+	return 1;
+}
+
+/* pass buffered data to destinations, only those buffered for too long unless @a force is set */
+static int esp32_apptrace_dests_flush(struct esp32_apptrace_cmd_ctx *ctx, bool force)
+{
+	struct esp32_apptrace_dest *dests;
+	unsigned int dests_num = esp32_apptrace_dests_get(ctx, &dests);
+	int64_t now = timeval_ms();
+
+	for (unsigned int i = 0; i < dests_num; i++) {
+		if (!dests[i].buf_len)
+			continue;
+		if (!force && now - dests[i].buf_time < ESP32_APPTRACE_DEST_FLUSH_TMO)
+			continue;
+		int res = esp32_apptrace_dest_flush(&dests[i]);
+		if (res != ERROR_OK) {
+			LOG_ERROR("apptrace: Failed to write buffered data to dest %u!", i);
+			return res;
+		}
+	}
+	return ERROR_OK;
+}
+
 static void esp32_apptrace_print_stats(struct esp32_apptrace_cmd_ctx *ctx)
 {
 	struct esp32_apptrace_cmd_data *cmd_data = ctx->cmd_priv;
+	struct esp32_apptrace_dest *dests;
+	unsigned int dests_num = esp32_apptrace_dests_get(ctx, &dests);
 	uint32_t trace_sz = 0;
+	uint32_t writes = 0;
 
 	if (cmd_data)
 		trace_sz = ctx->tot_len > cmd_data->skip_len ? ctx->tot_len - cmd_data->skip_len : 0;
@@ -663,6 +805,16 @@ static void esp32_apptrace_print_stats(struct esp32_apptrace_cmd_ctx *ctx)
 	LOG_USER("Data: blocks incomplete %" PRId32 ", lost bytes: %" PRId32,
 		ctx->stats.incompl_blocks,
 		ctx->stats.lost_bytes);
+	for (unsigned int i = 0; i < dests_num; i++)
+		writes += dests[i].writes;
+	float read_time = duration_elapsed(&ctx->read_time);
+	LOG_USER("Blocks: %" PRIu32 " @ %f/s, events: %" PRIu32 " @ %f/s, dest writes: %" PRIu32 " @ %f/s",
+		ctx->stats.blocks,
+		read_time > 0 ? ctx->stats.blocks / read_time : 0,
+		ctx->stats.events,
+		read_time > 0 ? ctx->stats.events / read_time : 0,
+		writes,
+		read_time > 0 ? writes / read_time : 0);
 	if (s_time_stats_enable) {
 		LOG_USER("Block read time [%f..%f] ms",
 			1000 * ctx->stats.min_blk_read_time,
@@ -892,12 +1044,30 @@ static int esp32_apptrace_get_data_info(struct esp32_apptrace_cmd_ctx *ctx,
 	if (fired_target_num)
 		*fired_target_num = UINT32_MAX;
 
-	for (unsigned int i = 0; i < ctx->cores_num; i++) {
-		int res = ctx->hw->data_len_read(ctx->cpus[i], &target_state[i].block_id, &target_state[i].data_len);
+	if (ctx->hw->data_len_read_multi && ctx->cores_num > 1) {
+		uint32_t block_id[ESP32_APPTRACE_MAX_CORES_NUM];
+		uint32_t len[ESP32_APPTRACE_MAX_CORES_NUM];
+
+		int res = ctx->hw->data_len_read_multi(ctx->cpus, ctx->cores_num, block_id, len);
 		if (res != ERROR_OK) {
-			LOG_TARGET_ERROR(ctx->cpus[i], "Failed to read data len!");
+			LOG_ERROR("Failed to read data len!");
 			return res;
 		}
+		for (unsigned int i = 0; i < ctx->cores_num; i++) {
+			target_state[i].block_id = block_id[i];
+			target_state[i].data_len = len[i];
+		}
+	}
+
+	for (unsigned int i = 0; i < ctx->cores_num; i++) {
+		if (!ctx->hw->data_len_read_multi || ctx->cores_num == 1) {
+			int res = ctx->hw->data_len_read(ctx->cpus[i], &target_state[i].block_id,
+				&target_state[i].data_len);
+			if (res != ERROR_OK) {
+				LOG_TARGET_ERROR(ctx->cpus[i], "Failed to read data len!");
+				return res;
+			}
+		}
 		if (target_state[i].data_len) {
 			LOG_TARGET_DEBUG(ctx->cpus[i], "Block %" PRId32 ", len %" PRId32 " bytes on fired",
 				target_state[i].block_id, target_state[i].data_len);
@@ -927,7 +1097,7 @@ static int esp32_apptrace_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 		if (ctx->tot_len + wr_chunk_len > cmd_data->max_len)
 			wr_chunk_len -= (ctx->tot_len + wr_chunk_len - cmd_data->skip_len) - cmd_data->max_len;
 		if (wr_chunk_len > 0) {
-			int res = cmd_data->data_dest.write(cmd_data->data_dest.priv, data + wr_idx, wr_chunk_len);
+			int res = esp32_apptrace_dest_write(&cmd_data->data_dest, data + wr_idx, wr_chunk_len);
 			if (res != ERROR_OK) {
 				LOG_ERROR("Failed to write %" PRId32 " bytes to dest 0!", data_len);
 				return res;
@@ -1054,36 +1224,15 @@ static int esp32_apptrace_check_connection(struct esp32_apptrace_cmd_ctx *ctx)
 	return ERROR_OK;
 }
 
-static int esp32_apptrace_poll(void *priv)
+/* read one block of trace data if there is any, @a got_data tells whether it was read */
+static int esp32_apptrace_read_block(struct esp32_apptrace_cmd_ctx *ctx, bool *got_data)
 {
-	struct esp32_apptrace_cmd_ctx *ctx = (struct esp32_apptrace_cmd_ctx *)priv;
 	int res;
 	uint32_t fired_target_num = 0;
 	struct esp32_apptrace_target_state target_state[ESP32_APPTRACE_MAX_CORES_NUM];
 	struct duration blk_proc_time;
 
-	if (!ctx->running) {
-		if (ctx->auto_clean)
-			ctx->auto_clean(ctx);
-		return ERROR_FAIL;
-	}
-
-	/* Check if re-initialization is needed due to the target resetting between data transfers. */
-	if (ctx->hw->apptrace_is_inited) {
-		for (unsigned int i = 0; i < ctx->cores_num; i++) {
-			if (!ctx->hw->apptrace_is_inited(ctx->cpus[i]))
-				return ERROR_WAIT;
-		}
-	}
-
-	/*  Check for connection is alive.For some reason target and therefore host_connected flag
-	 *  might have been reset */
-	res = esp32_apptrace_check_connection(ctx);
-	if (res != ERROR_OK) {
-		if (res != ERROR_WAIT)
-			ctx->running = 0;
-		return res;
-	}
+	*got_data = false;
 
 	/* check for data from target */
 	res = esp32_apptrace_get_data_info(ctx, target_state, &fired_target_num);
@@ -1181,6 +1330,8 @@ static int esp32_apptrace_poll(void *priv)
 	ctx->last_blk_id = target_state[fired_target_num].block_id;
 	block->data_len = target_state[fired_target_num].data_len;
 	ctx->raw_tot_len += block->data_len;
+	ctx->stats.blocks++;
+	*got_data = true;
 	if (s_time_stats_enable) {
 		if (duration_measure(&blk_proc_time) != 0) {
 			ctx->running = 0;
@@ -1262,9 +1413,74 @@ static int esp32_apptrace_poll(void *priv)
 	return ERROR_OK;
 }
 
-static inline bool is_sysview_mode(int mode)
+static int esp32_apptrace_poll_again(void *priv)
 {
-	return mode == ESP_APPTRACE_CMD_MODE_SYSVIEW;
+	struct esp32_apptrace_cmd_ctx *ctx = (struct esp32_apptrace_cmd_ctx *)priv;
+
+	ctx->poll_again = false;
+	/* stopped tracing is cleaned up by the periodic poll */
+	if (!ctx->running)
+		return ERROR_OK;
+	return esp32_apptrace_poll(priv);
+}
+
+static int esp32_apptrace_poll(void *priv)
+{
+	struct esp32_apptrace_cmd_ctx *ctx = (struct esp32_apptrace_cmd_ctx *)priv;
+	int res;
+
+	if (!ctx->running) {
+		if (ctx->auto_clean)
+			ctx->auto_clean(ctx);
+		return ERROR_FAIL;
+	}
+
+	res = esp32_apptrace_dests_flush(ctx, false);
+	if (res != ERROR_OK) {
+		ctx->running = 0;
+		return res;
+	}
+
+	/* Check if re-initialization is needed due to the target resetting between data transfers. */
+	if (ctx->hw->apptrace_is_inited) {
+		for (unsigned int i = 0; i < ctx->cores_num; i++) {
+			if (!ctx->hw->apptrace_is_inited(ctx->cpus[i]))
+				return ERROR_WAIT;
+		}
+	}
+
+	/*  Check for connection is alive.For some reason target and therefore host_connected flag
+	 *  might have been reset */
+	res = esp32_apptrace_check_connection(ctx);
+	if (res != ERROR_OK) {
+		if (res != ERROR_WAIT)
+			ctx->running = 0;
+		return res;
+	}
+
+	/* Read all blocks the cores have filled in the meantime instead of one per poll period,
+	 * otherwise the target waits for the host while the other block is ready. */
+	for (unsigned int i = 0; i < ESP32_APPTRACE_POLL_BLOCKS_MAX; i++) {
+		if (ctx->mode != ESP_APPTRACE_CMD_MODE_SYNC && list_empty(&ctx->free_trace_blocks)) {
+			/* all blocks wait for processing, handle the oldest one to free it */
+			res = esp32_apptrace_data_processor(ctx);
+			if (res != ERROR_OK)
+				return res;
+		}
+		bool got_data;
+		res = esp32_apptrace_read_block(ctx, &got_data);
+		if (res != ERROR_OK || !got_data || !ctx->running)
+			return res;
+	}
+
+	/* data keep coming, do not wait for the next poll period */
+	if (!ctx->poll_again) {
+		res = target_register_named_timer_callback(esp32_apptrace_poll_again, 0, TARGET_TIMER_TYPE_ONESHOT,
+			ctx, "esp.apptrace.poll_again");
+		if (res == ERROR_OK)
+			ctx->poll_again = true;
+	}
+	return ERROR_OK;
 }
 
 static void esp32_apptrace_cmd_stop(struct esp32_apptrace_cmd_ctx *ctx)
@@ -1274,6 +1490,10 @@ static void esp32_apptrace_cmd_stop(struct esp32_apptrace_cmd_ctx *ctx)
 	int res = target_unregister_timer_callback(esp32_apptrace_poll, ctx);
 	if (res != ERROR_OK)
 		LOG_ERROR("Failed to unregister target timer handler (%d)!", res);
+	if (ctx->poll_again) {
+		target_unregister_timer_callback(esp32_apptrace_poll_again, ctx);
+		ctx->poll_again = false;
+	}
 	if (is_sysview_mode(ctx->mode)) {
 		/* stop tracing */
 		res = esp32_sysview_stop(ctx);
@@ -1476,6 +1696,10 @@ static int esp32_sysview_stop(struct esp32_apptrace_cmd_ctx *ctx)
 		}
 	}
 
+	int flush_res = esp32_apptrace_dests_flush(ctx, true);
+	if (flush_res != ERROR_OK)
+		res = flush_res;
+
 	if (cmd_data->multicore_fd > 0) {
 		res = esp32_sysview_combine_files(cmd_data->multicore_fd,
 			((struct esp32_apptrace_dest_file_data *)cmd_data->data_dests[0].priv)->fout,
@@ -1586,10 +1810,11 @@ static int esp32_cmd_apptrace_generic(struct command_invocation *cmd, int mode,
 				return res;
 			}
 		}
-		res = target_register_timer_callback(esp32_apptrace_poll,
+		res = target_register_named_timer_callback(esp32_apptrace_poll,
 			cmd_data->poll_period,
 			TARGET_TIMER_TYPE_PERIODIC,
-			&s_at_cmd_ctx);
+			&s_at_cmd_ctx,
+			"esp.apptrace.poll");
 		if (res != ERROR_OK) {
 			command_print(cmd, "Failed to register target timer handler (%d)!", res);
 			goto _on_start_error;
@@ -1732,6 +1957,40 @@ _run_sysview_mode:
 	return esp32_cmd_apptrace_generic(CMD, ESP_APPTRACE_CMD_MODE_SYSVIEW, CMD_ARGV, CMD_ARGC);
 }
 
+COMMAND_HANDLER(esp32_cmd_sysview_store)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		const char *path = strcmp(CMD_ARGV[0], "off") == 0 ? NULL : CMD_ARGV[0];
+		if (esp32_sysview_store_path_set(path) != ERROR_OK) {
+			command_print(CMD, "Failed to set events store path!");
+			return ERROR_FAIL;
+		}
+	}
+	const char *path = esp32_sysview_store_path_get();
+	command_print(CMD, "%s", path ? path : "off");
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(esp32_cmd_sysview_export)
+{
+	uint64_t start_us = 0, end_us = UINT64_MAX;
+
+	if (CMD_ARGC < 2 || CMD_ARGC > 4)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC > 2)
+		COMMAND_PARSE_NUMBER(u64, CMD_ARGV[2], start_us);
+	if (CMD_ARGC > 3)
+		COMMAND_PARSE_NUMBER(u64, CMD_ARGV[3], end_us);
+	if (start_us > end_us) {
+		command_print(CMD, "Start time is greater than end time!");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+	return esp_sysview_store_export(CMD, CMD_ARGV[0], CMD_ARGV[1], start_us, end_us);
+}
+
 static int esp_gcov_cmd_init(struct esp32_apptrace_cmd_ctx *cmd_ctx,
 	struct command_invocation *cmd,
 	char *prefix,
@@ -1770,6 +2029,11 @@ static int esp_gcov_cmd_cleanup(struct esp32_apptrace_cmd_ctx *cmd_ctx)
 			LOG_ERROR("Failed to close file 0x%p (%d)!", cmd_data->files[i], errno);
 			res = ERROR_FAIL;
 		}
+		if (cmd_data->cached[i] && fclose(cmd_data->cached[i])) {
+			LOG_ERROR("Failed to close file 0x%p (%d)!", cmd_data->cached[i], errno);
+			res = ERROR_FAIL;
+		}
+		free(cmd_data->paths[i]);
 	}
 	free(cmd_data->prefix);
 	free(cmd_data);
@@ -1853,6 +2117,51 @@ static char *esp_gcov_filename_alloc(struct esp32_gcov_cmd_data *cmd_data, const
 	return filename;
 }
 
+/* Looks for the file closed by target, but still open on host.
+ * @return slot index or -1 if the file needs to be opened */
+static int esp_gcov_file_cache_get(struct esp32_gcov_cmd_data *cmd_data, const char *fname, const char *mode)
+{
+	for (unsigned int i = 0; i < ESP_GCOV_FILES_MAX_NUM; i++) {
+		if (!cmd_data->cached[i] || strcmp(cmd_data->paths[i], fname) != 0)
+			continue;
+		FILE *f = cmd_data->cached[i];
+		cmd_data->cached[i] = NULL;
+		if (strcmp(cmd_data->modes[i], mode) != 0) {
+			fclose(f);
+			return -1;
+		}
+		/* emulate fresh fopen() with the same mode */
+		rewind(f);
+		if (mode[0] == 'w' && ftruncate(fileno(f), 0) != 0) {
+			fclose(f);
+			return -1;
+		}
+		if (mode[0] == 'a')
+			fseek(f, 0, SEEK_END);
+		cmd_data->files[i] = f;
+		return i;
+	}
+	return -1;
+}
+
+static int esp_gcov_file_slot_alloc(struct esp32_gcov_cmd_data *cmd_data)
+{
+	int cached = -1;
+
+	for (unsigned int i = 0; i < ESP_GCOV_FILES_MAX_NUM; i++) {
+		if (!cmd_data->files[i] && !cmd_data->cached[i])
+			return i;
+		if (cached < 0 && cmd_data->cached[i])
+			cached = i;
+	}
+	if (cached >= 0) {
+		/* evict the file which is not used by target */
+		fclose(cmd_data->cached[cached]);
+		cmd_data->cached[cached] = NULL;
+	}
+	return cached;
+}
+
 static int esp_gcov_fopen(struct target *target,
 	struct esp32_gcov_cmd_data *cmd_data,
 	uint8_t *data,
@@ -1862,10 +2171,6 @@ static int esp_gcov_fopen(struct target *target,
 {
 	char *cdata = (char *)data;
 	*resp_len = 0;
-	if (cmd_data->files_num == ESP_GCOV_FILES_MAX_NUM) {
-		LOG_ERROR("Max gcov files num exceeded!");
-		return ERROR_FAIL;
-	}
 
 	if (data_len == 0) {
 		LOG_ERROR("Missed FOPEN args!");
@@ -1881,39 +2186,59 @@ static int esp_gcov_fopen(struct target *target,
 		return ERROR_FAIL;
 	}
 
-	uint32_t fd = cmd_data->files_num;
 	char *mode = cdata + len + 1;
+	if (strlen(mode) >= ESP_GCOV_FILE_MODE_MAX) {
+		LOG_ERROR("Invalid FOPEN mode arg '%s'!", mode);
+		return ERROR_FAIL;
+	}
 	char *fname = esp_gcov_filename_alloc(cmd_data, cdata);
 	if (!fname) {
 		LOG_ERROR("Failed to alloc memory for file name!");
 		return ERROR_FAIL;
 	}
-	LOG_INFO("Open file 0x%x '%s' mode '%s'", fd + 1, fname, mode);
-	cmd_data->files[fd] = fopen(fname, mode);
-	if (!cmd_data->files[fd]) {
-		/* do not report error on reading non-existent file */
-		if (errno != ENOENT || !strchr(mode, 'r'))
-			LOG_ERROR("Failed to open file '%s', mode '%s' (%d)!", fname, mode, errno);
-		errno = 0;
-		fd = 0;
+
+	uint32_t fd;
+	int slot = esp_gcov_file_cache_get(cmd_data, fname, mode);
+	if (slot >= 0) {
+		fd = slot + 1;
+		LOG_INFO("Reopen file 0x%x '%s' mode '%s'", fd, fname, mode);
+		free(fname);
 	} else {
-		fd++;	/* 1-based, 0 indicates error */
+		slot = esp_gcov_file_slot_alloc(cmd_data);
+		if (slot < 0) {
+			LOG_ERROR("Max gcov files num exceeded!");
+			free(fname);
+			return ERROR_FAIL;
+		}
+		LOG_INFO("Open file 0x%x '%s' mode '%s'", slot + 1, fname, mode);
+		cmd_data->files[slot] = fopen(fname, mode);
+		if (!cmd_data->files[slot]) {
+			/* do not report error on reading non-existent file */
+			if (errno != ENOENT || !strchr(mode, 'r'))
+				LOG_ERROR("Failed to open file '%s', mode '%s' (%d)!", fname, mode, errno);
+			errno = 0;
+			fd = 0;
+			free(fname);
+		} else {
+			fd = slot + 1;	/* 1-based, 0 indicates error */
+			setvbuf(cmd_data->files[slot], NULL, _IOFBF, ESP_GCOV_FILE_BUF_SZ);
+			free(cmd_data->paths[slot]);
+			cmd_data->paths[slot] = fname;
+			strcpy(cmd_data->modes[slot], mode);
+		}
 	}
 	*resp_len = sizeof(fd);
 	*resp = malloc(*resp_len);
 	if (!*resp) {
 		LOG_ERROR("Failed to alloc mem for resp!");
-		if (fd != 0)
+		if (fd != 0) {
 			fclose(cmd_data->files[fd - 1]);
-		free(fname);
+			cmd_data->files[fd - 1] = NULL;
+		}
 		return ERROR_FAIL;
 	}
 	target_buffer_set_u32(target, *resp, fd);
 
-	if (fd != 0)
-		cmd_data->files_num++;
-
-	free(fname);
 	return ERROR_OK;
 }
 
@@ -1942,11 +2267,14 @@ static int esp_gcov_fclose(struct target *target,
 		return ERROR_FAIL;
 	}
 
-	int32_t fret = fclose(cmd_data->files[fd]);
-	if (fret)
+	/* keep the file open for the case target opens it again, but make its data visible */
+	int32_t fret = fflush(cmd_data->files[fd]);
+	if (fret) {
 		LOG_ERROR("Failed to close file %d (%d)!", fd, errno);
-	else
+	} else {
+		cmd_data->cached[fd] = cmd_data->files[fd];
 		cmd_data->files[fd] = NULL;
+	}
 
 	*resp_len = sizeof(fret);
 	*resp = malloc(*resp_len);
@@ -2156,62 +2484,141 @@ static int esp_gcov_feof(struct target *target,
 
 static const char *apptrace_file_cmd_to_str(const uint8_t cmd)
 {
-	static const char *const commands[] = {"FOPEN", "FCLOSE", "FWRITE", "FREAD", "FSEEK", "FTELL", "FSTOP", "FEOF"};
+	static const char *const commands[] = {"FOPEN", "FCLOSE", "FWRITE", "FREAD", "FSEEK", "FTELL", "FSTOP", "FEOF",
+		"FBATCH"};
 
-	if (cmd > ESP_APPTRACE_FILE_CMD_FEOF)
+	if (cmd > ESP_APPTRACE_FILE_CMD_BATCH)
 		return "<unknown>";
 	return commands[cmd];
 }
 
-/*TODO: support for multi-block data transfers */
-static int esp_gcov_process_data(struct esp32_apptrace_cmd_ctx *ctx,
+static int esp_gcov_file_cmd_do(struct esp32_apptrace_cmd_ctx *ctx,
 	unsigned int core_id,
+	uint8_t cmd,
 	uint8_t *data,
-	uint32_t data_len)
+	uint32_t data_len,
+	uint8_t **resp,
+	uint32_t *resp_len)
 {
-	int ret = ERROR_OK;
 	struct esp32_gcov_cmd_data *cmd_data = ctx->cmd_priv;
-	uint8_t *resp;
-	uint32_t resp_len = 0;
+	struct target *target = ctx->cpus[core_id];
 
-	LOG_TARGET_DEBUG(ctx->cpus[core_id], "Got block %d bytes [%x %x]", data_len, data[0], data[1]);
+	LOG_TARGET_DEBUG(target, "Apptrace FCMD=0x%x (%s)", cmd, apptrace_file_cmd_to_str(cmd));
 
-	if (data_len < 1) {
-		LOG_ERROR("Too small data length %d!", data_len);
-		return ERROR_FAIL;
-	}
-
-	LOG_TARGET_DEBUG(ctx->cpus[core_id], "Apptrace FCMD=0x%x (%s)", *data, apptrace_file_cmd_to_str(*data));
-
-	switch (*data) {
+	*resp_len = 0;
+	switch (cmd) {
 	case ESP_APPTRACE_FILE_CMD_FOPEN:
-		ret = esp_gcov_fopen(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_fopen(target, cmd_data, data, data_len, resp, resp_len);
 	case ESP_APPTRACE_FILE_CMD_FCLOSE:
-		ret = esp_gcov_fclose(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_fclose(target, cmd_data, data, data_len, resp, resp_len);
 	case ESP_APPTRACE_FILE_CMD_FWRITE:
-		ret = esp_gcov_fwrite(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_fwrite(target, cmd_data, data, data_len, resp, resp_len);
 	case ESP_APPTRACE_FILE_CMD_FREAD:
-		ret = esp_gcov_fread(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_fread(target, cmd_data, data, data_len, resp, resp_len);
 	case ESP_APPTRACE_FILE_CMD_FSEEK:
-		ret = esp_gcov_fseek(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_fseek(target, cmd_data, data, data_len, resp, resp_len);
 	case ESP_APPTRACE_FILE_CMD_FTELL:
-		ret = esp_gcov_ftell(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_ftell(target, cmd_data, data, data_len, resp, resp_len);
 	case ESP_APPTRACE_FILE_CMD_STOP:
 		ctx->running = 0;
-		break;
+		return ERROR_OK;
 	case ESP_APPTRACE_FILE_CMD_FEOF:
-		ret = esp_gcov_feof(ctx->cpus[core_id], cmd_data, data + 1, data_len - 1, &resp, &resp_len);
-		break;
+		return esp_gcov_feof(target, cmd_data, data, data_len, resp, resp_len);
 	default:
-		LOG_TARGET_ERROR(ctx->cpus[core_id], "Invalid FCMD 0x%x!", *data);
-		ret = ERROR_FAIL;
+		LOG_TARGET_ERROR(target, "Invalid FCMD 0x%x!", cmd);
+		return ERROR_FAIL;
+	}
+}
+
+/* Handles several file commands packed by target in one block, every command is
+ * [cmd (1 byte)][args length (2 bytes)][args]. Responses are sent back in one block,
+ * every response is [length (2 bytes)][data], commands w/o response get zero length. */
+static int esp_gcov_fbatch(struct esp32_apptrace_cmd_ctx *ctx,
+	unsigned int core_id,
+	uint8_t *data,
+	uint32_t data_len,
+	uint8_t **resp,
+	uint32_t *resp_len)
+{
+	struct target *target = ctx->cpus[core_id];
+	uint32_t max_len = ctx->hw->usr_block_max_size_get(target);
+	uint8_t *batch_resp = malloc(max_len);
+	uint32_t batch_len = 0;
+	uint32_t cmds_num = 0;
+
+	*resp_len = 0;
+	if (!batch_resp) {
+		LOG_ERROR("Failed to alloc mem for resp!");
+		return ERROR_FAIL;
+	}
+
+	while (data_len > 0) {
+		if (data_len < 3) {
+			LOG_TARGET_ERROR(target, "Truncated FBATCH command!");
+			free(batch_resp);
+			return ERROR_FAIL;
+		}
+		uint8_t cmd = data[0];
+		uint32_t args_len = target_buffer_get_u16(target, data + 1);
+		if (args_len > data_len - 3 || cmd == ESP_APPTRACE_FILE_CMD_BATCH) {
+			LOG_TARGET_ERROR(target, "Invalid FBATCH command 0x%x, %" PRIu32 " bytes!", cmd, args_len);
+			free(batch_resp);
+			return ERROR_FAIL;
+		}
+
+		uint8_t *cmd_resp = NULL;
+		uint32_t cmd_resp_len = 0;
+		int ret = esp_gcov_file_cmd_do(ctx, core_id, cmd, data + 3, args_len, &cmd_resp, &cmd_resp_len);
+		if (ret != ERROR_OK) {
+			free(batch_resp);
+			return ret;
+		}
+		if (batch_len + sizeof(uint16_t) + cmd_resp_len > max_len) {
+			LOG_TARGET_ERROR(target, "FBATCH responses do not fit in %" PRIu32 " bytes block!", max_len);
+			free(cmd_resp);
+			free(batch_resp);
+			return ERROR_FAIL;
+		}
+		target_buffer_set_u16(target, batch_resp + batch_len, cmd_resp_len);
+		batch_len += sizeof(uint16_t);
+		if (cmd_resp_len) {
+			memcpy(batch_resp + batch_len, cmd_resp, cmd_resp_len);
+			batch_len += cmd_resp_len;
+			free(cmd_resp);
+		}
+		data += 3 + args_len;
+		data_len -= 3 + args_len;
+		cmds_num++;
+	}
+	LOG_TARGET_DEBUG(target, "Processed %" PRIu32 " batched commands, resp %" PRIu32 " bytes", cmds_num, batch_len);
+	*resp = batch_resp;
+	*resp_len = batch_len;
+	if (batch_len == 0)
+		free(batch_resp);
+	return ERROR_OK;
+}
+
+/*TODO: support for multi-block data transfers */
+static int esp_gcov_process_data(struct esp32_apptrace_cmd_ctx *ctx,
+	unsigned int core_id,
+	uint8_t *data,
+	uint32_t data_len)
+{
+	int ret = ERROR_OK;
+	uint8_t *resp;
+	uint32_t resp_len = 0;
+
+	if (data_len < 1) {
+		LOG_ERROR("Too small data length %d!", data_len);
+		return ERROR_FAIL;
 	}
+
+	LOG_TARGET_DEBUG(ctx->cpus[core_id], "Got block %d bytes [%x]", data_len, data[0]);
+
+	if (*data == ESP_APPTRACE_FILE_CMD_BATCH)
+		ret = esp_gcov_fbatch(ctx, core_id, data + 1, data_len - 1, &resp, &resp_len);
+	else
+		ret = esp_gcov_file_cmd_do(ctx, core_id, *data, data + 1, data_len - 1, &resp, &resp_len);
 	if (ret != ERROR_OK)
 		return ret;
 
@@ -2472,6 +2879,22 @@ const struct command_registration esp32_apptrace_command_handlers[] = {
 		.usage =
 			"(start file://<outfile> [poll_period [trace_size [stop_tmo [wait4halt [skip_size]]]]) | (stop) | (status)",
 	},
+	{
+		.name = "sysview_store",
+		.handler = esp32_cmd_sysview_store,
+		.mode = COMMAND_ANY,
+		.help =
+			"App Tracing: set or query the file to store decoded SystemView events in while tracing.",
+		.usage = "[<file>|off]",
+	},
+	{
+		.name = "sysview_export",
+		.handler = esp32_cmd_sysview_export,
+		.mode = COMMAND_ANY,
+		.help =
+			"App Tracing: export SystemView events from store file to Chrome/Perfetto trace JSON.",
+		.usage = "<store_file> <json_file> [<start_us> [<end_us>]]",
+	},
 	{
 		.name = "gcov",
 		.handler = esp32_cmd_gcov,
@@ -30,6 +30,11 @@ struct esp32_apptrace_hw {
 	int (*data_len_read)(struct target *target,
 		uint32_t *block_id,
 		uint32_t *len);
+	/* optional, reads data len of several cores using one JTAG queue execution */
+	int (*data_len_read_multi)(struct target *targets[],
+		unsigned int targets_num,
+		uint32_t block_id[],
+		uint32_t len[]);
 	int (*data_read)(struct target *target,
 		uint32_t size,
 		uint8_t *buffer,
@@ -57,6 +62,14 @@ struct esp32_apptrace_dest {
 	int (*write)(void *priv, uint8_t *data, int size);
 	int (*clean)(void *priv);
 	bool log_progress;
+	/* coalescing buffer, data are passed to write() directly when it is NULL */
+	uint8_t *buf;
+	uint32_t buf_size;
+	uint32_t buf_len;
+	/* time in ms when the oldest buffered data were added */
+	int64_t buf_time;
+	/* number of calls to write() */
+	uint32_t writes;
 };
 
 struct esp32_apptrace_format {
@@ -72,6 +85,10 @@ struct esp32_apptrace_cmd_stats {
 	float max_blk_read_time;
 	float min_blk_proc_time;
 	float max_blk_proc_time;
+	/* trace blocks read from the target */
+	uint32_t blocks;
+	/* events parsed from the blocks, only counted by decoding modes (sysview) */
+	uint32_t events;
 };
 
 struct esp32_apptrace_cmd_ctx {
@@ -97,6 +114,8 @@ struct esp32_apptrace_cmd_ctx {
 	struct esp32_apptrace_cmd_stats stats;
 	struct duration read_time;
 	struct duration idle_time;
+	/* set while an immediate re-poll is scheduled */
+	bool poll_again;
 	void *cmd_priv;
 	struct target *target;
 	struct command_invocation *cmd;
@@ -118,6 +137,11 @@ void esp32_apptrace_cmd_args_parse(struct esp32_apptrace_cmd_ctx *cmd_ctx,
 	int argc);
 int esp32_apptrace_dest_init(struct esp32_apptrace_dest dest[], const char *dest_paths[], unsigned int max_dests);
 int esp32_apptrace_dest_cleanup(struct esp32_apptrace_dest dest[], unsigned int max_dests);
+int esp32_apptrace_dest_buf_init(struct esp32_apptrace_dest *dest, uint32_t size);
+int esp32_apptrace_dest_writev(struct esp32_apptrace_dest *dest, uint8_t *bufs[], const uint32_t lens[],
+	unsigned int count);
+int esp32_apptrace_dest_write(struct esp32_apptrace_dest *dest, uint8_t *data, uint32_t size);
+int esp32_apptrace_dest_flush(struct esp32_apptrace_dest *dest);
 int esp_apptrace_usr_block_write(const struct esp32_apptrace_hw *hw, struct target *target,
 	uint32_t block_id,
 	const uint8_t *data,
@@ -13,11 +13,14 @@
 #include "esp32_apptrace.h"
 #include "esp32_sysview.h"
 #include "segger_sysview.h"
+#include "esp32_sysview_store.h"
 
 /* in SystemView mode core ID is passed in event ID field */
 #define ESP32_SYSVIEW_USER_BLOCK_CORE(_v_)  (0)	/* not used */
 #define ESP32_SYSVIEW_USER_BLOCK_LEN(_v_)   (_v_)
 #define ESP32_SYSVIEW_USER_BLOCK_HDR_SZ     2
+/* size of the buffer collecting packets for every trace data destination */
+#define ESP32_SYSVIEW_DEST_BUF_SZ           (64 * 1024)
 
 struct esp_sysview_target2host_hdr {
 	uint8_t block_sz;
@@ -28,10 +31,32 @@ struct esp_sysview_target2host_hdr {
 
 #define SYNC_BYTES_COUNT                10
 
+/* path of the decoded events store, NULL if disabled */
+static char *s_store_path;
+
 static int esp_sysview_trace_header_write(struct esp32_apptrace_cmd_ctx *ctx);
 static int esp32_sysview_core_id_get(struct target *target, uint8_t *hdr_buf);
 static uint32_t esp32_sysview_usr_block_len_get(struct target *target, uint8_t *hdr_buf, uint32_t *wr_len);
 
+int esp32_sysview_store_path_set(const char *path)
+{
+	char *new_path = NULL;
+
+	if (path) {
+		new_path = strdup(path);
+		if (!new_path)
+			return ERROR_FAIL;
+	}
+	free(s_store_path);
+	s_store_path = new_path;
+	return ERROR_OK;
+}
+
+const char *esp32_sysview_store_path_get(void)
+{
+	return s_store_path;
+}
+
 int esp32_sysview_cmd_init(struct esp32_apptrace_cmd_ctx *cmd_ctx,
 	struct command_invocation *cmd,
 	int mode,
@@ -73,6 +98,14 @@ int esp32_sysview_cmd_init(struct esp32_apptrace_cmd_ctx *cmd_ctx,
 		res = ERROR_FAIL;
 		goto on_error;
 	}
+	for (int i = 0; i < core_num; i++) {
+		res = esp32_apptrace_dest_buf_init(&cmd_data->data_dests[i], ESP32_SYSVIEW_DEST_BUF_SZ);
+		if (res != ERROR_OK) {
+			esp32_apptrace_dest_cleanup(cmd_data->data_dests, core_num);
+			free(cmd_data);
+			goto on_error;
+		}
+	}
 	cmd_data->apptrace.max_len = UINT32_MAX;
 	cmd_data->apptrace.poll_period = 0 /*ms*/;
 	cmd_ctx->stop_tmo = -1.0;	/* infinite */
@@ -103,6 +136,11 @@ int esp32_sysview_cmd_init(struct esp32_apptrace_cmd_ctx *cmd_ctx,
 		free(cmd_data);
 		return res;
 	}
+	if (s_store_path) {
+		cmd_data->store = esp_sysview_store_open(s_store_path, core_num);
+		if (!cmd_data->store)
+			command_print(cmd, "Failed to open events store '%s', continue without it", s_store_path);
+	}
 	return ERROR_OK;
 on_error:
 	cmd_ctx->running = 0;
@@ -114,6 +152,7 @@ int esp32_sysview_cmd_cleanup(struct esp32_apptrace_cmd_ctx *cmd_ctx)
 {
 	struct esp32_sysview_cmd_data *cmd_data = cmd_ctx->cmd_priv;
 
+	esp_sysview_store_close(cmd_data->store);
 	esp32_apptrace_dest_cleanup(cmd_data->data_dests, cmd_ctx->cores_num);
 	free(cmd_data);
 	cmd_ctx->cmd_priv = NULL;
@@ -147,9 +186,7 @@ static int esp_sysview_trace_header_write(struct esp32_apptrace_cmd_ctx *ctx)
 
 	int hdr_len = strlen(hdr_str);
 	for (int i = 0; i < dests_num; i++) {
-		int res = cmd_data->data_dests[i].write(cmd_data->data_dests[i].priv,
-			(uint8_t *)hdr_str,
-			hdr_len);
+		int res = esp32_apptrace_dest_write(&cmd_data->data_dests[i], (uint8_t *)hdr_str, hdr_len);
 		if (res != ERROR_OK) {
 			LOG_ERROR("sysview: Failed to write %u bytes to dest %d!", hdr_len, i);
 			return ERROR_FAIL;
@@ -270,7 +307,9 @@ static uint16_t esp_sysview_parse_packet(uint8_t *pkt_buf,
 	uint32_t *pkt_len,
 	unsigned int *pkt_core_id,
 	uint32_t *delta,
-	uint32_t *delta_len)
+	uint32_t *delta_len,
+	uint8_t **payload,
+	uint16_t *payload_size)
 {
 	uint8_t *pkt = pkt_buf;
 	uint16_t event_id = 0, payload_len = 0;
@@ -301,6 +340,8 @@ static uint16_t esp_sysview_parse_packet(uint8_t *pkt_buf,
 		else
 			payload_len = esp_sysview_decode_plen(&pkt);
 	}
+	*payload = pkt;
+	*payload_size = payload_len;
 	pkt += payload_len;
 	uint8_t *delta_start = pkt;
 	*delta = esp_sysview_decode_u32(&pkt);
@@ -320,20 +361,14 @@ static int esp32_sysview_write_packet(struct esp32_sysview_cmd_data *cmd_data,
 	if (!cmd_data->data_dests[pkt_core_id].write)
 		return ERROR_FAIL;
 
-	int res = cmd_data->data_dests[pkt_core_id].write(cmd_data->data_dests[pkt_core_id].priv, pkt_buf, pkt_len);
-
+	/* packet is followed by modified delta if any */
+	uint8_t *bufs[] = { pkt_buf, delta_buf };
+	const uint32_t lens[] = { pkt_len, delta_len };
+	int res = esp32_apptrace_dest_writev(&cmd_data->data_dests[pkt_core_id], bufs, lens, delta_len ? 2 : 1);
 	if (res != ERROR_OK) {
-		LOG_ERROR("sysview: Failed to write %u bytes to dest %d!", pkt_len, pkt_core_id);
+		LOG_ERROR("sysview: Failed to write %u bytes to dest %d!", pkt_len + delta_len, pkt_core_id);
 		return res;
 	}
-	if (delta_len) {
-		/* write packet with modified delta */
-		res = cmd_data->data_dests[pkt_core_id].write(cmd_data->data_dests[pkt_core_id].priv, delta_buf, delta_len);
-		if (res != ERROR_OK) {
-			LOG_ERROR("sysview: Failed to write %u bytes of delta to dest %d!", delta_len, pkt_core_id);
-			return res;
-		}
-	}
 	return ERROR_OK;
 }
 
@@ -481,9 +516,7 @@ int esp32_sysview_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 				data[7], data[8], data[9]);
 			return ERROR_FAIL;
 		}
-		res = cmd_data->data_dests[core_id].write(cmd_data->data_dests[core_id].priv,
-			data,
-			SYSVIEW_SYNC_LEN);
+		res = esp32_apptrace_dest_write(&cmd_data->data_dests[core_id], data, SYSVIEW_SYNC_LEN);
 		if (res != ERROR_OK) {
 			LOG_ERROR("sysview: Failed to write %u sync bytes to dest %d!",
 				SYSVIEW_SYNC_LEN,
@@ -493,10 +526,7 @@ int esp32_sysview_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 		for (unsigned int i = 0; i < ctx->cores_num; i++) {
 			if (core_id == i)
 				continue;
-			res =
-				cmd_data->data_dests[i].write(cmd_data->data_dests[i].priv,
-				data,
-				SYSVIEW_SYNC_LEN);
+			res = esp32_apptrace_dest_write(&cmd_data->data_dests[i], data, SYSVIEW_SYNC_LEN);
 			if (res != ERROR_OK) {
 				LOG_ERROR("sysview: Failed to write %u sync bytes to dest %d!", SYSVIEW_SYNC_LEN, core_id ? 0 : 1);
 				return res;
@@ -509,11 +539,15 @@ int esp32_sysview_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 		unsigned int pkt_core_id;
 		uint32_t delta_len = 0;
 		uint32_t pkt_len = 0, delta = 0;
+		uint8_t *payload;
+		uint16_t payload_len;
 		uint16_t event_id = esp_sysview_parse_packet(data + processed,
 			&pkt_len,
 			&pkt_core_id,
 			&delta,
-			&delta_len);
+			&delta_len,
+			&payload,
+			&payload_len);
 		LOG_DEBUG("sysview: Process packet: core %d, %d id, %d bytes [%x %x %x %x]",
 			pkt_core_id,
 			event_id,
@@ -531,8 +565,16 @@ int esp32_sysview_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 			data + processed);
 		if (res != ERROR_OK)
 			return res;
+		if (cmd_data->store &&
+			esp_sysview_store_add(cmd_data->store, pkt_core_id, event_id, delta,
+				payload, payload_len) != ERROR_OK) {
+			LOG_ERROR("sysview: Failed to store event, disable events store!");
+			esp_sysview_store_close(cmd_data->store);
+			cmd_data->store = NULL;
+		}
 		if (event_id == SYSVIEW_EVTID_TRACE_STOP)
 			cmd_data->sv_trace_running = 0;
+		ctx->stats.events++;
 		ctx->tot_len += pkt_len;
 		processed += pkt_len;
 	}
@@ -19,6 +19,7 @@ struct esp32_sysview_cmd_data {
 	unsigned int sv_last_core_id;
 	int sv_trace_running;
 	int multicore_fd; /* File descriptor for multicore trace file. Supported since Segger SysView v3.60 */
+	struct esp_sysview_store *store; /* decoded events store, NULL if disabled */
 };
 
 struct esp32_apptrace_cmd_ctx;
@@ -34,6 +35,8 @@ int esp32_sysview_process_data(struct esp32_apptrace_cmd_ctx *ctx,
 	uint8_t *data,
 	uint32_t data_len);
 
+int esp32_sysview_store_path_set(const char *path);
+const char *esp32_sysview_store_path_get(void);
 int esp32_sysview_combine_files(int fdout, int fd_core0, int fd_core1);
 
 #endif	/* OPENOCD_TARGET_ESP32_SYSVIEW_H */
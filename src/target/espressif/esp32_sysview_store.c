@@ -0,0 +1,573 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/***************************************************************************
+ *   ESP32 sysview decoded events store                                    *
+ *   Copyright (C) 2025 Espressif Systems Ltd.                             *
+ ***************************************************************************/
+
+/*
+ * SystemView events decoded on the fly are stored in a compact file which can be
+ * exported to Chrome/Perfetto trace JSON later. The file layout (little endian):
+ *
+ * header:  "ESVS", version (u32), cores number (u32)
+ * chunks:  "ESVC", events number (u32), time of the first event (u64),
+ *          then columns: time delta from the first event (u32[]), event ID (u16[]),
+ *          core ID (u8[]), first event argument (u32[])
+ * index:   time of the first event (u64), file offset (u64), events number (u32) per chunk
+ * names:   task ID (u32), name length (u8), name per task
+ * trailer: timestamp frequency (u64), chunks number (u32), names number (u32),
+ *          index offset (u64), names offset (u64), events number (u64), "ESVE"
+ *
+ * Chunks are sorted by time, so the index allows to find the chunk for any time by binary search.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <helper/log.h>
+#include <helper/types.h>
+#include <helper/replacements.h>
+#include "esp32_sysview_store.h"
+#include "segger_sysview.h"
+
+#define ESP_SVS_MAGIC                   "ESVS"
+#define ESP_SVS_CHUNK_MAGIC             "ESVC"
+#define ESP_SVS_END_MAGIC               "ESVE"
+#define ESP_SVS_VERSION                 1
+/* max number of events in chunk */
+#define ESP_SVS_CHUNK_EVENTS            4096
+#define ESP_SVS_HDR_SZ                  12
+#define ESP_SVS_CHUNK_HDR_SZ            16
+#define ESP_SVS_EVENT_SZ                11
+#define ESP_SVS_INDEX_ENTRY_SZ          20
+#define ESP_SVS_TRAILER_SZ              44
+/* used when trace has no INIT event */
+#define ESP_SVS_DEFAULT_FREQ            1000000
+
+/* Chrome trace threads for every core */
+#define ESP_SVS_TRACK_TASKS             0
+#define ESP_SVS_TRACK_ISRS              1
+#define ESP_SVS_TRACK_USER              2
+#define ESP_SVS_TRACKS_NUM              3
+#define ESP_SVS_TID(_core_, _track_)    ((_core_) * ESP_SVS_TRACKS_NUM + (_track_))
+#define ESP_SVS_IDLE_TASK               UINT32_MAX
+
+struct esp_sysview_store {
+	FILE *f;
+	uint64_t offset;
+	/* absolute time of the last event in ticks */
+	uint64_t time;
+	uint64_t freq;
+	uint64_t events;
+	/* current chunk */
+	uint32_t chunk_num;
+	uint64_t chunk_time;
+	uint32_t ts[ESP_SVS_CHUNK_EVENTS];
+	uint16_t id[ESP_SVS_CHUNK_EVENTS];
+	uint8_t core[ESP_SVS_CHUNK_EVENTS];
+	uint32_t arg[ESP_SVS_CHUNK_EVENTS];
+	/* serialized index and task names */
+	uint8_t *index;
+	uint32_t index_len, index_cap, index_num;
+	uint8_t *names;
+	uint32_t names_len, names_cap, names_num;
+};
+
+struct esp_svs_task_name {
+	uint32_t id;
+	char name[256];
+};
+
+struct esp_svs_json {
+	FILE *f;
+	bool first;
+	uint64_t freq;
+};
+
+static const char *const esp_svs_event_names[] = {
+	"nop", "overflow", "isr_enter", "isr_exit", "task_start_exec", "task_stop_exec",
+	"task_start_ready", "task_stop_ready", "task_create", "task_info", "trace_start",
+	"trace_stop", "systime_cycles", "systime_us", "sysdesc", "user_start", "user_stop",
+	"idle", "isr_to_scheduler", "timer_enter", "timer_exit", "stack_info", "moduledesc",
+	"evt23", "init", "name_resource", "print_formatted", "nummodules", "end_call",
+	"task_terminate",
+};
+
+static bool esp_svs_decode_u32(const uint8_t **ptr, const uint8_t *end, uint32_t *val)
+{
+	*val = 0;
+	for (int k = 0; *ptr < end && k < 5; k++) {
+		uint8_t b = *(*ptr)++;
+		*val |= (uint32_t)(b & 0x7F) << (7 * k);
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static int esp_svs_buf_append(uint8_t **buf, uint32_t *len, uint32_t *cap, const uint8_t *data, uint32_t size)
+{
+	if (*len + size > *cap) {
+		uint32_t new_cap = MAX(*cap * 2, *len + size + 1024);
+		uint8_t *new_buf = realloc(*buf, new_cap);
+		if (!new_buf) {
+			LOG_ERROR("sysview: Failed to alloc %" PRIu32 " bytes!", new_cap);
+			return ERROR_FAIL;
+		}
+		*buf = new_buf;
+		*cap = new_cap;
+	}
+	memcpy(*buf + *len, data, size);
+	*len += size;
+	return ERROR_OK;
+}
+
+static int esp_svs_write(struct esp_sysview_store *store, const uint8_t *data, size_t size)
+{
+	if (size && fwrite(data, size, 1, store->f) != 1) {
+		LOG_ERROR("sysview: Failed to write %zu bytes to store (%d)!", size, errno);
+		return ERROR_FAIL;
+	}
+	store->offset += size;
+	return ERROR_OK;
+}
+
+static int esp_svs_chunk_flush(struct esp_sysview_store *store)
+{
+	uint32_t num = store->chunk_num;
+
+	if (num == 0)
+		return ERROR_OK;
+
+	uint8_t *buf = malloc(ESP_SVS_CHUNK_HDR_SZ + num * ESP_SVS_EVENT_SZ);
+	if (!buf) {
+		LOG_ERROR("sysview: Failed to alloc chunk buffer!");
+		return ERROR_FAIL;
+	}
+	uint8_t *p = buf;
+	memcpy(p, ESP_SVS_CHUNK_MAGIC, 4);
+	h_u32_to_le(p + 4, num);
+	h_u64_to_le(p + 8, store->chunk_time);
+	p += ESP_SVS_CHUNK_HDR_SZ;
+	for (uint32_t i = 0; i < num; i++, p += 4)
+		h_u32_to_le(p, store->ts[i]);
+	for (uint32_t i = 0; i < num; i++, p += 2)
+		h_u16_to_le(p, store->id[i]);
+	memcpy(p, store->core, num);
+	p += num;
+	for (uint32_t i = 0; i < num; i++, p += 4)
+		h_u32_to_le(p, store->arg[i]);
+
+	uint8_t entry[ESP_SVS_INDEX_ENTRY_SZ];
+	h_u64_to_le(entry, store->chunk_time);
+	h_u64_to_le(entry + 8, store->offset);
+	h_u32_to_le(entry + 16, num);
+
+	int res = esp_svs_write(store, buf, p - buf);
+	free(buf);
+	if (res != ERROR_OK)
+		return res;
+	res = esp_svs_buf_append(&store->index, &store->index_len, &store->index_cap, entry, sizeof(entry));
+	if (res != ERROR_OK)
+		return res;
+	store->index_num++;
+	store->chunk_num = 0;
+	return ERROR_OK;
+}
+
+struct esp_sysview_store *esp_sysview_store_open(const char *path, unsigned int cores_num)
+{
+	struct esp_sysview_store *store = calloc(1, sizeof(*store));
+	if (!store) {
+		LOG_ERROR("sysview: Failed to alloc store!");
+		return NULL;
+	}
+	store->f = fopen(path, "wb");
+	if (!store->f) {
+		LOG_ERROR("sysview: Failed to open store file '%s' (%d)!", path, errno);
+		free(store);
+		return NULL;
+	}
+
+	uint8_t hdr[ESP_SVS_HDR_SZ];
+	memcpy(hdr, ESP_SVS_MAGIC, 4);
+	h_u32_to_le(hdr + 4, ESP_SVS_VERSION);
+	h_u32_to_le(hdr + 8, cores_num);
+	if (esp_svs_write(store, hdr, sizeof(hdr)) != ERROR_OK) {
+		fclose(store->f);
+		free(store);
+		return NULL;
+	}
+	return store;
+}
+
+int esp_sysview_store_add(struct esp_sysview_store *store,
+	unsigned int core_id,
+	uint16_t event_id,
+	uint32_t delta,
+	const uint8_t *payload,
+	uint16_t payload_len)
+{
+	const uint8_t *p = payload;
+	const uint8_t *end = payload + payload_len;
+	uint32_t arg = 0;
+
+	store->time += delta;
+
+	switch (event_id) {
+	case SYSVIEW_EVTID_SYSDESC:
+	case SYSVIEW_EVTID_PRINT_FORMATTED:
+		/* payload starts with string */
+		break;
+	case SYSVIEW_EVTID_INIT:
+		/* SysFreq, CPUFreq, RAMBaseAddr, SysIdShift */
+		if (esp_svs_decode_u32(&p, end, &arg) && arg)
+			store->freq = arg;
+		break;
+	case SYSVIEW_EVTID_TASK_INFO: {
+		/* TaskId, Prio, name */
+		uint32_t prio;
+		if (esp_svs_decode_u32(&p, end, &arg) && esp_svs_decode_u32(&p, end, &prio) && p < end) {
+			uint8_t name_len = MIN(*p, end - p - 1);
+			uint8_t entry[5];
+			h_u32_to_le(entry, arg);
+			entry[4] = name_len;
+			if (esp_svs_buf_append(&store->names, &store->names_len, &store->names_cap,
+					entry, sizeof(entry)) != ERROR_OK ||
+				esp_svs_buf_append(&store->names, &store->names_len, &store->names_cap,
+					p + 1, name_len) != ERROR_OK)
+				return ERROR_FAIL;
+			store->names_num++;
+		}
+		break;
+	}
+	default:
+		if (!esp_svs_decode_u32(&p, end, &arg))
+			arg = 0;
+		break;
+	}
+
+	if (store->chunk_num == ESP_SVS_CHUNK_EVENTS ||
+		(store->chunk_num && store->time - store->chunk_time > UINT32_MAX)) {
+		int res = esp_svs_chunk_flush(store);
+		if (res != ERROR_OK)
+			return res;
+	}
+	if (store->chunk_num == 0)
+		store->chunk_time = store->time;
+	uint32_t i = store->chunk_num++;
+	store->ts[i] = store->time - store->chunk_time;
+	store->id[i] = event_id;
+	store->core[i] = core_id;
+	store->arg[i] = arg;
+	store->events++;
+	return ERROR_OK;
+}
+
+int esp_sysview_store_close(struct esp_sysview_store *store)
+{
+	if (!store)
+		return ERROR_OK;
+
+	int res = esp_svs_chunk_flush(store);
+	uint64_t index_offset = store->offset;
+	if (res == ERROR_OK)
+		res = esp_svs_write(store, store->index, store->index_len);
+	uint64_t names_offset = store->offset;
+	if (res == ERROR_OK)
+		res = esp_svs_write(store, store->names, store->names_len);
+	if (res == ERROR_OK) {
+		uint8_t trailer[ESP_SVS_TRAILER_SZ];
+		h_u64_to_le(trailer, store->freq);
+		h_u32_to_le(trailer + 8, store->index_num);
+		h_u32_to_le(trailer + 12, store->names_num);
+		h_u64_to_le(trailer + 16, index_offset);
+		h_u64_to_le(trailer + 24, names_offset);
+		h_u64_to_le(trailer + 32, store->events);
+		memcpy(trailer + 40, ESP_SVS_END_MAGIC, 4);
+		res = esp_svs_write(store, trailer, sizeof(trailer));
+	}
+	if (fclose(store->f) != 0 && res == ERROR_OK) {
+		LOG_ERROR("sysview: Failed to close store file (%d)!", errno);
+		res = ERROR_FAIL;
+	}
+	LOG_INFO("sysview: Stored %" PRIu64 " events in %" PRIu32 " chunks", store->events, store->index_num);
+	free(store->index);
+	free(store->names);
+	free(store);
+	return res;
+}
+
+static int esp_svs_read_at(FILE *f, uint64_t offset, uint8_t *buf, size_t size)
+{
+	if (offset > LONG_MAX || fseek(f, (long)offset, SEEK_SET) != 0)
+		return ERROR_FAIL;
+	if (size && fread(buf, size, 1, f) != 1)
+		return ERROR_FAIL;
+	return ERROR_OK;
+}
+
+static void esp_svs_json_str(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			fprintf(f, "\\u%04x", *s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static void esp_svs_json_event(struct esp_svs_json *js, char ph, uint64_t ts, unsigned int tid,
+	const char *name, const uint32_t *arg)
+{
+	fputs(js->first ? "\n" : ",\n", js->f);
+	js->first = false;
+	fprintf(js->f, "{\"ph\":\"%c\",\"pid\":0,\"tid\":%u,\"ts\":%.3f", ph, tid, (double)ts * 1000000.0 / js->freq);
+	if (name) {
+		fputs(",\"name\":", js->f);
+		esp_svs_json_str(js->f, name);
+	}
+	if (ph == 'i')
+		fputs(",\"s\":\"t\"", js->f);
+	if (arg)
+		fprintf(js->f, ",\"args\":{\"arg\":%" PRIu32 "}", *arg);
+	fputc('}', js->f);
+}
+
+static void esp_svs_json_thread_name(struct esp_svs_json *js, unsigned int tid, const char *name)
+{
+	fputs(js->first ? "\n" : ",\n", js->f);
+	js->first = false;
+	fprintf(js->f, "{\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+		tid, name);
+}
+
+static const char *esp_svs_task_name(struct esp_svs_task_name *names, uint32_t names_num, uint32_t id,
+	char *buf, size_t buf_sz)
+{
+	if (id == ESP_SVS_IDLE_TASK)
+		return "idle";
+	for (uint32_t i = 0; i < names_num; i++) {
+		if (names[i].id == id)
+			return names[i].name;
+	}
+	snprintf(buf, buf_sz, "task 0x%" PRIx32, id);
+	return buf;
+}
+
+int esp_sysview_store_export(struct command_invocation *cmd,
+	const char *store_path,
+	const char *json_path,
+	uint64_t start_us,
+	uint64_t end_us)
+{
+	uint8_t hdr[ESP_SVS_HDR_SZ];
+	uint8_t trailer[ESP_SVS_TRAILER_SZ];
+	uint8_t *index = NULL, *names_buf = NULL, *chunk = NULL;
+	struct esp_svs_task_name *names = NULL;
+	struct esp_svs_json js = { .first = true };
+	int res = ERROR_FAIL;
+
+	FILE *f = fopen(store_path, "rb");
+	if (!f) {
+		command_print(cmd, "Failed to open store file '%s' (%d)!", store_path, errno);
+		return ERROR_FAIL;
+	}
+	if (fread(hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr, ESP_SVS_MAGIC, 4) != 0 ||
+		le_to_h_u32(hdr + 4) != ESP_SVS_VERSION ||
+		fseek(f, -ESP_SVS_TRAILER_SZ, SEEK_END) != 0 ||
+		fread(trailer, sizeof(trailer), 1, f) != 1 ||
+		memcmp(trailer + 40, ESP_SVS_END_MAGIC, 4) != 0) {
+		command_print(cmd, "Invalid or incomplete store file '%s'!", store_path);
+		goto _out;
+	}
+	long trailer_offset = ftell(f) - ESP_SVS_TRAILER_SZ;
+	unsigned int cores_num = le_to_h_u32(hdr + 8);
+	js.freq = le_to_h_u64(trailer);
+	uint32_t chunks_num = le_to_h_u32(trailer + 8);
+	uint32_t names_num = le_to_h_u32(trailer + 12);
+	uint64_t index_offset = le_to_h_u64(trailer + 16);
+	uint64_t names_offset = le_to_h_u64(trailer + 24);
+	if (js.freq == 0) {
+		command_print(cmd, "No timestamp frequency in trace, assume %d Hz", ESP_SVS_DEFAULT_FREQ);
+		js.freq = ESP_SVS_DEFAULT_FREQ;
+	}
+	if (names_offset > (uint64_t)trailer_offset || index_offset > names_offset ||
+		names_offset - index_offset != (uint64_t)chunks_num * ESP_SVS_INDEX_ENTRY_SZ) {
+		command_print(cmd, "Corrupted store file '%s'!", store_path);
+		goto _out;
+	}
+
+	uint32_t names_len = trailer_offset - names_offset;
+	index = malloc(names_offset - index_offset + 1);
+	names_buf = malloc(names_len + 1);
+	names = calloc(names_num + 1, sizeof(*names));
+	chunk = malloc(ESP_SVS_CHUNK_HDR_SZ + ESP_SVS_CHUNK_EVENTS * ESP_SVS_EVENT_SZ);
+	if (!index || !names_buf || !names || !chunk) {
+		command_print(cmd, "Failed to alloc memory!");
+		goto _out;
+	}
+	if (esp_svs_read_at(f, index_offset, index, names_offset - index_offset) != ERROR_OK ||
+		esp_svs_read_at(f, names_offset, names_buf, names_len) != ERROR_OK) {
+		command_print(cmd, "Failed to read store file '%s'!", store_path);
+		goto _out;
+	}
+	uint32_t off = 0;
+	for (uint32_t i = 0; i < names_num; i++) {
+		if (off + 5 > names_len || off + 5 + names_buf[off + 4] > names_len) {
+			names_num = i;
+			break;
+		}
+		names[i].id = le_to_h_u32(names_buf + off);
+		memcpy(names[i].name, names_buf + off + 5, names_buf[off + 4]);
+		off += 5 + names_buf[off + 4];
+	}
+
+	/* find the last chunk started before the requested time */
+	uint64_t start_tick = (double)start_us * js.freq / 1000000.0;
+	uint64_t end_tick = end_us == UINT64_MAX ? UINT64_MAX : (uint64_t)((double)end_us * js.freq / 1000000.0);
+	uint32_t lo = 0, hi = chunks_num;
+	while (hi - lo > 1) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (le_to_h_u64(index + mid * ESP_SVS_INDEX_ENTRY_SZ) <= start_tick)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	js.f = fopen(json_path, "w");
+	if (!js.f) {
+		command_print(cmd, "Failed to open output file '%s' (%d)!", json_path, errno);
+		goto _out;
+	}
+	fputs("{\"traceEvents\":[", js.f);
+	for (unsigned int core = 0; core < cores_num; core++) {
+		char name[32];
+		snprintf(name, sizeof(name), "core%u tasks", core);
+		esp_svs_json_thread_name(&js, ESP_SVS_TID(core, ESP_SVS_TRACK_TASKS), name);
+		snprintf(name, sizeof(name), "core%u isrs", core);
+		esp_svs_json_thread_name(&js, ESP_SVS_TID(core, ESP_SVS_TRACK_ISRS), name);
+		snprintf(name, sizeof(name), "core%u user", core);
+		esp_svs_json_thread_name(&js, ESP_SVS_TID(core, ESP_SVS_TRACK_USER), name);
+	}
+
+	/* open slices per core */
+	bool task_open[256] = { false };
+	uint32_t isr_depth[256] = { 0 };
+	uint32_t user_depth[256] = { 0 };
+	uint64_t last_ts = 0, exported = 0;
+	bool done = false;
+
+	res = ERROR_OK;
+	for (uint32_t c = lo; c < chunks_num && !done; c++) {
+		const uint8_t *entry = index + c * ESP_SVS_INDEX_ENTRY_SZ;
+		uint32_t num = le_to_h_u32(entry + 16);
+		if (num > ESP_SVS_CHUNK_EVENTS ||
+			esp_svs_read_at(f, le_to_h_u64(entry + 8), chunk,
+				ESP_SVS_CHUNK_HDR_SZ + num * ESP_SVS_EVENT_SZ) != ERROR_OK ||
+			memcmp(chunk, ESP_SVS_CHUNK_MAGIC, 4) != 0) {
+			command_print(cmd, "Failed to read chunk %" PRIu32 "!", c);
+			res = ERROR_FAIL;
+			break;
+		}
+		uint64_t chunk_time = le_to_h_u64(chunk + 8);
+		const uint8_t *ts_col = chunk + ESP_SVS_CHUNK_HDR_SZ;
+		const uint8_t *id_col = ts_col + num * 4;
+		const uint8_t *core_col = id_col + num * 2;
+		const uint8_t *arg_col = core_col + num;
+
+		for (uint32_t i = 0; i < num; i++) {
+			uint64_t ts = chunk_time + le_to_h_u32(ts_col + i * 4);
+			if (ts < start_tick)
+				continue;
+			if (ts > end_tick) {
+				done = true;
+				break;
+			}
+			uint16_t id = le_to_h_u16(id_col + i * 2);
+			uint8_t core = core_col[i];
+			uint32_t arg = le_to_h_u32(arg_col + i * 4);
+			char name[64];
+			last_ts = ts;
+			exported++;
+
+			switch (id) {
+			case SYSVIEW_EVTID_TASK_START_EXEC:
+			case SYSVIEW_EVTID_IDLE:
+				if (task_open[core])
+					esp_svs_json_event(&js, 'E', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_TASKS), NULL, NULL);
+				esp_svs_json_event(&js, 'B', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_TASKS),
+					esp_svs_task_name(names, names_num, id == SYSVIEW_EVTID_IDLE ? ESP_SVS_IDLE_TASK : arg,
+						name, sizeof(name)), NULL);
+				task_open[core] = true;
+				break;
+			case SYSVIEW_EVTID_TASK_STOP_EXEC:
+				if (task_open[core])
+					esp_svs_json_event(&js, 'E', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_TASKS), NULL, NULL);
+				task_open[core] = false;
+				break;
+			case SYSVIEW_EVTID_ISR_ENTER:
+				snprintf(name, sizeof(name), "isr %" PRIu32, arg);
+				esp_svs_json_event(&js, 'B', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_ISRS), name, NULL);
+				isr_depth[core]++;
+				break;
+			case SYSVIEW_EVTID_ISR_EXIT:
+			case SYSVIEW_EVTID_ISR_TO_SCHEDULER:
+				if (isr_depth[core]) {
+					esp_svs_json_event(&js, 'E', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_ISRS), NULL, NULL);
+					isr_depth[core]--;
+				}
+				break;
+			case SYSVIEW_EVTID_USER_START:
+				snprintf(name, sizeof(name), "user %" PRIu32, arg);
+				esp_svs_json_event(&js, 'B', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_USER), name, NULL);
+				user_depth[core]++;
+				break;
+			case SYSVIEW_EVTID_USER_STOP:
+				if (user_depth[core]) {
+					esp_svs_json_event(&js, 'E', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_USER), NULL, NULL);
+					user_depth[core]--;
+				}
+				break;
+			default:
+				if (id < ARRAY_SIZE(esp_svs_event_names))
+					snprintf(name, sizeof(name), "%s", esp_svs_event_names[id]);
+				else
+					snprintf(name, sizeof(name), "event %" PRIu16, id);
+				esp_svs_json_event(&js, 'i', ts, ESP_SVS_TID(core, ESP_SVS_TRACK_TASKS), name, &arg);
+				break;
+			}
+		}
+	}
+	/* close slices still open at the end of the exported range */
+	for (unsigned int core = 0; core < ARRAY_SIZE(task_open); core++) {
+		if (task_open[core])
+			esp_svs_json_event(&js, 'E', last_ts, ESP_SVS_TID(core, ESP_SVS_TRACK_TASKS), NULL, NULL);
+		for (; isr_depth[core]; isr_depth[core]--)
+			esp_svs_json_event(&js, 'E', last_ts, ESP_SVS_TID(core, ESP_SVS_TRACK_ISRS), NULL, NULL);
+		for (; user_depth[core]; user_depth[core]--)
+			esp_svs_json_event(&js, 'E', last_ts, ESP_SVS_TID(core, ESP_SVS_TRACK_USER), NULL, NULL);
+	}
+	fputs("\n],\"displayTimeUnit\":\"ns\"}\n", js.f);
+	if (fclose(js.f) != 0) {
+		command_print(cmd, "Failed to write output file '%s' (%d)!", json_path, errno);
+		res = ERROR_FAIL;
+	}
+	if (res == ERROR_OK)
+		command_print(cmd, "Exported %" PRIu64 " events to '%s'", exported, json_path);
+
+_out:
+	fclose(f);
+	free(index);
+	free(names_buf);
+	free(names);
+	free(chunk);
+	return res;
+}
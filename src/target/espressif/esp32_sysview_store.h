@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/***************************************************************************
+ *   ESP32 sysview decoded events store                                    *
+ *   Copyright (C) 2025 Espressif Systems Ltd.                             *
+ ***************************************************************************/
+
+#ifndef OPENOCD_TARGET_ESP32_SYSVIEW_STORE_H
+#define OPENOCD_TARGET_ESP32_SYSVIEW_STORE_H
+
+#include <stdint.h>
+#include <helper/command.h>
+
+struct esp_sysview_store;
+
+struct esp_sysview_store *esp_sysview_store_open(const char *path, unsigned int cores_num);
+int esp_sysview_store_add(struct esp_sysview_store *store,
+	unsigned int core_id,
+	uint16_t event_id,
+	uint32_t delta,
+	const uint8_t *payload,
+	uint16_t payload_len);
+int esp_sysview_store_close(struct esp_sysview_store *store);
+int esp_sysview_store_export(struct command_invocation *cmd,
+	const char *store_path,
+	const char *json_path,
+	uint64_t start_us,
+	uint64_t end_us);
+
+#endif	/* OPENOCD_TARGET_ESP32_SYSVIEW_STORE_H */
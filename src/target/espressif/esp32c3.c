@@ -183,6 +183,7 @@ static int esp32c3_init_target(struct command_context *cmd_ctx,
 		return ret;
 
 	target->semihosting->user_command_extension = esp_semihosting_common;
+	target->semihosting->user_command_sync = esp_semihosting_sync;
 
 	struct esp_riscv_common *esp_riscv = target_to_esp_riscv(target);
 
@@ -238,6 +239,7 @@ struct target_type esp32c3_target = {
 	.halt = riscv_halt,
 	.resume = esp_riscv_resume,
 	.step = esp_riscv_step,
+	.step_range = esp_riscv_step_range,
 
 	.assert_reset = esp_riscv_assert_reset,
 	.deassert_reset = riscv_deassert_reset,
@@ -250,6 +252,7 @@ struct target_type esp32c3_target = {
 	.get_gdb_arch = riscv_get_gdb_arch,
 	.get_gdb_reg_list = riscv_get_gdb_reg_list,
 	.get_gdb_reg_list_noread = riscv_get_gdb_reg_list_noread,
+	.read_register_set = riscv_read_register_set,
 	.get_gdb_memory_map = esp32c3_get_gdb_memory_map,
 
 	.add_breakpoint = esp_riscv_breakpoint_add,
@@ -733,6 +733,7 @@ static int esp32p4_init_target(struct command_context *cmd_ctx,
 	info->cache_invalidate = esp32p4_cache_invalidate;
 
 	target->semihosting->user_command_extension = esp_semihosting_common;
+	target->semihosting->user_command_sync = esp_semihosting_sync;
 
 	struct esp_riscv_common *esp_riscv = target_to_esp_riscv(target);
 
@@ -820,6 +821,7 @@ struct target_type esp32p4_target = {
 	.halt = riscv_halt,
 	.resume = esp_riscv_resume,
 	.step = esp_riscv_step,
+	.step_range = esp_riscv_step_range,
 
 	.assert_reset = esp_riscv_assert_reset,
 	.deassert_reset = riscv_deassert_reset,
@@ -832,6 +834,7 @@ struct target_type esp32p4_target = {
 	.get_gdb_arch = riscv_get_gdb_arch,
 	.get_gdb_reg_list = esp_riscv_get_gdb_reg_list,
 	.get_gdb_reg_list_noread = riscv_get_gdb_reg_list_noread,
+	.read_register_set = riscv_read_register_set,
 	.get_gdb_memory_map = esp32p4_get_gdb_memory_map,
 
 	.add_breakpoint = esp_riscv_breakpoint_add,
@@ -423,6 +423,17 @@ static int esp32s2_step(struct target *target, bool current,
 	return ret;
 }
 
+static int esp32s2_step_range(struct target *target, target_addr_t start,
+		target_addr_t end, bool handle_breakpoints)
+{
+	int ret = xtensa_do_step_range(target, start, end, handle_breakpoints);
+	if (ret == ERROR_OK) {
+		esp32s2_on_halt(target);
+		target_call_event_callbacks(target, TARGET_EVENT_HALTED);
+	}
+	return ret;
+}
+
 static int esp32s2_poll(struct target *target)
 {
 	enum target_state old_state = target->state;
@@ -651,6 +662,7 @@ struct target_type esp32s2_target = {
 	.halt = xtensa_halt,
 	.resume = xtensa_resume,
 	.step = esp32s2_step,
+	.step_range = esp32s2_step_range,
 
 	.assert_reset = esp32s2_assert_reset,
 	.deassert_reset = esp32s2_deassert_reset,
@@ -10,6 +10,7 @@
 #endif
 
 #include <helper/align.h>
+#include <helper/perf_stats.h>
 #include <target/algorithm.h>
 #include <target/target.h>
 #include "esp_algorithm.h"
@@ -18,6 +19,8 @@
 /* 3 sec will be enough for the regular commands. Flash erase will take time but it has another timer value */
 #define DEFAULT_ALGORITHM_TIMEOUT_MS    3000	/* ms */
 
+static struct perf_counter esp_algorithm_run_perf = PERF_COUNTER_INIT("esp.stub_run", NULL);
+
 static int esp_algorithm_read_stub_logs(struct target *target, struct esp_algorithm_stub *stub)
 {
 	if (!stub || stub->log_buff_addr == 0 || stub->log_buff_size == 0)
@@ -679,7 +682,10 @@ int esp_algorithm_exec_func_image_va(struct target *target,
 	if (!run || !run->image.image.start_address_set || run->image.image.start_address == 0)
 		return ERROR_FAIL;
 
-	return esp_algorithm_run_image(target, run, num_args, ap);
+	int64_t start = perf_start();
+	int retval = esp_algorithm_run_image(target, run, num_args, ap);
+	perf_end(&esp_algorithm_run_perf, start, 0);
+	return retval;
 }
 
 int esp_algorithm_load_onboard_func(struct target *target, target_addr_t func_addr, struct esp_algorithm_run_data *run)
@@ -747,5 +753,8 @@ int esp_algorithm_exec_onboard_func_va(struct target *target,
 	uint32_t num_args,
 	va_list ap)
 {
-	return esp_algorithm_run_debug_stub(target, run, num_args, ap);
+	int64_t start = perf_start();
+	int retval = esp_algorithm_run_debug_stub(target, run, num_args, ap);
+	perf_end(&esp_algorithm_run_perf, start, 0);
+	return retval;
 }
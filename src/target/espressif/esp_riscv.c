@@ -769,6 +769,28 @@ int esp_riscv_step(struct target *target, bool current, target_addr_t address, b
 	return riscv_openocd_step(target, current, address, handle_breakpoints);
 }
 
+int esp_riscv_step_range(struct target *target, target_addr_t start, target_addr_t end,
+	bool handle_breakpoints)
+{
+	struct esp_common *esp = target_to_esp_common(target);
+	struct esp_flash_breakpoint *flash_bps = esp->flash_brps.brps;
+
+	if (!handle_breakpoints)
+		handle_breakpoints = esp_riscv_is_bp_wp_set_by_program(target);
+
+	/* Flash breakpoints at PC need the special handling of a plain step first,
+	 * gdb repeats the range step if PC is still in range after it. */
+	riscv_reg_t pc = 0;
+	if (riscv_reg_get(target, &pc, GDB_REGNO_PC) != ERROR_OK)
+		return esp_riscv_step(target, true, 0, handle_breakpoints);
+	for (unsigned int slot = 0; slot < ESP_FLASH_BREAKPOINTS_MAX_NUM; slot++) {
+		if (flash_bps[slot].bp_address == pc
+				&& !(flash_bps[slot].action == ESP_BP_ACT_REM && flash_bps[slot].status == ESP_BP_STAT_DONE))
+			return esp_riscv_step(target, true, 0, handle_breakpoints);
+	}
+	return riscv_openocd_step_range(target, start, end, handle_breakpoints);
+}
+
 static int esp_riscv_on_halt(struct target *target)
 {
 	riscv_reg_t reg_value;
@@ -1081,8 +1103,7 @@ int esp_riscv_write_memory(struct target *target, target_addr_t address,
 void esp_riscv_deinit_target(struct target *target)
 {
 	struct esp_riscv_common *esp_riscv = target_to_esp_riscv(target);
-	if (esp_riscv->semi_ops && esp_riscv->semi_ops->post_reset)
-		esp_riscv->semi_ops->post_reset(target);
+	esp_semihosting_deinit(target);
 
 	free(esp_riscv->target_bp_addr);
 	free(esp_riscv->target_wp_addr);
@@ -78,6 +78,7 @@ static inline int esp_riscv_init_arch_info(struct target *target,
 	esp_riscv->riscv.on_reset = esp_riscv_on_reset;
 
 	INIT_LIST_HEAD(&esp_riscv->semihost.dir_map_list);
+	INIT_LIST_HEAD(&esp_riscv->semihost.file_list);
 
 	int ret = esp_common_init(target, &esp_riscv->esp, flash_brps_ops, &riscv_algo_hw);
 	if (ret != ERROR_OK)
@@ -99,6 +100,8 @@ int esp_riscv_hit_watchpoint(struct target *target, struct watchpoint **hit_watc
 int esp_riscv_resume(struct target *target, bool current, target_addr_t address,
 		bool handle_breakpoints, bool debug_execution);
 int esp_riscv_step(struct target *target, bool current, target_addr_t address, bool handle_breakpoints);
+int esp_riscv_step_range(struct target *target, target_addr_t start, target_addr_t end,
+	bool handle_breakpoints);
 int esp_riscv_start_algorithm(struct target *target,
 	int num_mem_params, struct mem_param *mem_params,
 	int num_reg_params, struct reg_param *reg_params,
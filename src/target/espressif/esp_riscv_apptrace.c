@@ -98,6 +98,7 @@ int esp_riscv_apptrace_info_init(struct target *target, target_addr_t ctrl_addr,
 	if (old_ctrl_addr)
 		*old_ctrl_addr = esp_riscv->apptrace.ctrl_addr;
 	esp_riscv->apptrace.ctrl_addr = ctrl_addr;
+	esp_riscv->apptrace.ctrl_readback_valid = false;
 	return ERROR_OK;
 }
 
@@ -117,8 +118,28 @@ int esp_riscv_apptrace_usr_block_write(struct target *target, uint32_t block_id,
 	return esp_apptrace_usr_block_write(&esp_riscv_apptrace_hw, target, block_id, data, size);
 }
 
+static uint32_t esp_riscv_apptrace_ctrl_val(uint32_t block_id, uint32_t len, bool conn, bool data)
+{
+	return (conn ? RISCV_APPTRACE_HOST_CONNECT : 0) | (data ? RISCV_APPTRACE_HOST_DATA : 0) |
+		RISCV_APPTRACE_BLOCK_ID(block_id) | RISCV_APPTRACE_BLOCK_LEN(len);
+}
+
 int esp_riscv_apptrace_data_len_read(struct target *target, uint32_t *block_id, uint32_t *len)
 {
+	struct esp_riscv_common *esp_riscv = target_to_esp_riscv(target);
+
+	/* A block reported as ready stays so until the host acknowledges it, so the
+	 * control word read back together with the last acknowledgment can be used
+	 * instead of another read. */
+	if (esp_riscv->apptrace.ctrl_readback_valid) {
+		uint32_t ctrl = esp_riscv->apptrace.ctrl_readback;
+		esp_riscv->apptrace.ctrl_readback_valid = false;
+		if (RISCV_APPTRACE_BLOCK_LEN_GET(ctrl)) {
+			*block_id = RISCV_APPTRACE_BLOCK_ID_GET(ctrl);
+			*len = RISCV_APPTRACE_BLOCK_LEN_GET(ctrl);
+			return ERROR_OK;
+		}
+	}
 	return esp_riscv_apptrace_ctrl_reg_read(target, block_id, len, NULL);
 }
 
@@ -126,8 +147,29 @@ int esp_riscv_apptrace_data_read(struct target *target, uint32_t size, uint8_t *
 {
 	struct esp_riscv_common *esp_riscv = target_to_esp_riscv(target);
 	int blk_idx = block_id % 2 ? 0 : 1;
+	target_addr_t addr = esp_riscv->apptrace.mem_blocks[blk_idx].start;
+	RISCV_INFO(info);
+
+	esp_riscv->apptrace.ctrl_readback_valid = false;
+	if (ack && info->sysbus_read_write_u32 && size % 4 == 0 && addr % 4 == 0) {
+		/* read the block, ack it and read the next control word in one go */
+		uint32_t ctrl;
+		bool ctrl_valid;
+		int res = info->sysbus_read_write_u32(target, addr, size / 4, buffer,
+			esp_riscv->apptrace.ctrl_addr,
+			esp_riscv_apptrace_ctrl_val(block_id, 0 /*all data were read*/, true /*host connected*/,
+				false /*no host data*/),
+			&ctrl, &ctrl_valid);
+		if (res != ERROR_NOT_IMPLEMENTED) {
+			if (res == ERROR_OK && ctrl_valid) {
+				esp_riscv->apptrace.ctrl_readback = ctrl;
+				esp_riscv->apptrace.ctrl_readback_valid = true;
+			}
+			return res;
+		}
+	}
 
-	int res = target_read_buffer(target, esp_riscv->apptrace.mem_blocks[blk_idx].start, size, buffer);
+	int res = target_read_buffer(target, addr, size, buffer);
 	if (res != ERROR_OK)
 		return res;
 	if (ack) {
@@ -163,8 +205,8 @@ int esp_riscv_apptrace_ctrl_reg_read(struct target *target, uint32_t *block_id,
 int esp_riscv_apptrace_ctrl_reg_write(struct target *target, uint32_t block_id, uint32_t len, bool conn, bool data)
 {
 	struct esp_riscv_common *esp_riscv = target_to_esp_riscv(target);
-	uint32_t ctrl = (conn ? RISCV_APPTRACE_HOST_CONNECT : 0) |
-		(data ? RISCV_APPTRACE_HOST_DATA : 0) | RISCV_APPTRACE_BLOCK_ID(block_id) | RISCV_APPTRACE_BLOCK_LEN(len);
+	uint32_t ctrl = esp_riscv_apptrace_ctrl_val(block_id, len, conn, data);
+	esp_riscv->apptrace.ctrl_readback_valid = false;
 	return target_write_u32(target, esp_riscv->apptrace.ctrl_addr, ctrl);
 }
 
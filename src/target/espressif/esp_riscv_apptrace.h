@@ -23,6 +23,9 @@ struct esp_riscv_apptrace_info {
 	const struct esp32_apptrace_hw *hw;
 	target_addr_t ctrl_addr;
 	struct esp_riscv_apptrace_mem_block mem_blocks[2];
+	/* control word read back after the last block was acknowledged */
+	uint32_t ctrl_readback;
+	bool ctrl_readback_valid;
 };
 
 extern struct esp32_apptrace_hw esp_riscv_apptrace_hw;
@@ -17,8 +17,12 @@
 #include "esp_xtensa.h"
 #include <sys/stat.h>
 #include <utime.h>
+#if !IS_WIN32
+#include <fcntl.h>
+#endif
 #include <dirent.h>
 #include <helper/list.h>
+#include <helper/time_support.h>
 
 #if IS_MINGW
 #define mkdir(fname, mode) mkdir(fname)
@@ -55,6 +59,31 @@ struct dir_map {
 	struct list_head lh;
 };
 
+/* Size of read-ahead/write-behind buffer of the file used by bulk I/O syscalls */
+#define ESP_SEMIHOSTING_FILE_BUF_SZ     (64 * 1024)
+/* Max number of buffers passed by the target in one bulk I/O syscall */
+#define ESP_SEMIHOSTING_IOV_MAX         16
+/* Max number of bytes transferred by one bulk I/O syscall, they are staged in host memory */
+#define ESP_SEMIHOSTING_IOV_TOTAL_MAX   (4 * 1024 * 1024)
+/* Period of writing out write-behind data when the target does not make syscalls */
+#define ESP_SEMIHOSTING_FLUSH_PERIOD_MS 1000
+
+/* Host file state for bulk I/O syscalls */
+struct esp_semihost_file {
+	int fd;
+	uint8_t *buf;
+	uint32_t len;		/* number of valid bytes in buf */
+	uint32_t pos;		/* read position in read-ahead data */
+	bool write;			/* buf holds write-behind data */
+	int err;			/* errno of a failed write-behind, reported by the next syscall for the fd */
+	/* throughput stats */
+	uint64_t rd_bytes;
+	uint64_t wr_bytes;
+	int64_t rd_time_ms;
+	int64_t wr_time_ms;
+	struct list_head lh;
+};
+
 static struct esp_semihost_data *target_to_esp_semihost_data(struct target *target)
 {
 	struct xtensa *xtensa = target->arch_info;
@@ -143,6 +172,246 @@ static int clean_dir_map_list(struct target *target)
 	return ERROR_OK;
 }
 
+static int esp_semihosting_file_sync(struct esp_semihost_file *file);
+
+/* Writes out buffered data when no syscall for the fd can report the error. Write-behind
+ * errors are kept to be returned by the next write, fsync or close of the fd. */
+static void esp_semihosting_file_flush(struct target *target, struct esp_semihost_file *file)
+{
+	bool write = file->write && file->len;
+
+	if (esp_semihosting_file_sync(file) == 0)
+		return;
+	LOG_TARGET_ERROR(target, "Failed to sync buffered data of fd %d (%d)!", file->fd, errno);
+	if (write && !file->err)
+		file->err = errno;
+}
+
+static int esp_semihosting_flush_timer(void *priv)
+{
+	struct target *target = priv;
+	struct esp_semihost_data *semihost_data = target_to_esp_semihost_data(target);
+	struct esp_semihost_file *file;
+
+	list_for_each_entry(file, &semihost_data->file_list, lh) {
+		if (file->write && file->len)
+			esp_semihosting_file_flush(target, file);
+	}
+	return ERROR_OK;
+}
+
+static bool esp_semihosting_fd_is_valid(int fd)
+{
+#if IS_WIN32
+	struct stat st;
+	return fstat(fd, &st) == 0;
+#else
+	return fcntl(fd, F_GETFD) != -1;
+#endif
+}
+
+/* @return file state for the fd, NULL on error with errno set */
+static struct esp_semihost_file *esp_semihosting_file_get(struct target *target, int fd)
+{
+	struct esp_semihost_data *semihost_data = target_to_esp_semihost_data(target);
+	struct esp_semihost_file *file;
+
+	list_for_each_entry(file, &semihost_data->file_list, lh) {
+		if (file->fd == fd)
+			return file;
+	}
+
+	/* do not keep state for fds the target never opened */
+	if (!esp_semihosting_fd_is_valid(fd)) {
+		errno = EBADF;
+		return NULL;
+	}
+
+	file = calloc(1, sizeof(*file));
+	if (!file) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	file->buf = malloc(ESP_SEMIHOSTING_FILE_BUF_SZ);
+	if (!file->buf) {
+		free(file);
+		errno = ENOMEM;
+		return NULL;
+	}
+	file->fd = fd;
+	if (list_empty(&semihost_data->file_list))
+		target_register_named_timer_callback(esp_semihosting_flush_timer, ESP_SEMIHOSTING_FLUSH_PERIOD_MS,
+			TARGET_TIMER_TYPE_PERIODIC, target, "esp.semihosting.flush");
+	list_add_tail(&file->lh, &semihost_data->file_list);
+	return file;
+}
+
+/* Writes out write-behind data or gives back unused read-ahead data to the file.
+ * @return 0 on success, -1 on error with errno set */
+static int esp_semihosting_file_sync(struct esp_semihost_file *file)
+{
+	int ret = 0;
+
+	if (file->write) {
+		uint32_t done = 0;
+		while (done < file->len) {
+			ssize_t n = write(file->fd, file->buf + done, file->len - done);
+			if (n <= 0) {
+				ret = -1;
+				break;
+			}
+			done += n;
+		}
+	} else if (file->pos < file->len) {
+		if (lseek(file->fd, -(off_t)(file->len - file->pos), SEEK_CUR) == -1)
+			ret = -1;
+	}
+	file->len = 0;
+	file->pos = 0;
+	return ret;
+}
+
+static void esp_semihosting_file_free(struct target *target, struct esp_semihost_file *file)
+{
+	struct esp_semihost_data *semihost_data = target_to_esp_semihost_data(target);
+
+	if (esp_semihosting_file_sync(file) != 0)
+		LOG_TARGET_ERROR(target, "Failed to sync buffered data of fd %d (%d)!", file->fd, errno);
+	LOG_TARGET_DEBUG(target, "fd %d: read %" PRIu64 " bytes in %" PRId64 " ms, wrote %" PRIu64
+		" bytes in %" PRId64 " ms",
+		file->fd, file->rd_bytes, file->rd_time_ms, file->wr_bytes, file->wr_time_ms);
+	list_del(&file->lh);
+	free(file->buf);
+	free(file);
+	if (list_empty(&semihost_data->file_list))
+		target_unregister_timer_callback(esp_semihosting_flush_timer, target);
+}
+
+static void esp_semihosting_files_free(struct target *target)
+{
+	struct esp_semihost_data *semihost_data = target_to_esp_semihost_data(target);
+
+	if (!semihost_data)
+		return;
+
+	struct esp_semihost_file *file, *tmp;
+	list_for_each_entry_safe(file, tmp, &semihost_data->file_list, lh)
+		esp_semihosting_file_free(target, file);
+}
+
+/* @return number of bytes written, -1 on error with errno set */
+static ssize_t esp_semihosting_file_write(struct esp_semihost_file *file, const uint8_t *data, size_t size)
+{
+	if (file->err) {
+		errno = file->err;
+		file->err = 0;
+		return -1;
+	}
+	if (!file->write) {
+		if (esp_semihosting_file_sync(file) != 0)
+			return -1;
+		file->write = true;
+	}
+	if (file->len + size > ESP_SEMIHOSTING_FILE_BUF_SZ) {
+		if (esp_semihosting_file_sync(file) != 0)
+			return -1;
+	}
+	if (size >= ESP_SEMIHOSTING_FILE_BUF_SZ) {
+		/* large chunks go to the file directly */
+		size_t done = 0;
+		while (done < size) {
+			ssize_t n = write(file->fd, data + done, size - done);
+			if (n <= 0)
+				return done ? (ssize_t)done : -1;
+			done += n;
+		}
+		return done;
+	}
+	memcpy(file->buf + file->len, data, size);
+	file->len += size;
+	return size;
+}
+
+/* @return number of bytes read, 0 at the end of file, -1 on error with errno set */
+static ssize_t esp_semihosting_file_read(struct esp_semihost_file *file, uint8_t *data, size_t size)
+{
+	size_t done = 0;
+
+	if (file->write) {
+		if (esp_semihosting_file_sync(file) != 0)
+			return -1;
+		file->write = false;
+	}
+	while (done < size) {
+		if (file->pos < file->len) {
+			uint32_t n = MIN(file->len - file->pos, size - done);
+			memcpy(data + done, file->buf + file->pos, n);
+			file->pos += n;
+			done += n;
+			continue;
+		}
+		ssize_t n;
+		if (size - done >= ESP_SEMIHOSTING_FILE_BUF_SZ) {
+			/* large chunks come from the file directly */
+			n = read(file->fd, data + done, size - done);
+			if (n > 0)
+				done += n;
+		} else {
+			n = read(file->fd, file->buf, ESP_SEMIHOSTING_FILE_BUF_SZ);
+			file->len = n > 0 ? n : 0;
+			file->pos = 0;
+		}
+		if (n <= 0)
+			return (done || n == 0) ? (ssize_t)done : -1;
+	}
+	return done;
+}
+
+/* Makes file state consistent for the syscalls which do not go through the buffers.
+ * A write, fsync or close of an fd whose buffered data could not be written out fails
+ * with that error instead. */
+int esp_semihosting_sync(struct target *target)
+{
+	struct semihosting *semihosting = target->semihosting;
+	struct esp_semihost_data *semihost_data = target_to_esp_semihost_data(target);
+
+	if (!semihost_data || list_empty(&semihost_data->file_list))
+		return ERROR_OK;
+	if (semihosting->op == ESP_SEMIHOSTING_SYS_READV || semihosting->op == ESP_SEMIHOSTING_SYS_WRITEV)
+		return ERROR_OK;
+
+	int op_fd = -1;
+	if (semihosting->op == SEMIHOSTING_SYS_CLOSE || semihosting->op == SEMIHOSTING_SYS_WRITE ||
+		semihosting->op == ESP_SEMIHOSTING_SYS_FSYNC) {
+		uint8_t fields[8];
+		if (semihosting_read_fields(target, 1, fields) == ERROR_OK)
+			op_fd = semihosting_get_field(target, 0, fields);
+	}
+
+	int op_err = 0;
+	struct esp_semihost_file *file, *tmp;
+	list_for_each_entry_safe(file, tmp, &semihost_data->file_list, lh) {
+		esp_semihosting_file_flush(target, file);
+		if (file->fd != op_fd)
+			continue;
+		op_err = file->err;
+		file->err = 0;
+		if (semihosting->op == SEMIHOSTING_SYS_CLOSE)
+			esp_semihosting_file_free(target, file);
+	}
+	if (!op_err)
+		return ERROR_OK;
+
+	/* like close() failing with EIO, the fd is released anyway */
+	if (semihosting->op == SEMIHOSTING_SYS_CLOSE)
+		close(op_fd);
+	semihosting->result = -1;
+	semihosting->sys_errno = op_err;
+	LOG_TARGET_DEBUG(target, "op 0x%x for fd %d fails with write-behind error %d",
+		semihosting->op, op_fd, op_err);
+	return ERROR_FAIL;
+}
+
 static void fill_stat_struct(struct stat_ret *st_stat_ret, const struct stat *statbuf)
 {
 	st_stat_ret->st_dev = 0;
@@ -203,9 +472,17 @@ static int write_to_dirent_struct(struct target *target, uint64_t ret_addr, stru
 
 int esp_semihosting_post_reset(struct target *target)
 {
+	esp_semihosting_files_free(target);
 	return clean_dir_map_list(target);
 }
 
+/* Writes out buffered file data and frees semihosting state, the target is going away */
+void esp_semihosting_deinit(struct target *target)
+{
+	esp_semihosting_files_free(target);
+	clean_dir_map_list(target);
+}
+
 static int esp_semihosting_sys_seek(struct target *target, uint64_t fd, int pos, size_t whence)
 {
 	struct semihosting *semihosting = target->semihosting;
@@ -241,6 +518,134 @@ static int esp_semihosting_sys_drv_info(struct target *target, int addr, int siz
 	return retval;
 }
 
+/* Reads the target's array of {base, len} buffers and merges adjacent ones.
+ * @return number of resulting buffers, 0 on error */
+static unsigned int esp_semihosting_iov_read(struct target *target, uint64_t iov_addr, uint32_t iov_cnt,
+	uint64_t iov[][2], uint64_t *total)
+{
+	struct semihosting *semihosting = target->semihosting;
+	uint8_t buf[ESP_SEMIHOSTING_IOV_MAX * 2 * 8];
+
+	if (target_read_buffer(target, iov_addr, iov_cnt * 2 * semihosting->word_size_bytes, buf) != ERROR_OK)
+		return 0;
+
+	unsigned int num = 0;
+	*total = 0;
+	for (uint32_t i = 0; i < iov_cnt; i++) {
+		uint64_t base = semihosting_get_field(target, 2 * i, buf);
+		uint64_t len = semihosting_get_field(target, 2 * i + 1, buf);
+		if (len == 0)
+			continue;
+		if (num > 0 && iov[num - 1][0] + iov[num - 1][1] == base) {
+			iov[num - 1][1] += len;
+		} else {
+			iov[num][0] = base;
+			iov[num][1] = len;
+			num++;
+		}
+		*total += len;
+	}
+	return num;
+}
+
+/* Handles SYS_READV/SYS_WRITEV. All target buffers are transferred with one block access per
+ * contiguous area and host file data go through read-ahead/write-behind buffer. */
+static int esp_semihosting_sys_rw_vec(struct target *target, bool is_write)
+{
+	struct semihosting *semihosting = target->semihosting;
+	uint8_t fields[3 * 8];
+	uint64_t iov[ESP_SEMIHOSTING_IOV_MAX][2];
+	uint64_t total;
+
+	semihosting->result = -1;
+	if (semihosting->is_fileio) {
+		/* let target library fall back to SYS_READ/SYS_WRITE */
+		semihosting->sys_errno = ENOSYS;
+		return ERROR_OK;
+	}
+
+	int retval = semihosting_read_fields(target, 3, fields);
+	if (retval != ERROR_OK)
+		return retval;
+	int fd = semihosting_get_field(target, 0, fields);
+	uint64_t iov_addr = semihosting_get_field(target, 1, fields);
+	uint32_t iov_cnt = semihosting_get_field(target, 2, fields);
+
+	if (fd == semihosting->stdin_fd || fd == semihosting->stdout_fd || fd == semihosting->stderr_fd) {
+		semihosting->sys_errno = ENOSYS;
+		return ERROR_OK;
+	}
+	if (iov_cnt == 0 || iov_cnt > ESP_SEMIHOSTING_IOV_MAX) {
+		semihosting->sys_errno = EINVAL;
+		return ERROR_OK;
+	}
+
+	int64_t start = timeval_ms();
+	unsigned int num = esp_semihosting_iov_read(target, iov_addr, iov_cnt, iov, &total);
+	if (num == 0) {
+		semihosting->result = 0;
+		semihosting->sys_errno = 0;
+		return ERROR_OK;
+	}
+
+	if (total > ESP_SEMIHOSTING_IOV_TOTAL_MAX) {
+		semihosting->sys_errno = EINVAL;
+		return ERROR_OK;
+	}
+
+	struct esp_semihost_file *file = esp_semihosting_file_get(target, fd);
+	if (!file) {
+		semihosting->sys_errno = errno;
+		return ERROR_OK;
+	}
+	uint8_t *data = malloc(total);
+	if (!data) {
+		semihosting->sys_errno = ENOMEM;
+		return ERROR_OK;
+	}
+
+	uint64_t off = 0;
+	if (is_write) {
+		for (unsigned int i = 0; i < num && retval == ERROR_OK; i++) {
+			retval = target_read_buffer(target, iov[i][0], iov[i][1], data + off);
+			off += iov[i][1];
+		}
+		if (retval != ERROR_OK) {
+			free(data);
+			semihosting->sys_errno = EIO;
+			return retval;
+		}
+		semihosting->result = esp_semihosting_file_write(file, data, total);
+		semihosting->sys_errno = semihosting->result < 0 ? errno : 0;
+		if (semihosting->result > 0) {
+			file->wr_bytes += semihosting->result;
+			file->wr_time_ms += timeval_ms() - start;
+		}
+	} else {
+		semihosting->result = esp_semihosting_file_read(file, data, total);
+		semihosting->sys_errno = semihosting->result < 0 ? errno : 0;
+		for (unsigned int i = 0; i < num && off < (uint64_t)semihosting->result; i++) {
+			uint64_t len = MIN(iov[i][1], semihosting->result - off);
+			retval = target_write_buffer(target, iov[i][0], len, data + off);
+			if (retval != ERROR_OK) {
+				free(data);
+				semihosting->result = -1;
+				semihosting->sys_errno = EIO;
+				return retval;
+			}
+			off += len;
+		}
+		if (semihosting->result > 0) {
+			file->rd_bytes += semihosting->result;
+			file->rd_time_ms += timeval_ms() - start;
+		}
+	}
+	free(data);
+	LOG_TARGET_DEBUG(target, "%s(%d, %" PRIu32 " bufs, %" PRIu64 " bytes)=%" PRId64,
+		is_write ? "writev" : "readv", fd, iov_cnt, total, semihosting->result);
+	return ERROR_OK;
+}
+
 static const char *esp_semihosting_opcode_to_str(const int opcode)
 {
 	switch (opcode) {
@@ -290,6 +695,10 @@ static const char *esp_semihosting_opcode_to_str(const int opcode)
 			return "SYS_LINK";
 		case ESP_SEMIHOSTING_SYS_UNLINK:
 			return "SYS_UNLINK";
+		case ESP_SEMIHOSTING_SYS_READV:
+			return "SYS_READV";
+		case ESP_SEMIHOSTING_SYS_WRITEV:
+			return "SYS_WRITEV";
 		default:
 			return "<unknown>";
 	}
@@ -790,6 +1199,16 @@ int esp_semihosting_common(struct target *target)
 			}
 		}
 		break;
+
+	case ESP_SEMIHOSTING_SYS_READV:			/* 0x117 */
+		/* Reads file data into several target buffers. */
+		retval = esp_semihosting_sys_rw_vec(target, false);
+		break;
+
+	case ESP_SEMIHOSTING_SYS_WRITEV:		/* 0x118 */
+		/* Writes several target buffers to the file. */
+		retval = esp_semihosting_sys_rw_vec(target, true);
+		break;
 	}
 
 	return retval;
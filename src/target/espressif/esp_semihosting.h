@@ -37,8 +37,13 @@
 #define ESP_SEMIHOSTING_SYS_UNLINK                  0x115
 /* esp-idf internal syscalls */
 #define ESP_SEMIHOSTING_SYS_PANIC_REASON            0x116
+/* bulk I/O syscalls */
+#define ESP_SEMIHOSTING_SYS_READV                   0x117
+#define ESP_SEMIHOSTING_SYS_WRITEV                  0x118
 
 int esp_semihosting_common(struct target *target);
 int esp_semihosting_post_reset(struct target *target);
+void esp_semihosting_deinit(struct target *target);
+int esp_semihosting_sync(struct target *target);
 
 #endif	/* OPENOCD_TARGET_ESP_SEMIHOSTING_H */
@@ -173,6 +173,7 @@ int esp_xtensa_init_arch_info(struct target *target,
 		return ret;
 
 	INIT_LIST_HEAD(&esp_xtensa->semihost.dir_map_list);
+	INIT_LIST_HEAD(&esp_xtensa->semihost.file_list);
 	esp_xtensa->semihost.ops = (struct esp_semihost_ops *)esp_ops->semihost_ops;
 	esp_xtensa->apptrace.hw = &esp_xtensa_apptrace_hw;
 	esp_xtensa->reset_reason_fetch = esp_ops->reset_reason_fetch;
@@ -193,6 +194,8 @@ void esp_xtensa_target_deinit(struct target *target)
 {
 	LOG_DEBUG("start");
 
+	/* before anything that may bail out, the flush timer refers to the target */
+	esp_semihosting_deinit(target);
 	if (target_was_examined(target)) {
 		int ret = esp_xtensa_dbgstubs_restore(target);
 		if (ret != ERROR_OK)
@@ -200,8 +203,6 @@ void esp_xtensa_target_deinit(struct target *target)
 	}
 	xtensa_target_deinit(target);
 	struct esp_xtensa_common *esp_xtensa_common = target_to_esp_xtensa(target);
-	if (esp_xtensa_common->semihost.ops->post_reset)
-		esp_xtensa_common->semihost.ops->post_reset(target);
 	free(esp_xtensa_common->esp.flash_brps.brps);
 	free(esp_xtensa_common);	/* same as free(xtensa) */
 }
@@ -16,6 +16,7 @@
 
 #include <helper/align.h>
 #include <helper/crc16.h>
+#include <helper/perf_stats.h>
 #include <target/xtensa/xtensa.h>
 #include <target/xtensa/xtensa_debug_module.h>
 #include "esp_xtensa_apptrace.h"
@@ -61,6 +62,7 @@ struct esp32_apptrace_hw esp_xtensa_apptrace_hw = {
 	.ctrl_reg_write = esp_xtensa_apptrace_ctrl_reg_write,
 	.ctrl_reg_read = esp_xtensa_apptrace_ctrl_reg_read,
 	.data_len_read = esp_xtensa_apptrace_data_len_read,
+	.data_len_read_multi = esp_xtensa_apptrace_data_len_read_multi,
 	.data_read = esp_xtensa_apptrace_data_read,
 	.usr_block_max_size_get = esp_xtensa_apptrace_usr_block_max_size_get,
 	.buffs_write = esp_xtensa_apptrace_buffs_write,
@@ -141,6 +143,50 @@ int esp_xtensa_apptrace_data_len_read(struct target *target,
 	return esp_xtensa_apptrace_ctrl_reg_read(target, block_id, len, NULL);
 }
 
+int esp_xtensa_apptrace_data_len_read_multi(struct target *targets[],
+	unsigned int targets_num,
+	uint32_t block_id[],
+	uint32_t len[])
+{
+	uint8_t tmp[ESP32_APPTRACE_MAX_CORES_NUM][4];
+
+	if (targets_num > ESP32_APPTRACE_MAX_CORES_NUM)
+		return ERROR_FAIL;
+
+	for (unsigned int i = 0; i < targets_num; i++) {
+		struct xtensa *xtensa = target_to_xtensa(targets[i]);
+		if (xtensa->dbg_mod.dap) {
+			/* every core has its own DAP queue, read them one by one */
+			for (unsigned int k = 0; k < targets_num; k++) {
+				int res = esp_xtensa_apptrace_data_len_read(targets[k], &block_id[k], &len[k]);
+				if (res != ERROR_OK)
+					return res;
+			}
+			return ERROR_OK;
+		}
+	}
+
+	/* all cores are on the same JTAG chain, so queue the reads and execute them at once */
+	for (unsigned int i = 0; i < targets_num; i++) {
+		struct xtensa *xtensa = target_to_xtensa(targets[i]);
+		int res = xtensa_queue_dbg_reg_read(xtensa, XTENSA_APPTRACE_CTRL_REG, tmp[i]);
+		if (res != ERROR_OK)
+			return res;
+		xtensa_dm_queue_tdi_idle(&xtensa->dbg_mod);
+	}
+	int res = xtensa_dm_queue_execute(&target_to_xtensa(targets[0])->dbg_mod);
+	if (res != ERROR_OK) {
+		LOG_ERROR("Failed to exec JTAG queue!");
+		return res;
+	}
+	for (unsigned int i = 0; i < targets_num; i++) {
+		uint32_t val = buf_get_u32(tmp[i], 0, 32);
+		block_id[i] = XTENSA_APPTRACE_BLOCK_ID_GET(val);
+		len[i] = XTENSA_APPTRACE_BLOCK_LEN_GET(val);
+	}
+	return ERROR_OK;
+}
+
 int esp_xtensa_apptrace_usr_block_write(struct target *target,
 	uint32_t block_id,
 	const uint8_t *data,
@@ -167,6 +213,24 @@ static int esp_xtensa_apptrace_resume(struct target *target)
 	return res;
 }
 
+static struct perf_counter esp_xtensa_apptrace_read_perf = PERF_COUNTER_INIT("xtensa.apptrace_read", "bytes");
+
+/* Reads consecutive TRAXDATA words into buffer in one queue flush, together with the register
+ * accesses queued before. Over APB this is one block read, over JTAG one NAR+NDR pair per word. */
+static int esp_xtensa_apptrace_traxdata_read(struct xtensa *xtensa, uint8_t *buffer, uint32_t words)
+{
+	int res = xtensa_queue_dbg_reg_read_stream(xtensa, XDMREG_TRAXDATA, buffer, words);
+	if (res != ERROR_OK)
+		return res;
+	xtensa_dm_queue_tdi_idle(&xtensa->dbg_mod);
+	res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
+	if (res != ERROR_OK) {
+		LOG_ERROR("Failed to exec JTAG queue!");
+		return res;
+	}
+	return ERROR_OK;
+}
+
 static int esp_xtensa_apptrace_data_reverse_read(struct xtensa *xtensa,
 	uint32_t size,
 	uint8_t *buffer,
@@ -183,17 +247,16 @@ static int esp_xtensa_apptrace_data_reverse_read(struct xtensa *xtensa,
 		if (res != ERROR_OK)
 			return res;
 	}
-	for (unsigned int i = size / 4; i != 0; i--) {
-		res = xtensa_queue_dbg_reg_read(xtensa, XDMREG_TRAXDATA, &buffer[(i - 1) * 4]);
-		if (res != ERROR_OK)
-			return res;
-	}
-
-	xtensa_dm_queue_tdi_idle(&xtensa->dbg_mod);
-	res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
-	if (res != ERROR_OK) {
-		LOG_ERROR("Failed to exec JTAG queue!");
+	res = esp_xtensa_apptrace_traxdata_read(xtensa, buffer, size / 4);
+	if (res != ERROR_OK)
 		return res;
+
+	/* words are stored in the trace memory in reverse order */
+	for (uint32_t i = 0, j = size / 4; i + 1 < j; i++, j--) {
+		uint8_t tmp[4];
+		memcpy(tmp, &buffer[i * 4], 4);
+		memcpy(&buffer[i * 4], &buffer[(j - 1) * 4], 4);
+		memcpy(&buffer[(j - 1) * 4], tmp, 4);
 	}
 
 	return ERROR_OK;
@@ -207,22 +270,20 @@ static int esp_xtensa_apptrace_data_normal_read(struct xtensa *xtensa,
 	int res = xtensa_queue_dbg_reg_write(xtensa, XDMREG_TRAXADDR, 0);
 	if (res != ERROR_OK)
 		return res;
-	for (unsigned int i = 0; i < size / 4; i++) {
-		res = xtensa_queue_dbg_reg_read(xtensa, XDMREG_TRAXDATA, &buffer[i * 4]);
-		if (res != ERROR_OK)
-			return res;
-	}
+	res = esp_xtensa_apptrace_traxdata_read(xtensa, buffer, size / 4);
+	if (res != ERROR_OK)
+		return res;
 	if (!IS_ALIGNED(size, 4)) {
+		/* TRAXADDR keeps pointing after the last word read */
 		res = xtensa_queue_dbg_reg_read(xtensa, XDMREG_TRAXDATA, unal_bytes);
 		if (res != ERROR_OK)
 			return res;
-	}
-
-	xtensa_dm_queue_tdi_idle(&xtensa->dbg_mod);
-	res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
-	if (res != ERROR_OK) {
-		LOG_ERROR("Failed to exec JTAG queue!");
-		return res;
+		xtensa_dm_queue_tdi_idle(&xtensa->dbg_mod);
+		res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
+		if (res != ERROR_OK) {
+			LOG_ERROR("Failed to exec JTAG queue!");
+			return res;
+		}
 	}
 
 	return ERROR_OK;
@@ -254,10 +315,12 @@ int esp_xtensa_apptrace_data_read(struct target *target,
 
 	for (int i = 1; i <= MAX_TRIES + 1; ++i) {
 		LOG_TARGET_DEBUG(target, "Read data from block %" PRIu32 " size %" PRIu32, block_id, size);
+		int64_t start = perf_start();
 		if (xtensa->core_config->trace.reversed_mem_access)
 			res = esp_xtensa_apptrace_data_reverse_read(xtensa, size, buffer, unal_bytes);
 		else
 			res = esp_xtensa_apptrace_data_normal_read(xtensa, size, buffer, unal_bytes);
+		perf_end(&esp_xtensa_apptrace_read_perf, start, size);
 		if (res != ERROR_OK)
 			break;
 
@@ -17,6 +17,10 @@ struct esp_xtensa_apptrace_info {
 extern struct esp32_apptrace_hw esp_xtensa_apptrace_hw;
 
 int esp_xtensa_apptrace_data_len_read(struct target *target, uint32_t *block_id, uint32_t *len);
+int esp_xtensa_apptrace_data_len_read_multi(struct target *targets[],
+	unsigned int targets_num,
+	uint32_t block_id[],
+	uint32_t len[]);
 int esp_xtensa_apptrace_data_read(struct target *target,
 	uint32_t size,
 	uint8_t *buffer,
@@ -498,6 +498,40 @@ int esp_xtensa_smp_step(struct target *target,
 	return res;
 }
 
+int esp_xtensa_smp_step_range(struct target *target,
+	target_addr_t start,
+	target_addr_t end,
+	bool handle_breakpoints)
+{
+	int res;
+	uint32_t smp_break = 0;
+	struct esp_xtensa_smp_common *esp_xtensa_smp = target_to_esp_xtensa_smp(target);
+
+	if (target->smp) {
+		res = esp_xtensa_smp_smpbreak_disable(target, &smp_break);
+		if (res != ERROR_OK)
+			return res;
+	}
+	res = xtensa_do_step_range(target, start, end, handle_breakpoints);
+
+	if (res == ERROR_OK) {
+		if (esp_xtensa_smp->chip_ops->on_halt) {
+			res = esp_xtensa_smp->chip_ops->on_halt(target);
+			if (res != ERROR_OK)
+				return res;
+		}
+		target_call_event_callbacks(target, TARGET_EVENT_HALTED);
+	}
+
+	if (target->smp) {
+		int ret = esp_xtensa_smp_smpbreak_restore(target, smp_break);
+		if (ret != ERROR_OK)
+			return ret;
+	}
+
+	return res;
+}
+
 int esp_xtensa_smp_run_func_image(struct target *target, struct esp_algorithm_run_data *run, uint32_t num_args, ...)
 {
 	struct target *run_target = target;
@@ -828,6 +862,27 @@ COMMAND_HANDLER(esp_xtensa_smp_cmd_perfmon_dump)
 		target_to_xtensa(target));
 }
 
+COMMAND_HANDLER(esp_xtensa_smp_cmd_regstats)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	if (target->smp) {
+		struct target_list *head;
+		struct target *curr;
+		foreach_smp_target(head, target->smp_targets) {
+			curr = head->target;
+			if (CMD_ARGC == 0)
+				command_print(CMD, "CPU%d:", curr->coreid);
+			int ret = CALL_COMMAND_HANDLER(xtensa_cmd_regstats_do,
+				target_to_xtensa(curr));
+			if (ret != ERROR_OK)
+				return ret;
+		}
+		return ERROR_OK;
+	}
+	return CALL_COMMAND_HANDLER(xtensa_cmd_regstats_do,
+		target_to_xtensa(target));
+}
+
 COMMAND_HANDLER(esp_xtensa_smp_cmd_tracestart)
 {
 	struct target *target = get_current_target(CMD_CTX);
@@ -992,6 +1047,13 @@ const struct command_registration esp_xtensa_smp_xtensa_command_handlers[] = {
 			"Dump performance counter value. If no argument specified, dumps all counters.",
 		.usage = "[counter_id]",
 	},
+	{
+		.name = "regstats",
+		.handler = esp_xtensa_smp_cmd_regstats,
+		.mode = COMMAND_EXEC,
+		.help = "Show or reset statistics of register write-backs done on resume/step",
+		.usage = "['reset']",
+	},
 	{
 		.name = "tracestart",
 		.handler = esp_xtensa_smp_cmd_tracestart,
@@ -35,6 +35,10 @@ int esp_xtensa_smp_step(struct target *target,
 	bool current,
 	target_addr_t address,
 	bool handle_breakpoints);
+int esp_xtensa_smp_step_range(struct target *target,
+	target_addr_t start,
+	target_addr_t end,
+	bool handle_breakpoints);
 int esp_xtensa_smp_assert_reset(struct target *target);
 int esp_xtensa_smp_deassert_reset(struct target *target);
 int esp_xtensa_smp_soft_reset_halt(struct target *target);
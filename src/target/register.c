@@ -25,18 +25,185 @@
  * may be separate registers associated with debug or trace modules.
  */
 
+/* Caches with fewer registers than this are simply searched linearly. */
+#define REG_INDEX_MIN_REGS		32
+/* Number of hash buckets the indexes are kept in, a power of 2. */
+#define REG_INDEX_BUCKETS		64
+
+/**
+ * Hash index of a register cache, built when the cache is linked.
+ *
+ * The index is kept aside rather than in struct reg_cache, as caches are
+ * allocated by the targets in many different ways and not all of them are
+ * zeroed. It holds register positions rather than pointers. A cache whose
+ * reg_list or num_regs changed gets a new index on the next lookup; other
+ * changes to the registers need register_cache_build_index(). While the index
+ * is current a lookup trusts it, a register it doesn't hold is not in the cache.
+ */
+struct reg_cache_index {
+	const struct reg_cache *cache;
+	const struct reg *reg_list;
+	unsigned int num_regs;
+	unsigned int mask;			/* table size - 1 */
+	/* Open addressing tables of register positions + 1, 0 marks an empty slot */
+	unsigned int *by_name;
+	unsigned int *by_number;
+	struct reg_cache_index *next;
+};
+
+static struct reg_cache_index *reg_cache_indexes[REG_INDEX_BUCKETS];
+
+static uint32_t reg_index_hash_name(const char *name)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t reg_index_hash_number(uint32_t number)
+{
+	return number * 2654435761u;
+}
+
+static struct reg_cache_index **reg_index_find(const struct reg_cache *cache)
+{
+	struct reg_cache_index **p = &reg_cache_indexes[((uintptr_t)cache >> 4) & (REG_INDEX_BUCKETS - 1)];
+	while (*p && (*p)->cache != cache)
+		p = &(*p)->next;
+	return p;
+}
+
+void register_cache_free_index(struct reg_cache *cache)
+{
+	struct reg_cache_index **p = reg_index_find(cache);
+	struct reg_cache_index *index = *p;
+	if (!index)
+		return;
+	*p = index->next;
+	free(index->by_name);
+	free(index->by_number);
+	free(index);
+}
+
+void register_cache_build_index(struct reg_cache *cache)
+{
+	register_cache_free_index(cache);
+	if (cache->num_regs < REG_INDEX_MIN_REGS)
+		return;
+
+	struct reg_cache_index *index = calloc(1, sizeof(*index));
+	if (!index)
+		return;
+
+	unsigned int size = 1;
+	while (size < 2 * cache->num_regs)
+		size <<= 1;
+	index->cache = cache;
+	index->reg_list = cache->reg_list;
+	index->num_regs = cache->num_regs;
+	index->mask = size - 1;
+	index->by_name = calloc(size, sizeof(*index->by_name));
+	index->by_number = calloc(size, sizeof(*index->by_number));
+	if (!index->by_name || !index->by_number) {
+		/* Lookups fall back to the linear search */
+		free(index->by_name);
+		free(index->by_number);
+		free(index);
+		return;
+	}
+
+	/* Registers go in in list order, so that probing finds the first of several
+	 * registers sharing a name or number first, like the linear search does. */
+	for (unsigned int i = 0; i < cache->num_regs; i++) {
+		const struct reg *reg = &cache->reg_list[i];
+		unsigned int slot;
+		if (reg->name) {
+			slot = reg_index_hash_name(reg->name) & index->mask;
+			while (index->by_name[slot])
+				slot = (slot + 1) & index->mask;
+			index->by_name[slot] = i + 1;
+		}
+		slot = reg_index_hash_number(reg->number) & index->mask;
+		while (index->by_number[slot])
+			slot = (slot + 1) & index->mask;
+		index->by_number[slot] = i + 1;
+	}
+
+	struct reg_cache_index **p = reg_index_find(cache);
+	*p = index;
+}
+
+/** Returns the index of @a cache, rebuilt if the register list changed, or NULL
+ * if the cache is searched linearly. */
+static const struct reg_cache_index *reg_index_get(struct reg_cache *cache)
+{
+	const struct reg_cache_index *index = *reg_index_find(cache);
+	if (!index)
+		return NULL;
+	if (index->reg_list != cache->reg_list || index->num_regs != cache->num_regs) {
+		register_cache_build_index(cache);
+		index = *reg_index_find(cache);
+	}
+	return index;
+}
+
+static struct reg *register_cache_get_by_number(struct reg_cache *cache, uint32_t reg_num)
+{
+	const struct reg_cache_index *index = reg_index_get(cache);
+	if (index) {
+		for (unsigned int slot = reg_index_hash_number(reg_num) & index->mask;
+				index->by_number[slot]; slot = (slot + 1) & index->mask) {
+			struct reg *reg = &cache->reg_list[index->by_number[slot] - 1];
+			if (reg->exist && reg->number == reg_num)
+				return reg;
+		}
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < cache->num_regs; i++) {
+		if (!cache->reg_list[i].exist)
+			continue;
+		if (cache->reg_list[i].number == reg_num)
+			return &(cache->reg_list[i]);
+	}
+	return NULL;
+}
+
+static struct reg *register_cache_get_by_name(struct reg_cache *cache, const char *name)
+{
+	const struct reg_cache_index *index = reg_index_get(cache);
+	if (index) {
+		for (unsigned int slot = reg_index_hash_name(name) & index->mask;
+				index->by_name[slot]; slot = (slot + 1) & index->mask) {
+			struct reg *reg = &cache->reg_list[index->by_name[slot] - 1];
+			if (reg->exist && reg->name && strcmp(reg->name, name) == 0)
+				return reg;
+		}
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < cache->num_regs; i++) {
+		if (!cache->reg_list[i].exist)
+			continue;
+		if (strcmp(cache->reg_list[i].name, name) == 0)
+			return &(cache->reg_list[i]);
+	}
+	return NULL;
+}
+
 struct reg *register_get_by_number(struct reg_cache *first,
 		uint32_t reg_num, bool search_all)
 {
 	struct reg_cache *cache = first;
 
 	while (cache) {
-		for (unsigned int i = 0; i < cache->num_regs; i++) {
-			if (!cache->reg_list[i].exist)
-				continue;
-			if (cache->reg_list[i].number == reg_num)
-				return &(cache->reg_list[i]);
-		}
+		struct reg *reg = register_cache_get_by_number(cache, reg_num);
+		if (reg)
+			return reg;
 
 		if (!search_all)
 			break;
@@ -53,12 +220,9 @@ struct reg *register_get_by_name(struct reg_cache *first,
 	struct reg_cache *cache = first;
 
 	while (cache) {
-		for (unsigned int i = 0; i < cache->num_regs; i++) {
-			if (!cache->reg_list[i].exist)
-				continue;
-			if (strcmp(cache->reg_list[i].name, name) == 0)
-				return &(cache->reg_list[i]);
-		}
+		struct reg *reg = register_cache_get_by_name(cache, name);
+		if (reg)
+			return reg;
 
 		if (!search_all)
 			break;
@@ -82,8 +246,16 @@ struct reg_cache **register_get_last_cache_p(struct reg_cache **first)
 	return cache_p;
 }
 
-void register_unlink_cache(struct reg_cache **cache_p, const struct reg_cache *cache)
+void register_link_cache(struct reg_cache **first, struct reg_cache *cache)
+{
+	for (struct reg_cache *c = cache; c; c = c->next)
+		register_cache_build_index(c);
+	*register_get_last_cache_p(first) = cache;
+}
+
+void register_unlink_cache(struct reg_cache **cache_p, struct reg_cache *cache)
 {
+	register_cache_free_index(cache);
 	while (*cache_p && *cache_p != cache)
 		cache_p = &((*cache_p)->next);
 	if (*cache_p)
@@ -158,7 +158,19 @@ struct reg *register_get_by_number(struct reg_cache *first,
 struct reg *register_get_by_name(struct reg_cache *first,
 		const char *name, bool search_all);
 struct reg_cache **register_get_last_cache_p(struct reg_cache **first);
-void register_unlink_cache(struct reg_cache **cache_p, const struct reg_cache *cache);
+/**
+ * Appends @a cache (and any caches chained to it) to the list at @a first and
+ * indexes their registers by name and number. The register list must be
+ * complete; a cache whose registers are renamed or renumbered later needs
+ * register_cache_build_index() again.
+ */
+void register_link_cache(struct reg_cache **first, struct reg_cache *cache);
+/** Unlinks @a cache from the list at @a cache_p and frees its index. */
+void register_unlink_cache(struct reg_cache **cache_p, struct reg_cache *cache);
+/** (Re)builds the lookup index of @a cache. Small caches don't get one. */
+void register_cache_build_index(struct reg_cache *cache);
+/** Frees the lookup index of @a cache; call before freeing the cache itself. */
+void register_cache_free_index(struct reg_cache *cache);
 void register_cache_invalidate(struct reg_cache *cache);
 
 void register_init_dummy(struct reg *reg);
@@ -458,3 +458,148 @@ size_t riscv_batch_finished_scans(const struct riscv_batch *batch)
 		++first_busy;
 	return first_busy;
 }
+
+size_t riscv_batch_first_busy_scan(const struct riscv_batch *batch)
+{
+	assert(riscv_batch_was_batch_busy(batch));
+	/* DMI busy is sticky until dtmcs.dmireset, so every scan after the first
+	 * busy one is busy as well. */
+	size_t first_busy = batch->used_scans - 1;
+	while (first_busy > 0 && batch->fields[first_busy - 1].in_value
+			&& riscv_batch_was_scan_busy(batch, first_busy - 1))
+		--first_busy;
+	return first_busy;
+}
+
+enum riscv_scan_delay_class
+riscv_batch_busy_delay_class(const struct riscv_batch *batch)
+{
+	const size_t first_busy = riscv_batch_first_busy_scan(batch);
+	/* The operation started by the preceding scan was still in progress, so
+	 * the delay added after that scan was not long enough. */
+	if (first_busy == 0)
+		return RISCV_DELAY_BASE;
+	return batch->delay_classes[first_busy - 1];
+}
+
+static unsigned int *scan_delay_field(struct riscv_scan_delays *delays,
+		enum riscv_scan_delay_class delay_class)
+{
+	switch (delay_class) {
+	case RISCV_DELAY_BASE:
+		return &delays->base_delay;
+	case RISCV_DELAY_ABSTRACT_COMMAND:
+		return &delays->ac_delay;
+	case RISCV_DELAY_SYSBUS_READ:
+		return &delays->sb_read_delay;
+	case RISCV_DELAY_SYSBUS_WRITE:
+		return &delays->sb_write_delay;
+	}
+	assert(0);
+	return NULL;
+}
+
+static unsigned int scan_delay_hist_bucket(unsigned int delay)
+{
+	unsigned int bucket = 0;
+	while (delay && bucket < RISCV_SCAN_DELAY_HIST_BUCKETS - 1) {
+		delay >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+int riscv_scan_increase_delay(struct riscv_scan_delays *delays,
+		enum riscv_scan_delay_class delay_class)
+{
+	struct riscv_scan_delay_tuning *tuning = &delays->tuning[delay_class];
+	const unsigned int delay = riscv_scan_get_delay(delays, delay_class);
+
+	tuning->busy++;
+	tuning->busy_hist[scan_delay_hist_bucket(delay)]++;
+	tuning->clean_scans = 0;
+
+	if (tuning->probing) {
+		/* The smaller delay is not enough, go back to the last good one and
+		 * wait longer before the next attempt. */
+		tuning->probing = false;
+		tuning->failed_probes++;
+		tuning->probe_interval = MIN(2 * tuning->probe_interval,
+				RISCV_SCAN_DELAY_PROBE_INTERVAL_MAX);
+		riscv_scan_set_delay(delays, delay_class, tuning->safe_delay);
+		return ERROR_OK;
+	}
+
+	const unsigned int delay_step = delay / 10 + 1;
+	if (delay > RISCV_SCAN_DELAY_MAX - delay_step) {
+		/* It's not clear if this issue actually occurs in real
+		 * use-cases, so stick with a simple solution until the
+		 * first bug report.
+		 */
+		LOG_ERROR("Delay for %s (%d) is not increased anymore (maximum was reached).",
+				riscv_scan_delay_class_name(delay_class), delay);
+		return ERROR_FAIL;
+	}
+	riscv_scan_set_delay(delays, delay_class, delay + delay_step);
+	return ERROR_OK;
+}
+
+void riscv_scan_delays_reset(struct riscv_scan_delays *delays, unsigned int base_floor)
+{
+	for (unsigned int i = 0; i < RISCV_DELAY_CLASS_NUM; i++) {
+		struct riscv_scan_delay_tuning *tuning = &delays->tuning[i];
+		*scan_delay_field(delays, i) = 0;
+		tuning->floor = 0;
+		tuning->probing = false;
+		tuning->clean_scans = 0;
+		tuning->probe_interval = delays->probe_interval;
+	}
+	delays->tuning[RISCV_DELAY_BASE].floor = base_floor;
+	riscv_scan_set_delay(delays, RISCV_DELAY_BASE, base_floor);
+}
+
+void riscv_scan_delays_reset_stats(struct riscv_scan_delays *delays)
+{
+	delays->retried_scans = 0;
+	for (unsigned int i = 0; i < RISCV_DELAY_CLASS_NUM; i++) {
+		struct riscv_scan_delay_tuning *tuning = &delays->tuning[i];
+		tuning->scans = 0;
+		tuning->busy = 0;
+		tuning->probes = 0;
+		tuning->failed_probes = 0;
+		memset(tuning->busy_hist, 0, sizeof(tuning->busy_hist));
+	}
+}
+
+void riscv_batch_update_delays(const struct riscv_batch *batch, size_t start_idx,
+		size_t end_idx, struct riscv_scan_delays *delays)
+{
+	assert(end_idx <= batch->used_scans);
+	for (size_t i = start_idx; i < end_idx; ++i) {
+		struct riscv_scan_delay_tuning *tuning = &delays->tuning[batch->delay_classes[i]];
+		tuning->scans++;
+		tuning->clean_scans++;
+	}
+
+	if (!delays->probe_interval)
+		return;
+
+	for (unsigned int i = 0; i < RISCV_DELAY_CLASS_NUM; i++) {
+		struct riscv_scan_delay_tuning *tuning = &delays->tuning[i];
+		if (!tuning->probe_interval)
+			tuning->probe_interval = delays->probe_interval;
+		if (tuning->clean_scans < tuning->probe_interval)
+			continue;
+		tuning->clean_scans = 0;
+		/* The current value survived a whole interval, so it is safe. */
+		tuning->probing = false;
+		unsigned int *delay = scan_delay_field(delays, i);
+		if (*delay <= tuning->floor)
+			continue;
+		tuning->safe_delay = *delay;
+		tuning->probing = true;
+		tuning->probes++;
+		const unsigned int delay_step = *delay / 10 + 1;
+		riscv_scan_set_delay(delays, i, MAX(*delay - MIN(delay_step, *delay), tuning->floor));
+	}
+}
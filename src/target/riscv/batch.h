@@ -54,11 +54,49 @@ riscv_scan_delay_class_name(enum riscv_scan_delay_class delay_class)
  */
 #define RISCV_SCAN_DELAY_MAX (INT_MAX / 2)
 
+#define RISCV_DELAY_CLASS_NUM (RISCV_DELAY_SYSBUS_WRITE + 1)
+
+/* Number of scans which have to finish without a busy response before a
+ * smaller delay is probed. It doubles every time a probe fails, up to
+ * RISCV_SCAN_DELAY_PROBE_INTERVAL_MAX, so the delay converges on the smallest
+ * value the target can sustain instead of only ever growing.
+ */
+#define RISCV_SCAN_DELAY_PROBE_INTERVAL 1000
+#define RISCV_SCAN_DELAY_PROBE_INTERVAL_MAX (64 * RISCV_SCAN_DELAY_PROBE_INTERVAL)
+
+/* Busy responses are counted in log2 buckets of the delay they happened at:
+ * bucket 0 is delay 0, bucket N covers delays [2^(N-1), 2^N).
+ */
+#define RISCV_SCAN_DELAY_HIST_BUCKETS 16
+
+struct riscv_scan_delay_tuning {
+	/* Lowest value the delay may be probed down to. */
+	unsigned int floor;
+	/* Delay value which is known to work while a smaller one is probed. */
+	unsigned int safe_delay;
+	bool probing;
+	/* Scans finished since the delay was last changed. */
+	unsigned int clean_scans;
+	unsigned int probe_interval;
+
+	uint64_t scans;
+	uint64_t busy;
+	uint64_t probes;
+	uint64_t failed_probes;
+	uint64_t busy_hist[RISCV_SCAN_DELAY_HIST_BUCKETS];
+};
+
 struct riscv_scan_delays {
 	unsigned int base_delay;
 	unsigned int ac_delay;
 	unsigned int sb_read_delay;
 	unsigned int sb_write_delay;
+
+	/* Initial probe interval, 0 disables shrinking of the delays. */
+	unsigned int probe_interval;
+	/* Scans which had to be issued again after a busy response. */
+	uint64_t retried_scans;
+	struct riscv_scan_delay_tuning tuning[RISCV_DELAY_CLASS_NUM];
 };
 
 static inline unsigned int
@@ -103,23 +141,17 @@ static inline void riscv_scan_set_delay(struct riscv_scan_delays *delays,
 	assert(0);
 }
 
-static inline int riscv_scan_increase_delay(struct riscv_scan_delays *delays,
-		enum riscv_scan_delay_class delay_class)
-{
-	const unsigned int delay = riscv_scan_get_delay(delays, delay_class);
-	const unsigned int delay_step = delay / 10 + 1;
-	if (delay > RISCV_SCAN_DELAY_MAX - delay_step) {
-		/* It's not clear if this issue actually occurs in real
-		 * use-cases, so stick with a simple solution until the
-		 * first bug report.
-		 */
-		LOG_ERROR("Delay for %s (%d) is not increased anymore (maximum was reached).",
-				riscv_scan_delay_class_name(delay_class), delay);
-		return ERROR_FAIL;
-	}
-	riscv_scan_set_delay(delays, delay_class, delay + delay_step);
-	return ERROR_OK;
-}
+/* Handles a busy response for "delay_class": if a smaller delay was being
+ * probed, the last known good value is restored, otherwise the delay grows. */
+int riscv_scan_increase_delay(struct riscv_scan_delays *delays,
+		enum riscv_scan_delay_class delay_class);
+
+/* Sets all delays to zero (the base delay to "base_floor", which it will
+ * never be probed below) and restarts tuning. Statistics are preserved. */
+void riscv_scan_delays_reset(struct riscv_scan_delays *delays, unsigned int base_floor);
+
+/* Clears the busy/probe statistics. */
+void riscv_scan_delays_reset_stats(struct riscv_scan_delays *delays);
 
 /* A batch of multiple JTAG scans, which are grouped together to avoid the
  * overhead of some JTAG adapters when sending single commands.  This is
@@ -190,6 +222,11 @@ int riscv_batch_run_from(struct riscv_batch *batch, size_t start_idx,
 /* Get the number of scans successfully executed form this batch. */
 size_t riscv_batch_finished_scans(const struct riscv_batch *batch);
 
+/* Accounts scans [start_idx, end_idx) of the batch as finished without a busy
+ * response and lowers the delay of every class whose probe interval expired. */
+void riscv_batch_update_delays(const struct riscv_batch *batch, size_t start_idx,
+		size_t end_idx, struct riscv_scan_delays *delays);
+
 /* Adds a DM register write to this batch. */
 void riscv_batch_add_dmi_write(struct riscv_batch *batch, uint32_t address, uint32_t data,
 	bool read_back, enum riscv_scan_delay_class delay_class);
@@ -229,4 +266,14 @@ size_t riscv_batch_available_scans(struct riscv_batch *batch);
 /* Return true iff the last scan in the batch returned DMI_OP_BUSY. */
 bool riscv_batch_was_batch_busy(const struct riscv_batch *batch);
 
+/* Return the index of the first scan of a busy batch that returned
+ * DMI_OP_BUSY. Scans that discarded their input are assumed to have
+ * completed, so the result is exact only for batches that kept it. */
+size_t riscv_batch_first_busy_scan(const struct riscv_batch *batch);
+
+/* Return the delay class whose delay was too short for a busy batch: the class
+ * of the scan that preceded the first busy one. */
+enum riscv_scan_delay_class
+riscv_batch_busy_delay_class(const struct riscv_batch *batch);
+
 #endif /* OPENOCD_TARGET_RISCV_BATCH_H */
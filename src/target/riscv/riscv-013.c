@@ -46,6 +46,8 @@ static int riscv013_halt_prep(struct target *target);
 static int riscv013_halt_go(struct target *target);
 static int riscv013_resume_go(struct target *target);
 static int riscv013_step_current_hart(struct target *target);
+static int riscv013_step_range_current_hart(struct target *target,
+		target_addr_t start, target_addr_t end, int64_t deadline);
 static int riscv013_on_step(struct target *target);
 static int riscv013_resume_prep(struct target *target);
 static enum riscv_halt_reason riscv013_halt_reason(struct target *target);
@@ -65,6 +67,9 @@ static int register_read_direct(struct target *target, riscv_reg_t *value,
 static int register_write_direct(struct target *target, enum gdb_regno number,
 		riscv_reg_t value);
 static int riscv013_access_memory(struct target *target, const struct riscv_mem_access_args args);
+static int riscv013_sysbus_read_write_u32(struct target *target, target_addr_t read_address,
+		uint32_t read_count, uint8_t *buffer, target_addr_t write_address,
+		uint32_t write_value, uint32_t *readback, bool *readback_valid);
 static bool riscv013_get_impebreak(const struct target *target);
 static unsigned int riscv013_get_progbufsize(const struct target *target);
 
@@ -443,7 +448,8 @@ static void select_dmi(struct jtag_tap *tap)
 		jtag_add_ir_scan(tap, &select_dbus, TAP_IDLE);
 }
 
-static int increase_dmi_busy_delay(struct target *target)
+static int increase_dmi_busy_delay(struct target *target,
+		enum riscv_scan_delay_class delay_class)
 {
 	RISCV013_INFO(info);
 
@@ -452,8 +458,7 @@ static int increase_dmi_busy_delay(struct target *target)
 	if (res != ERROR_OK)
 		return res;
 
-	res = riscv_scan_increase_delay(&info->learned_delays,
-			RISCV_DELAY_BASE);
+	res = riscv_scan_increase_delay(&info->learned_delays, delay_class);
 	return res;
 }
 
@@ -461,9 +466,8 @@ static void reset_learned_delays(struct target *target)
 {
 	RISCV013_INFO(info);
 	assert(info);
-	memset(&info->learned_delays, 0, sizeof(info->learned_delays));
 	/* ESPRESSIF */
-	riscv_scan_set_delay(&info->learned_delays, RISCV_DELAY_BASE, info->dtmcs_idle);
+	riscv_scan_delays_reset(&info->learned_delays, info->dtmcs_idle);
 }
 
 static void decrement_reset_delays_counter(struct target *target, size_t finished_scans)
@@ -1684,6 +1688,152 @@ static int register_read_direct(struct target *target, riscv_reg_t *value,
 	return result;
 }
 
+struct register_set_entry {
+	unsigned int index;			/* into the caller's arrays */
+	uint32_t command;
+	unsigned int size;
+	size_t abstractcs_key;
+	size_t data_key[2];
+};
+
+/* Can the register be read by a lone abstract command, without any preparation? */
+static bool register_set_eligible(struct target *target, enum gdb_regno regno,
+		bool fs_enabled)
+{
+	if (regno > GDB_REGNO_XPR15 && regno <= GDB_REGNO_XPR31 &&
+			riscv_supports_extension(target, 'E'))
+		return false;
+	if (is_vector_reg(regno))
+		return false;
+	if (is_fpu_reg(regno))
+		return fs_enabled;
+	return regno <= GDB_REGNO_XPR31 ||
+		(regno >= GDB_REGNO_CSR0 && regno <= GDB_REGNO_CSR4095);
+}
+
+/**
+ * Read several registers at once: all the abstract commands and the reads of
+ * their results are queued into one batch, so the whole set costs a single
+ * round trip instead of one per register.
+ *
+ * Registers that need more than an abstract command (vector registers, FPU
+ * registers while mstatus.FS is off, registers whose abstract command is known
+ * to be unsupported, ...) are skipped. So are all registers after the first
+ * failing command. `read_ok[i]` tells whether `values[i]` was read; the caller
+ * is expected to read the others one by one.
+ */
+int riscv013_get_registers(struct target *target, const enum gdb_regno *regnos,
+		riscv_reg_t *values, bool *read_ok, unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
+		read_ok[i] = false;
+
+	if (target->state != TARGET_HALTED || count == 0)
+		return ERROR_OK;
+
+	if (dm013_select_target(target) != ERROR_OK)
+		return ERROR_FAIL;
+
+	dm013_info_t *dm = get_dm(target);
+	if (!dm)
+		return ERROR_FAIL;
+
+	bool fs_enabled = false;
+	for (unsigned int i = 0; i < count; i++) {
+		if (is_fpu_reg(regnos[i])) {
+			riscv_reg_t mstatus;
+			fs_enabled = riscv_reg_get(target, &mstatus, GDB_REGNO_MSTATUS) == ERROR_OK &&
+				get_field(mstatus, MSTATUS_FS) != 0;
+			break;
+		}
+	}
+
+	struct register_set_entry *entries = calloc(count, sizeof(*entries));
+	if (!entries)
+		return ERROR_FAIL;
+
+	unsigned int num_entries = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		if (!register_set_eligible(target, regnos[i], fs_enabled))
+			continue;
+		const unsigned int size = register_size(target, regnos[i]);
+		if (size != 32 && size != 64)
+			continue;
+		const uint32_t command = riscv013_access_register_command(target, regnos[i], size,
+				AC_ACCESS_REGISTER_TRANSFER);
+		if (is_command_unsupported(target, command))
+			continue;
+		entries[num_entries].index = i;
+		entries[num_entries].command = command;
+		entries[num_entries].size = size;
+		num_entries++;
+	}
+
+	int res = ERROR_OK;
+	if (num_entries == 0)
+		goto free_entries;
+
+	/* command, abstractcs and up to two data words per register */
+	struct riscv_batch *batch = riscv_batch_alloc(target, num_entries * 4);
+	if (!batch) {
+		res = ERROR_FAIL;
+		goto free_entries;
+	}
+	for (unsigned int i = 0; i < num_entries; i++) {
+		struct register_set_entry *entry = &entries[i];
+		riscv_batch_add_dm_write(batch, DM_COMMAND, entry->command, /* read_back */ true,
+				RISCV_DELAY_ABSTRACT_COMMAND);
+		/* abstractcs tells which command failed, if any: the ones after it are ignored. */
+		entry->abstractcs_key = riscv_batch_add_dm_read(batch, DM_ABSTRACTCS, RISCV_DELAY_BASE);
+		for (unsigned int word = 0; word < entry->size / 32; word++)
+			entry->data_key[word] = riscv_batch_add_dm_read(batch, DM_DATA0 + word,
+					RISCV_DELAY_BASE);
+	}
+
+	dm->abstract_cmd_maybe_busy = true;
+	res = batch_run_timeout(target, batch);
+	if (res != ERROR_OK)
+		goto free_batch;
+
+	unsigned int done;
+	uint32_t abstractcs = 0;
+	for (done = 0; done < num_entries; done++) {
+		const struct register_set_entry *entry = &entries[done];
+		abstractcs = riscv_batch_get_dmi_read_data(batch, entry->abstractcs_key);
+		if (get_field32(abstractcs, DM_ABSTRACTCS_BUSY) ||
+				get_field32(abstractcs, DM_ABSTRACTCS_CMDERR) != CMDERR_NONE)
+			break;
+		riscv_reg_t value = riscv_batch_get_dmi_read_data(batch, entry->data_key[0]);
+		if (entry->size == 64)
+			value |= (riscv_reg_t)riscv_batch_get_dmi_read_data(batch, entry->data_key[1]) << 32;
+		values[entry->index] = value;
+		read_ok[entry->index] = true;
+	}
+	LOG_TARGET_DEBUG(target, "Read %u of %u registers in one batch", done, count);
+
+	if (done < num_entries) {
+		if (get_field32(abstractcs, DM_ABSTRACTCS_BUSY)) {
+			res = wait_for_idle(target, &abstractcs);
+			if (res != ERROR_OK)
+				goto free_batch;
+			res = increase_ac_busy_delay(target);
+			if (res != ERROR_OK)
+				goto free_batch;
+		}
+		if (get_field32(abstractcs, DM_ABSTRACTCS_CMDERR) == CMDERR_NOT_SUPPORTED)
+			mark_command_as_unsupported(target, entries[done].command);
+		if (dm_write(target, DM_ABSTRACTCS, DM_ABSTRACTCS_CMDERR) != ERROR_OK)
+			LOG_TARGET_ERROR(target, "could not clear abstractcs error");
+	}
+	dm->abstract_cmd_maybe_busy = false;
+
+free_batch:
+	riscv_batch_free(batch);
+free_entries:
+	free(entries);
+	return res;
+}
+
 static int wait_for_authbusy(struct target *target, uint32_t *dmstatus)
 {
 	time_t start = time(NULL);
@@ -2287,6 +2437,12 @@ static unsigned int riscv013_data_bits(struct target *target)
 	return 32;
 }
 
+static struct riscv_scan_delays *riscv013_get_scan_delays(struct target *target)
+{
+	RISCV013_INFO(info);
+	return &info->learned_delays;
+}
+
 static COMMAND_HELPER(riscv013_print_info, struct target *target)
 {
 	RISCV013_INFO(info);
@@ -2561,8 +2717,14 @@ static int batch_run(struct target *target, struct riscv_batch *batch)
 	 * "riscv_batch_add_dm_write(..., false)" should not be used. */
 	const size_t finished_scans = batch->used_scans;
 	decrement_reset_delays_counter(target, finished_scans);
-	if (riscv_batch_was_batch_busy(batch))
-		return increase_dmi_busy_delay(target);
+	if (riscv_batch_was_batch_busy(batch)) {
+		/* The caller resumes or repeats the batch from the first busy scan. */
+		info->learned_delays.retried_scans += batch->used_scans
+			- riscv_batch_first_busy_scan(batch);
+		return increase_dmi_busy_delay(target,
+				riscv_batch_busy_delay_class(batch));
+	}
+	riscv_batch_update_delays(batch, 0, finished_scans, &info->learned_delays);
 	return ERROR_OK;
 }
 
@@ -2591,12 +2753,16 @@ static int batch_run_timeout(struct target *target, struct riscv_batch *batch)
 		const size_t new_finished_scans = riscv_batch_finished_scans(batch);
 		assert(new_finished_scans >= finished_scans);
 		decrement_reset_delays_counter(target, new_finished_scans - finished_scans);
+		riscv_batch_update_delays(batch, finished_scans, new_finished_scans,
+				&info->learned_delays);
 		finished_scans = new_finished_scans;
 		if (!riscv_batch_was_batch_busy(batch)) {
 			assert(finished_scans == batch->used_scans);
 			return ERROR_OK;
 		}
-		result = increase_dmi_busy_delay(target);
+		info->learned_delays.retried_scans += batch->used_scans - finished_scans;
+		result = increase_dmi_busy_delay(target,
+				riscv_batch_busy_delay_class(batch));
 		if (result != ERROR_OK)
 			return result;
 	} while (time(NULL) - start < riscv_get_command_timeout_sec());
@@ -2748,11 +2914,8 @@ static int sample_memory_bus_v1(struct target *target,
 		 * with a larger DMI delay. */
 		const uint32_t sbcs_read_op = riscv_batch_get_dmi_read_op(batch, sbcs_read_index);
 		if (sbcs_read_op == DTM_DMI_OP_BUSY) {
-			result = increase_dmi_busy_delay(target);
-			if (result != ERROR_OK) {
-				riscv_batch_free(batch);
-				return result;
-			}
+			/* batch_run() has already accounted for the busy response. */
+			riscv_batch_free(batch);
 			continue;
 		}
 
@@ -2906,6 +3069,7 @@ static int init_target(struct command_context *cmd_ctx,
 	generic_info->get_hart_state = &riscv013_get_hart_state;
 	generic_info->resume_go = &riscv013_resume_go;
 	generic_info->step_current_hart = &riscv013_step_current_hart;
+	generic_info->step_range_current_hart = &riscv013_step_range_current_hart;
 	generic_info->resume_prep = &riscv013_resume_prep;
 	generic_info->halt_prep = &riscv013_halt_prep;
 	generic_info->halt_go = &riscv013_halt_go;
@@ -2925,8 +3089,10 @@ static int init_target(struct command_context *cmd_ctx,
 	generic_info->dmi_write = &dmi_write;
 	generic_info->get_dmi_address = &riscv013_get_dmi_address;
 	generic_info->access_memory = &riscv013_access_memory;
+	generic_info->sysbus_read_write_u32 = &riscv013_sysbus_read_write_u32;
 	generic_info->data_bits = &riscv013_data_bits;
 	generic_info->print_info = &riscv013_print_info;
+	generic_info->get_scan_delays = &riscv013_get_scan_delays;
 	generic_info->get_impebreak = &riscv013_get_impebreak;
 	generic_info->get_progbufsize = &riscv013_get_progbufsize;
 
@@ -2942,6 +3108,7 @@ static int init_target(struct command_context *cmd_ctx,
 	riscv013_info_t *info = get_info(target);
 
 	info->progbufsize = -1;
+	info->learned_delays.probe_interval = RISCV_SCAN_DELAY_PROBE_INTERVAL;
 	reset_learned_delays(target);
 
 	info->ac_not_supported_cache = ac_cache_construct();
@@ -3541,6 +3708,150 @@ static int read_memory_bus_v1(struct target *target, const struct riscv_mem_acce
 	return ERROR_OK;
 }
 
+/* The trace block read, its acknowledgment and the read of the next control
+ * word are issued as one batch, relying on the learned system bus delays
+ * instead of polling sbcs in between. While sbbusyerror or sberror is set the
+ * DM does not start any further bus access, so the write is not performed
+ * when the data could not be read. */
+static int riscv013_sysbus_read_write_u32(struct target *target, target_addr_t read_address,
+		uint32_t read_count, uint8_t *buffer, target_addr_t write_address,
+		uint32_t write_value, uint32_t *readback, bool *readback_valid)
+{
+	RISCV_INFO(r);
+	RISCV013_INFO(info);
+
+	*readback_valid = false;
+	if (!read_count || get_field(info->sbcs, DM_SBCS_SBVERSION) != 1 ||
+			!sba_supports_access(target, 4))
+		return ERROR_NOT_IMPLEMENTED;
+
+	unsigned int sbasize = get_field(info->sbcs, DM_SBCS_SBASIZE);
+	if (sizeof(target_addr_t) * 8 > sbasize &&
+			(((read_address + read_count * 4) >> sbasize) || (write_address >> sbasize)))
+		return ERROR_NOT_IMPLEMENTED;
+
+	/* Keep the configured order of memory access methods, the methods
+	 * before sysbus are not usable while the hart is running. */
+	bool sysbus_enabled = false;
+	for (unsigned int i = 0; i < r->num_enabled_mem_access_methods; i++) {
+		if (r->mem_access_methods[i] == RISCV_MEM_ACCESS_SYSBUS) {
+			sysbus_enabled = i == 0 || target->state != TARGET_HALTED;
+			break;
+		}
+	}
+	if (!sysbus_enabled)
+		return ERROR_NOT_IMPLEMENTED;
+
+	dm013_info_t *dm = get_dm(target);
+	if (!dm)
+		return ERROR_FAIL;
+
+	const unsigned int addr_regs = get_sbaadress_reg_count(target);
+	struct riscv_batch *batch = riscv_batch_alloc(target,
+			read_count + 3 * addr_regs + 10);
+	if (!batch)
+		return ERROR_FAIL;
+
+	if (r->mem_access_sysbus_cache_sync && r->cache_writeback)
+		r->cache_writeback(target, read_address, read_count * 4);
+
+	/* Stream the block, every read of sbdata0 starts the read of the next
+	 * word. sbreadondata is cleared before the last word is read, like
+	 * read_memory_bus_v1() does, so no read past the end is started. */
+	uint32_t sbcs = sb_sbaccess(4);
+	uint32_t sbcs_read = sbcs | DM_SBCS_SBREADONADDR | DM_SBCS_SBAUTOINCREMENT;
+	if (read_count > 1)
+		riscv_batch_add_dm_write(batch, DM_SBCS, sbcs_read | DM_SBCS_SBREADONDATA, true,
+				RISCV_DELAY_BASE);
+	else
+		riscv_batch_add_dm_write(batch, DM_SBCS, sbcs_read, true, RISCV_DELAY_BASE);
+	batch_fill_sb_write_address(target, batch, read_address, RISCV_DELAY_SYSBUS_READ);
+	const size_t data_key = batch->read_keys_used;
+	for (uint32_t i = 1; i < read_count; i++)
+		riscv_batch_add_dm_read(batch, DM_SBDATA0, RISCV_DELAY_SYSBUS_READ);
+	if (read_count > 1)
+		riscv_batch_add_dm_write(batch, DM_SBCS, sbcs_read, true, RISCV_DELAY_BASE);
+	riscv_batch_add_dm_read(batch, DM_SBDATA0, RISCV_DELAY_BASE);
+	const size_t read_sbcs_key = riscv_batch_add_dm_read(batch, DM_SBCS, RISCV_DELAY_BASE);
+
+	/* write the word */
+	riscv_batch_add_dm_write(batch, DM_SBCS, sbcs, true, RISCV_DELAY_BASE);
+	batch_fill_sb_write_address(target, batch, write_address, RISCV_DELAY_BASE);
+	riscv_batch_add_dm_write(batch, DM_SBDATA0, write_value, true, RISCV_DELAY_SYSBUS_WRITE);
+	const size_t write_sbcs_key = riscv_batch_add_dm_read(batch, DM_SBCS, RISCV_DELAY_BASE);
+
+	/* and read it back */
+	riscv_batch_add_dm_write(batch, DM_SBCS, sbcs | DM_SBCS_SBREADONADDR, true, RISCV_DELAY_BASE);
+	batch_fill_sb_write_address(target, batch, write_address, RISCV_DELAY_SYSBUS_READ);
+	const size_t readback_key = riscv_batch_add_dm_read(batch, DM_SBDATA0, RISCV_DELAY_BASE);
+	const size_t sbcs_key = riscv_batch_add_dm_read(batch, DM_SBCS, RISCV_DELAY_BASE);
+
+	int res = batch_run_timeout(target, batch);
+	if (res != ERROR_OK) {
+		riscv_batch_free(batch);
+		return res;
+	}
+
+	const uint32_t sbcs_after_read = riscv_batch_get_dmi_read_data(batch, read_sbcs_key);
+	const uint32_t sbcs_after_write = riscv_batch_get_dmi_read_data(batch, write_sbcs_key);
+	const uint32_t sbcs_final = riscv_batch_get_dmi_read_data(batch, sbcs_key);
+	const bool read_ok = !get_field(sbcs_after_read, DM_SBCS_SBBUSYERROR) &&
+		!get_field(sbcs_after_read, DM_SBCS_SBERROR);
+	const bool write_ok = read_ok && !get_field(sbcs_after_write, DM_SBCS_SBBUSYERROR) &&
+		!get_field(sbcs_after_write, DM_SBCS_SBERROR);
+	if (read_ok) {
+		for (uint32_t i = 0; i < read_count; i++)
+			buf_set_u32(buffer + i * 4, 0, 32, riscv_batch_get_dmi_read_data(batch, data_key + i));
+	}
+	if (write_ok) {
+		*readback = riscv_batch_get_dmi_read_data(batch, readback_key);
+		*readback_valid = true;
+	}
+	riscv_batch_free(batch);
+
+	if (get_field(sbcs_final, DM_SBCS_SBBUSYERROR) || get_field(sbcs_final, DM_SBCS_SBERROR)) {
+		LOG_TARGET_DEBUG(target, "Batched sysbus access failed (sbcs=0x%" PRIx32 ")", sbcs_final);
+		/* clear the errors */
+		if (dm_write(target, DM_SBCS, DM_SBCS_SBBUSYERROR | DM_SBCS_SBERROR) != ERROR_OK)
+			return ERROR_FAIL;
+		if (get_field(sbcs_final, DM_SBCS_SBBUSYERROR)) {
+			res = riscv_scan_increase_delay(&info->learned_delays,
+					(read_ok && !write_ok) ? RISCV_DELAY_SYSBUS_WRITE : RISCV_DELAY_SYSBUS_READ);
+			if (res != ERROR_OK)
+				return res;
+		}
+		if (!read_ok)
+			return ERROR_NOT_IMPLEMENTED;
+
+		/* The word read back is not valid. When the write itself succeeded,
+		 * the target may already have posted new contents of that word, so it
+		 * is written again only if sbcs showed the write failed. */
+		*readback_valid = false;
+		if (!write_ok) {
+			uint8_t value[4];
+			h_u32_to_le(value, write_value);
+			const struct riscv_mem_access_args write_args = {
+				.address = write_address,
+				.write_buffer = value,
+				.size = 4,
+				.count = 1,
+				.increment = 4,
+			};
+			res = riscv013_access_memory(target, write_args);
+			if (res != ERROR_OK)
+				return res;
+		}
+	}
+
+	if (r->mem_access_sysbus_cache_sync && r->cache_invalidate)
+		r->cache_invalidate(target, write_address, 4);
+
+	LOG_TARGET_DEBUG(target, "Read %" PRIu32 " words at 0x%" TARGET_PRIxADDR
+			", wrote 0x%" PRIx32 " to 0x%" TARGET_PRIxADDR " in one batch",
+			read_count, read_address, write_value, write_address);
+	return ERROR_OK;
+}
+
 static void log_mem_access_result(struct target *target, bool success,
 		enum riscv_mem_access_method method, bool is_read)
 {
@@ -5603,6 +5914,161 @@ static int riscv013_step_or_resume_current_hart(struct target *target,
 	return ERROR_FAIL;
 }
 
+/* Wait for the hart to acknowledge the resume request and halt again after a step. */
+static int wait_for_step_done(struct target *target)
+{
+	uint32_t dmstatus;
+	for (size_t i = 0; i < 256; ++i) {
+		if (dmstatus_read(target, &dmstatus, true) != ERROR_OK)
+			return ERROR_FAIL;
+		if (get_field(dmstatus, DM_DMSTATUS_ALLUNAVAIL))
+			return ERROR_FAIL;
+		if (get_field(dmstatus, DM_DMSTATUS_ALLRESUMEACK) &&
+				get_field(dmstatus, DM_DMSTATUS_ALLHALTED))
+			return ERROR_OK;
+		usleep(10);
+	}
+	LOG_TARGET_ERROR(target, "Failed to single-step. dmstatus=0x%08x", dmstatus);
+	if (riscv_halt(target) != ERROR_OK)
+		LOG_TARGET_ERROR(target, "  could not halt, something is wrong with the taget");
+	return ERROR_FAIL;
+}
+
+/* Step the current hart as long as dpc stays in [start, end) and each halt is
+ * caused by dcsr.step. The caller has set dcsr.step already.
+ * Every step is a single batch: the resume request, a dmstatus read proving the
+ * hart resumed and halted again, and abstract commands reading dpc and dcsr. If
+ * the hart was slower than the batch, dmstatus is polled and both registers are
+ * read one by one instead. The register cache is invalidated once, up front. */
+static int riscv013_step_range_current_hart(struct target *target,
+		target_addr_t start, target_addr_t end, int64_t deadline)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_TARGET_ERROR(target, "Hart is not halted!");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	if (riscv_reg_flush_all(target) != ERROR_OK)
+		return ERROR_FAIL;
+
+	riscv_reg_cache_invalidate_all(target);
+
+	dm013_info_t *dm = get_dm(target);
+	if (!dm)
+		return ERROR_FAIL;
+
+	const unsigned int xlen = riscv_xlen(target);
+	const uint32_t dpc_command = riscv013_access_register_command(target, GDB_REGNO_DPC,
+			xlen, AC_ACCESS_REGISTER_TRANSFER);
+	const uint32_t dcsr_command = riscv013_access_register_command(target, GDB_REGNO_DCSR,
+			32, AC_ACCESS_REGISTER_TRANSFER);
+	const bool batched = !is_command_unsupported(target, dpc_command) &&
+		!is_command_unsupported(target, dcsr_command);
+	const uint32_t dmcontrol = set_dmcontrol_hartsel(DM_DMCONTROL_DMACTIVE, dm->current_hartid);
+	riscv_reg_t dpc = 0, dcsr = 0;
+	unsigned int steps = 0, slow_steps = 0;
+	int result = ERROR_OK;
+
+	while (true) {
+		/* `resumereq` should not be issued if `abstractcs.busy` is set. */
+		result = wait_for_idle_if_needed(target);
+		if (result != ERROR_OK)
+			break;
+
+		bool done = false;
+		if (batched) {
+			struct riscv_batch *batch = riscv_batch_alloc(target, 11);
+			if (!batch) {
+				result = ERROR_FAIL;
+				break;
+			}
+			riscv_batch_add_dm_write(batch, DM_DMCONTROL, dmcontrol | DM_DMCONTROL_RESUMEREQ,
+					/* read_back */ false, RISCV_DELAY_BASE);
+			size_t dmstatus_key = riscv_batch_add_dm_read(batch, DM_DMSTATUS, RISCV_DELAY_BASE);
+			riscv_batch_add_dm_write(batch, DM_DMCONTROL, dmcontrol,
+					/* read_back */ false, RISCV_DELAY_BASE);
+			riscv_batch_add_dm_write(batch, DM_COMMAND, dpc_command,
+					/* read_back */ true, RISCV_DELAY_ABSTRACT_COMMAND);
+			size_t dpc_abstractcs_key = riscv_batch_add_dm_read(batch, DM_ABSTRACTCS, RISCV_DELAY_BASE);
+			size_t dpc_key[2] = { 0, 0 };
+			for (unsigned int word = 0; word < xlen / 32; word++)
+				dpc_key[word] = riscv_batch_add_dm_read(batch, DM_DATA0 + word, RISCV_DELAY_BASE);
+			riscv_batch_add_dm_write(batch, DM_COMMAND, dcsr_command,
+					/* read_back */ true, RISCV_DELAY_ABSTRACT_COMMAND);
+			size_t dcsr_abstractcs_key = riscv_batch_add_dm_read(batch, DM_ABSTRACTCS, RISCV_DELAY_BASE);
+			size_t dcsr_key = riscv_batch_add_dm_read(batch, DM_DATA0, RISCV_DELAY_BASE);
+
+			dm->abstract_cmd_maybe_busy = true;
+			result = batch_run_timeout(target, batch);
+			if (result != ERROR_OK) {
+				riscv_batch_free(batch);
+				break;
+			}
+			const uint32_t dmstatus = riscv_batch_get_dmi_read_data(batch, dmstatus_key);
+			const uint32_t dpc_abstractcs = riscv_batch_get_dmi_read_data(batch, dpc_abstractcs_key);
+			const uint32_t dcsr_abstractcs = riscv_batch_get_dmi_read_data(batch, dcsr_abstractcs_key);
+			if (get_field32(dmstatus, DM_DMSTATUS_ALLRESUMEACK) &&
+					get_field32(dmstatus, DM_DMSTATUS_ALLHALTED) &&
+					!get_field32(dpc_abstractcs, DM_ABSTRACTCS_BUSY) &&
+					get_field32(dpc_abstractcs, DM_ABSTRACTCS_CMDERR) == CMDERR_NONE &&
+					!get_field32(dcsr_abstractcs, DM_ABSTRACTCS_BUSY) &&
+					get_field32(dcsr_abstractcs, DM_ABSTRACTCS_CMDERR) == CMDERR_NONE) {
+				dpc = riscv_batch_get_dmi_read_data(batch, dpc_key[0]);
+				if (xlen == 64)
+					dpc |= (riscv_reg_t)riscv_batch_get_dmi_read_data(batch, dpc_key[1]) << 32;
+				dcsr = riscv_batch_get_dmi_read_data(batch, dcsr_key);
+				dm->abstract_cmd_maybe_busy = false;
+				done = true;
+			} else {
+				if (get_field32(dcsr_abstractcs, DM_ABSTRACTCS_BUSY)) {
+					uint32_t abstractcs;
+					result = wait_for_idle(target, &abstractcs);
+					if (result == ERROR_OK)
+						result = increase_ac_busy_delay(target);
+				}
+				if (result == ERROR_OK &&
+						dm_write(target, DM_ABSTRACTCS, DM_ABSTRACTCS_CMDERR) != ERROR_OK)
+					result = ERROR_FAIL;
+				dm->abstract_cmd_maybe_busy = false;
+			}
+			riscv_batch_free(batch);
+			if (result != ERROR_OK)
+				break;
+		} else {
+			if (dm_write(target, DM_DMCONTROL, dmcontrol | DM_DMCONTROL_RESUMEREQ) != ERROR_OK ||
+					dm_write(target, DM_DMCONTROL, dmcontrol) != ERROR_OK) {
+				result = ERROR_FAIL;
+				break;
+			}
+		}
+
+		if (!done) {
+			/* The hart wasn't halted again in time for the batched reads */
+			result = wait_for_step_done(target);
+			if (result != ERROR_OK)
+				break;
+			result = register_read_direct(target, &dpc, GDB_REGNO_DPC);
+			if (result == ERROR_OK)
+				result = register_read_direct(target, &dcsr, GDB_REGNO_DCSR);
+			if (result != ERROR_OK)
+				break;
+			slow_steps++;
+		}
+		steps++;
+
+		if (get_field(dcsr, CSR_DCSR_CAUSE) != CSR_DCSR_CAUSE_STEP)
+			break;
+		if (dpc < start || dpc >= end)
+			break;
+		if (timeval_ms() >= deadline)
+			break;
+	}
+
+	LOG_TARGET_DEBUG(target, "Range stepped %u instructions (%u not batched), dpc=0x%" PRIx64
+		", dcsr.cause=%" PRIu64, steps, slow_steps, dpc, get_field(dcsr, CSR_DCSR_CAUSE));
+	return result;
+}
+
 static int riscv013_clear_abstract_error(struct target *target)
 {
 	uint32_t abstractcs;
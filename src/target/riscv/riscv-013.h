@@ -15,6 +15,8 @@ int riscv013_get_register(struct target *target,
 		riscv_reg_t *value, enum gdb_regno rid);
 int riscv013_get_register_buf(struct target *target, uint8_t *value,
 		enum gdb_regno regno);
+int riscv013_get_registers(struct target *target, const enum gdb_regno *regnos,
+		riscv_reg_t *values, bool *read_ok, unsigned int count);
 int riscv013_set_register(struct target *target, enum gdb_regno rid,
 		riscv_reg_t value);
 int riscv013_set_register_buf(struct target *target, enum gdb_regno regno,
@@ -342,6 +342,10 @@ int riscv013_reg_examine_all(struct target *target)
 
 	riscv_reg_impl_hide_csrs(target);
 
+	/* The cache is linked as soon as it is allocated, index it now that
+	 * all registers are named. */
+	register_cache_build_index(target->reg_cache);
+
 	return ERROR_OK;
 }
 
@@ -21,6 +21,7 @@
 #include "helper/time_support.h"
 #include "riscv.h"
 #include "riscv_reg.h"
+#include "batch.h"
 #include "program.h"
 #include "gdb_regs.h"
 #include "rtos/rtos.h"
@@ -2521,6 +2522,27 @@ static int old_or_new_riscv_step(struct target *target, bool current,
 		handle_breakpoints, true /* handle callbacks*/);
 }
 
+static int old_or_new_riscv_step_range(struct target *target,
+		target_addr_t start, target_addr_t end, bool handle_breakpoints)
+{
+	RISCV_INFO(r);
+	if (!r->get_hart_state) {
+		/* 0.11 targets just repeat plain steps */
+		riscv_reg_t pc;
+		int res;
+		do {
+			res = oldriscv_step(target, true, 0, handle_breakpoints);
+			if (res != ERROR_OK)
+				return res;
+			res = riscv_reg_get(target, &pc, GDB_REGNO_PC);
+			if (res != ERROR_OK)
+				return res;
+		} while (target->debug_reason == DBG_REASON_SINGLESTEP && pc >= start && pc < end);
+		return ERROR_OK;
+	}
+	return riscv_openocd_step_range(target, start, end, handle_breakpoints);
+}
+
 static int riscv_examine(struct target *target)
 {
 	LOG_TARGET_DEBUG(target, "Starting examination");
@@ -3590,6 +3612,13 @@ static int riscv_get_gdb_reg_list_internal(struct target *target,
 		assert(!target->reg_cache->reg_list[i].valid ||
 				target->reg_cache->reg_list[i].size > 0);
 		(*reg_list)[i] = &target->reg_cache->reg_list[i];
+	}
+
+	/* Fetch what can be fetched in one go; the loop below reads the rest. */
+	if (is_read && riscv_read_register_set(target, *reg_list, *reg_list_size) != ERROR_OK)
+		LOG_TARGET_DEBUG(target, "Batched register read failed, reading registers one by one");
+
+	for (int i = 0; i < *reg_list_size; i++) {
 		if (is_read &&
 				target->reg_cache->reg_list[i].exist &&
 				!target->reg_cache->reg_list[i].valid) {
@@ -3617,6 +3646,14 @@ int riscv_get_gdb_reg_list(struct target *target,
 			reg_class, true);
 }
 
+int riscv_read_register_set(struct target *target, struct reg **reg_list,
+		int reg_count)
+{
+	if (!target->reg_cache || reg_count <= 0)
+		return ERROR_OK;
+	return riscv_reg_read_set(target, reg_list, reg_count);
+}
+
 int riscv_arch_state(struct target *target)
 {
 	assert(target->state == TARGET_HALTED);
@@ -4367,6 +4404,77 @@ int riscv_openocd_step(struct target *target, bool current,
 		true /* handle_callbacks */);
 }
 
+/* Let the hart step on its own while the PC stays in the range. Only dpc and
+ * dcsr are read between the steps, the register cache is refetched on demand
+ * after the final stop. */
+static int riscv_step_range_fast(struct target *target, target_addr_t start,
+	target_addr_t end, int64_t deadline)
+{
+	RISCV_INFO(r);
+	riscv_reg_t current_mstatus;
+
+	if (r->isrmask_mode == RISCV_ISRMASK_STEPONLY) {
+		/* Disable Interrupts once for all the steps. */
+		if (riscv_interrupts_disable(target, &current_mstatus) != ERROR_OK) {
+			LOG_TARGET_ERROR(target, "Unable to disable interrupts.");
+			return ERROR_FAIL;
+		}
+	}
+
+	int res = r->on_step(target);
+	if (res == ERROR_OK)
+		res = r->step_range_current_hart(target, start, end, deadline);
+
+	riscv_reg_cache_invalidate_all(target);
+	target->state = TARGET_HALTED;
+
+	if (r->isrmask_mode == RISCV_ISRMASK_STEPONLY)
+		if (riscv_interrupts_restore(target, current_mstatus) != ERROR_OK) {
+			LOG_TARGET_ERROR(target, "Unable to restore interrupts.");
+			res = ERROR_FAIL;
+		}
+
+	if (res != ERROR_OK)
+		return res;
+	return set_debug_reason(target, riscv_halt_reason(target));
+}
+
+int riscv_openocd_step_range(struct target *target, target_addr_t start,
+	target_addr_t end, bool handle_breakpoints)
+{
+	RISCV_INFO(r);
+	/* Return to the server now and then, gdb just asks again if PC is still in range */
+	int64_t deadline = timeval_ms() + 1000;
+	riscv_reg_t pc;
+
+	LOG_TARGET_DEBUG(target, "range [" TARGET_ADDR_FMT ", " TARGET_ADDR_FMT ")", start, end);
+
+	/* The first step takes care of breakpoints and watchpoints at the current PC */
+	int res = riscv_openocd_step_impl(target, true, 0, handle_breakpoints,
+		false /* handle_callbacks */);
+	while (res == ERROR_OK && target->debug_reason == DBG_REASON_SINGLESTEP) {
+		res = riscv_reg_get(target, &pc, GDB_REGNO_PC);
+		if (res != ERROR_OK)
+			break;
+		if (pc < start || pc >= end || timeval_ms() >= deadline)
+			break;
+		keep_alive();
+		if (r->step_range_current_hart)
+			res = riscv_step_range_fast(target, start, end, deadline);
+		else
+			res = riscv_openocd_step_impl(target, true, 0, handle_breakpoints,
+				false /* handle_callbacks */);
+	}
+	if (res != ERROR_OK)
+		return res;
+
+	target->state = TARGET_RUNNING;
+	target_call_event_callbacks(target, TARGET_EVENT_RESUMED);
+	target->state = TARGET_HALTED;
+	target_call_event_callbacks(target, TARGET_EVENT_HALTED);
+	return ERROR_OK;
+}
+
 /* Command Handlers */
 COMMAND_HANDLER(riscv_set_command_timeout_sec)
 {
@@ -4867,6 +4975,68 @@ COMMAND_HANDLER(riscv_reset_delays)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(riscv_scan_delays)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	RISCV_INFO(r);
+
+	struct riscv_scan_delays *delays = r->get_scan_delays ? r->get_scan_delays(target) : NULL;
+	if (!delays) {
+		command_print(CMD, "Scan delays are not tracked for this target.");
+		return ERROR_NOT_IMPLEMENTED;
+	}
+
+	if (CMD_ARGC == 1 && !strcmp(CMD_ARGV[0], "reset")) {
+		riscv_scan_delays_reset_stats(delays);
+		return ERROR_OK;
+	}
+	if (CMD_ARGC == 2 && !strcmp(CMD_ARGV[0], "probe_interval")) {
+		unsigned int interval;
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], interval);
+		delays->probe_interval = interval;
+		for (unsigned int i = 0; i < RISCV_DELAY_CLASS_NUM; i++) {
+			delays->tuning[i].probe_interval = interval;
+			delays->tuning[i].clean_scans = 0;
+		}
+		return ERROR_OK;
+	}
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	command_print(CMD, "%-18s %8s %12s %10s %8s %8s %8s %10s", "class", "delay",
+			"scans", "busy", "rate %", "probes", "failed", "interval");
+	for (unsigned int i = 0; i < RISCV_DELAY_CLASS_NUM; i++) {
+		const struct riscv_scan_delay_tuning *tuning = &delays->tuning[i];
+		const uint64_t attempts = tuning->scans + tuning->busy;
+		command_print(CMD, "%-18s %8u %12" PRIu64 " %10" PRIu64 " %8.3f %8" PRIu64 " %8" PRIu64 " %10u%s",
+				riscv_scan_delay_class_name(i), riscv_scan_get_delay(delays, i),
+				tuning->scans, tuning->busy,
+				attempts ? 100.0 * tuning->busy / attempts : 0.0,
+				tuning->probes, tuning->failed_probes,
+				delays->probe_interval ? tuning->probe_interval : 0,
+				tuning->probing ? " (probing)" : "");
+	}
+	command_print(CMD, "retried scans: %" PRIu64, delays->retried_scans);
+
+	for (unsigned int i = 0; i < RISCV_DELAY_CLASS_NUM; i++) {
+		const struct riscv_scan_delay_tuning *tuning = &delays->tuning[i];
+		if (!tuning->busy)
+			continue;
+		command_print_sameline(CMD, "busy by delay, %s:", riscv_scan_delay_class_name(i));
+		for (unsigned int b = 0; b < RISCV_SCAN_DELAY_HIST_BUCKETS; b++) {
+			if (!tuning->busy_hist[b])
+				continue;
+			if (b == 0)
+				command_print_sameline(CMD, " 0:%" PRIu64, tuning->busy_hist[b]);
+			else
+				command_print_sameline(CMD, " %u-%u:%" PRIu64, 1U << (b - 1),
+						(1U << b) - 1, tuning->busy_hist[b]);
+		}
+		command_print(CMD, " ");
+	}
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(riscv_set_ir)
 {
 	if (CMD_ARGC != 2)
@@ -5783,6 +5953,16 @@ static const struct command_registration riscv_exec_command_handlers[] = {
 			"command resets those learned values after `wait` scans. It's only "
 			"useful for testing OpenOCD itself."
 	},
+	{
+		.name = "scan_delays",
+		.handler = riscv_scan_delays,
+		.mode = COMMAND_ANY,
+		.usage = "['reset'|'probe_interval' scans]",
+		.help = "Show the Run-Test/Idle delays learned for each class of DMI "
+			"scans together with the busy/retry statistics, clear the "
+			"statistics, or set after how many scans without a busy response "
+			"a smaller delay is probed (0 disables shrinking)."
+	},
 	{
 		.name = "resume_order",
 		.handler = riscv_resume_order,
@@ -5975,6 +6155,7 @@ struct target_type riscv_target = {
 	.halt = riscv_halt,
 	.resume = riscv_target_resume,
 	.step = old_or_new_riscv_step,
+	.step_range = old_or_new_riscv_step_range,
 
 	.assert_reset = riscv_assert_reset,
 	.deassert_reset = riscv_deassert_reset,
@@ -5992,6 +6173,7 @@ struct target_type riscv_target = {
 	.get_gdb_arch = riscv_get_gdb_arch,
 	.get_gdb_reg_list = riscv_get_gdb_reg_list,
 	.get_gdb_reg_list_noread = riscv_get_gdb_reg_list_noread,
+	.read_register_set = riscv_read_register_set,
 
 	.add_breakpoint = riscv_add_breakpoint,
 	.remove_breakpoint = riscv_remove_breakpoint,
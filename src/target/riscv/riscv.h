@@ -4,6 +4,7 @@
 #define OPENOCD_TARGET_RISCV_RISCV_H
 
 struct riscv_program;
+struct riscv_scan_delays;
 
 #include <stdint.h>
 #include "opcodes.h"
@@ -252,6 +253,11 @@ struct riscv_info {
 	 * was resumed. */
 	int (*resume_go)(struct target *target);
 	int (*step_current_hart)(struct target *target);
+	/* Keep stepping the current hart while its PC stays in [start, end), it
+	 * halts only because of the step and timeval_ms() is below deadline.
+	 * Expects on_step() to be done. Optional. */
+	int (*step_range_current_hart)(struct target *target, target_addr_t start,
+		target_addr_t end, int64_t deadline);
 
 	/* These get called from riscv_poll_hart(), which is a house of cards
 	 * together with openocd_poll(), so be careful not to upset things too
@@ -309,10 +315,23 @@ struct riscv_info {
 
 	int (*access_memory)(struct target *target, const struct riscv_mem_access_args args);
 
+	/* ESPRESSIF: read @a read_count words from @a read_address, then write
+	 * @a write_value to @a write_address and read that word back into
+	 * @a readback, all in one batch of system bus accesses. @a readback_valid
+	 * is false when only the read back failed.
+	 * Returns ERROR_NOT_IMPLEMENTED when nothing was written, the caller
+	 * then has to use separate memory accesses. May be NULL. */
+	int (*sysbus_read_write_u32)(struct target *target, target_addr_t read_address,
+			uint32_t read_count, uint8_t *buffer, target_addr_t write_address,
+			uint32_t write_value, uint32_t *readback, bool *readback_valid);
+
 	unsigned int (*data_bits)(struct target *target);
 
 	COMMAND_HELPER((*print_info), struct target *target);
 
+	/* Returns the learned DMI scan delays, NULL if they are not tracked. */
+	struct riscv_scan_delays *(*get_scan_delays)(struct target *target);
+
 	/* Storage for arch_info of non-custom registers. */
 	riscv_reg_info_t shared_reg_info;
 
@@ -461,6 +480,9 @@ int riscv_openocd_poll(struct target *target);
 
 int riscv_halt(struct target *target);
 
+int riscv_openocd_step_range(struct target *target, target_addr_t start,
+	target_addr_t end, bool handle_breakpoints);
+
 int riscv_openocd_step(
 	struct target *target,
 	bool current,
@@ -530,6 +552,8 @@ int riscv_get_gdb_reg_list_noread(struct target *target,
 int riscv_get_gdb_reg_list(struct target *target,
 		struct reg **reg_list[], int *reg_list_size,
 		enum target_register_class reg_class);
+int riscv_read_register_set(struct target *target, struct reg **reg_list,
+		int reg_count);
 struct riscv_private_config *alloc_default_riscv_private_config(void);
 int riscv_arch_state(struct target *target);
 const char *riscv_get_gdb_arch(const struct target *target);
@@ -8,6 +8,7 @@
 #include "riscv.h"
 #include "riscv_reg.h"
 #include "riscv_reg_impl.h"
+#include <helper/perf_stats.h>
 /**
  * TODO: Currently `reg->get/set` is implemented in terms of
  * `riscv_get/set_register`.  However, the intention behind
@@ -770,6 +771,7 @@ void riscv_reg_free_all(struct target *target)
 			free(target->reg_cache->reg_list[i].value);
 		free(target->reg_cache->reg_list);
 	}
+	register_cache_free_index(target->reg_cache);
 	free(target->reg_cache);
 	target->reg_cache = NULL;
 }
@@ -940,6 +942,8 @@ int riscv_reg_write(struct target *target, enum gdb_regno regid,
 			/* write_through */ true);
 }
 
+static struct perf_counter riscv_reg_read_perf = PERF_COUNTER_INIT("riscv.reg_read", "regs");
+
 /**
  * This function is used to get the value of a register. If possible, the value
  * in cache will be updated.
@@ -978,8 +982,10 @@ int riscv_reg_get(struct target *target, riscv_reg_t *value,
 	}
 
 	LOG_TARGET_DEBUG(target, "Reading %s from target", reg->name);
+	int64_t start = perf_start();
 	if (riscv013_get_register(target, value, regid) != ERROR_OK)
 		return ERROR_FAIL;
+	perf_end(&riscv_reg_read_perf, start, 1);
 
 	buf_set_u64(reg->value, 0, reg->size, *value);
 	reg->valid = riscv_reg_impl_gdb_regno_cacheable(regid, /* is write? */ false) &&
@@ -989,3 +995,58 @@ int riscv_reg_get(struct target *target, riscv_reg_t *value,
 	LOG_TARGET_DEBUG(target, "Read %s: 0x%" PRIx64, reg->name, *value);
 	return ERROR_OK;
 }
+
+int riscv_reg_read_set(struct target *target, struct reg **regs,
+		unsigned int count)
+{
+	RISCV_INFO(r);
+	assert(r);
+	if (r->dtm_version == DTM_DTMCS_VERSION_0_11 || target->state != TARGET_HALTED)
+		return ERROR_OK;
+
+	enum gdb_regno *regnos = calloc(count, sizeof(*regnos));
+	riscv_reg_t *values = calloc(count, sizeof(*values));
+	bool *read_ok = calloc(count, sizeof(*read_ok));
+	int res = ERROR_FAIL;
+	if (!regnos || !values || !read_ok)
+		goto out;
+
+	unsigned int n = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		if (!regs[i] || !regs[i]->exist || regs[i]->valid)
+			continue;
+		/* "pc" is served from the cached "dpc", see riscv_reg_get() */
+		const enum gdb_regno regno = regs[i]->number == GDB_REGNO_PC ?
+			GDB_REGNO_DPC : regs[i]->number;
+		if (regno >= GDB_REGNO_COUNT ||
+				!riscv_reg_impl_gdb_regno_cacheable(regno, /* is write? */ false))
+			continue;
+		const struct reg *reg = riscv_reg_impl_cache_entry(target, regno);
+		if (!riscv_reg_impl_is_initialized(reg) || !reg->exist || reg->valid)
+			continue;
+		bool queued = false;
+		for (unsigned int j = 0; j < n && !queued; j++)
+			queued = regnos[j] == regno;
+		if (!queued)
+			regnos[n++] = regno;
+	}
+
+	int64_t start = perf_start();
+	res = riscv013_get_registers(target, regnos, values, read_ok, n);
+	perf_end(&riscv_reg_read_perf, start, n);
+	for (unsigned int i = 0; i < n; i++) {
+		if (!read_ok[i])
+			continue;
+		struct reg *reg = riscv_reg_impl_cache_entry(target, regnos[i]);
+		buf_set_u64(reg->value, 0, reg->size, values[i]);
+		reg->valid = true;
+		reg->dirty = false;
+		LOG_TARGET_DEBUG(target, "Read %s: 0x%" PRIx64 " (batch)", reg->name, values[i]);
+	}
+
+out:
+	free(read_ok);
+	free(values);
+	free(regnos);
+	return res;
+}
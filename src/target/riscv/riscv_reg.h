@@ -48,5 +48,12 @@ int riscv_reg_write(struct target *target, enum gdb_regno i, riscv_reg_t v);
 /** Get register, from the cache if it's in there. */
 int riscv_reg_get(struct target *target, riscv_reg_t *value,
 		enum gdb_regno r);
+/**
+ * Bring the registers in "regs" into the cache, reading as many of them as
+ * possible from the target in one batch. Registers that could not be read
+ * this way are left invalid and get read one by one on access.
+ */
+int riscv_reg_read_set(struct target *target, struct reg **regs,
+		unsigned int count);
 
 #endif /* OPENOCD_TARGET_RISCV_RISCV_REG_H */
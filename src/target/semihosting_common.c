@@ -148,6 +148,7 @@ int semihosting_common_init(struct target *target, void *setup,
 	semihosting->setup = setup;
 	semihosting->post_result = post_result;
 	semihosting->user_command_extension = NULL;
+	semihosting->user_command_sync = NULL;
 
 	target->semihosting = semihosting;
 
@@ -391,6 +392,13 @@ int semihosting_common(struct target *target)
 	/* Most operations are resumable, except the two exit calls. */
 	semihosting->is_resumable = true;
 
+	if (semihosting->user_command_sync && semihosting->user_command_sync(target) != ERROR_OK) {
+		int retval = semihosting->post_result(target);
+		if (retval != ERROR_OK)
+			LOG_ERROR("Failed to post semihosting result");
+		return retval;
+	}
+
 	int retval;
 
 	/* Enough space to hold 4 long words. */
@@ -187,6 +187,16 @@ struct semihosting {
 	 */
 	int (*user_command_extension)(struct target *target);
 
+	/**
+	 * Target's hook called before any semihosting operation is handled.
+	 * Lets the user commands write out or drop the file data they buffer,
+	 * so that the standard operations see a consistent file state.
+	 * @returns ERROR_OK to go on with the operation, otherwise the operation
+	 * failed on the buffered data, semihosting->result and
+	 * semihosting->sys_errno are set and the operation is not performed.
+	 */
+	int (*user_command_sync)(struct target *target);
+
 	int (*setup)(struct target *target, int enable);
 	int (*post_result)(struct target *target);
 };
@@ -33,6 +33,7 @@
 #include <helper/align.h>
 #include <helper/list.h>
 #include <helper/nvp.h>
+#include <helper/perf_stats.h>
 #include <helper/time_support.h>
 #include <jtag/jtag.h>
 #include <flash/nor/core.h>
@@ -212,6 +213,8 @@ static const struct nvp nvp_target_event[] = {
 	{ .value = TARGET_EVENT_TRACE_CONFIG, .name = "trace-config" },
 
 	{ .value = TARGET_EVENT_SEMIHOSTING_START, .name = "semihosting-start" }, /* Espressif */
+	{ .value = TARGET_EVENT_FLASH_JOB_PROGRESS, .name = "flash-job-progress" }, /* Espressif */
+	{ .value = TARGET_EVENT_FLASH_JOB_END, .name = "flash-job-end" }, /* Espressif */
 
 	{ .value = TARGET_EVENT_SEMIHOSTING_USER_CMD_0X100, .name = "semihosting-user-cmd-0x100" },
 	{ .value = TARGET_EVENT_SEMIHOSTING_USER_CMD_0X101, .name = "semihosting-user-cmd-0x101" },
@@ -1263,6 +1266,9 @@ bool target_memory_ready(struct target *target)
 	return target_was_examined(target);
 }
 
+static struct perf_counter target_read_memory_perf = PERF_COUNTER_INIT("target.read_memory", "bytes");
+static struct perf_counter target_write_memory_perf = PERF_COUNTER_INIT("target.write_memory", "bytes");
+
 int target_read_memory(struct target *target,
 		target_addr_t address, uint32_t size, uint32_t count, uint8_t *buffer)
 {
@@ -1274,7 +1280,10 @@ int target_read_memory(struct target *target,
 		LOG_TARGET_ERROR(target, "doesn't support read_memory");
 		return ERROR_FAIL;
 	}
-	return target->type->read_memory(target, address, size, count, buffer);
+	int64_t start = perf_start();
+	int retval = target->type->read_memory(target, address, size, count, buffer);
+	perf_end(&target_read_memory_perf, start, (uint64_t)size * count);
+	return retval;
 }
 
 int target_read_phys_memory(struct target *target,
@@ -1302,7 +1311,10 @@ int target_write_memory(struct target *target,
 		LOG_TARGET_ERROR(target, "doesn't support write_memory");
 		return ERROR_FAIL;
 	}
-	return target->type->write_memory(target, address, size, count, buffer);
+	int64_t start = perf_start();
+	int retval = target->type->write_memory(target, address, size, count, buffer);
+	perf_end(&target_write_memory_perf, start, (uint64_t)size * count);
+	return retval;
 }
 
 int target_write_phys_memory(struct target *target,
@@ -1427,6 +1439,14 @@ int target_get_gdb_reg_list_noread(struct target *target,
 	return target_get_gdb_reg_list(target, reg_list, reg_list_size, reg_class);
 }
 
+int target_read_register_set(struct target *target,
+		struct reg **reg_list, int reg_count)
+{
+	if (!target->type->read_register_set)
+		return ERROR_OK;
+	return target->type->read_register_set(target, reg_list, reg_count);
+}
+
 bool target_supports_gdb_connection(const struct target *target)
 {
 	/*
@@ -1452,6 +1472,28 @@ int target_step(struct target *target,
 	return retval;
 }
 
+int target_step_range(struct target *target, target_addr_t range_start,
+		target_addr_t range_end, bool handle_breakpoints)
+{
+	int retval;
+
+	if (!target->type->step_range) {
+		LOG_TARGET_ERROR(target, "Target type '%s' does not support range stepping",
+			target_type_name(target));
+		return ERROR_NOT_IMPLEMENTED;
+	}
+
+	target_call_event_callbacks(target, TARGET_EVENT_STEP_START);
+
+	retval = target->type->step_range(target, range_start, range_end, handle_breakpoints);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_call_event_callbacks(target, TARGET_EVENT_STEP_END);
+
+	return retval;
+}
+
 int target_get_gdb_fileio_info(struct target *target, struct gdb_fileio_info *fileio_info)
 {
 	if (target->state != TARGET_HALTED) {
@@ -1603,8 +1645,9 @@ static int target_init(struct command_context *cmd_ctx)
 	if (retval != ERROR_OK)
 		return retval;
 
-	retval = target_register_timer_callback(&handle_target,
-			polling_interval, TARGET_TIMER_TYPE_PERIODIC, cmd_ctx->interp);
+	retval = target_register_named_timer_callback(&handle_target,
+			polling_interval, TARGET_TIMER_TYPE_PERIODIC, cmd_ctx->interp,
+			"target.poll");
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -1707,13 +1750,40 @@ int target_register_trace_callback(int (*callback)(struct target *target,
 	return ERROR_OK;
 }
 
-int target_register_timer_callback(int (*callback)(void *priv),
-		unsigned int time_ms, enum target_timer_type type, void *priv)
+/* Timer callback counters by name. They stay listed by perf_stats once used,
+ * so they are never freed; names beyond the table share the last entry. */
+#define TARGET_TIMER_PERF_MAX	32
+static struct perf_counter target_timer_perf[TARGET_TIMER_PERF_MAX];
+
+static struct perf_counter *target_timer_get_perf(const char *name)
+{
+	struct perf_counter *counter = NULL;
+
+	for (unsigned int i = 0; i < TARGET_TIMER_PERF_MAX - 1; i++) {
+		counter = &target_timer_perf[i];
+		if (!counter->name[0] || !strncmp(counter->name, name, sizeof(counter->name) - 1))
+			break;
+		counter = NULL;
+	}
+	if (!counter) {
+		counter = &target_timer_perf[TARGET_TIMER_PERF_MAX - 1];
+		name = "target.timer_callback";
+	}
+	if (!counter->name[0])
+		snprintf(counter->name, sizeof(counter->name), "%s", name);
+	return counter;
+}
+
+int target_register_named_timer_callback(int (*callback)(void *priv),
+		unsigned int time_ms, enum target_timer_type type, void *priv,
+		const char *name)
 {
 	struct target_timer_callback **callbacks_p = &target_timer_callbacks;
 
 	if (!callback)
 		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (!name)
+		name = "target.timer_callback";
 
 	if (*callbacks_p) {
 		while ((*callbacks_p)->next)
@@ -1731,11 +1801,18 @@ int target_register_timer_callback(int (*callback)(void *priv),
 	target_timer_next_event_value = MIN(target_timer_next_event_value, (*callbacks_p)->when);
 
 	(*callbacks_p)->priv = priv;
+	(*callbacks_p)->perf = target_timer_get_perf(name);
 	(*callbacks_p)->next = NULL;
 
 	return ERROR_OK;
 }
 
+int target_register_timer_callback(int (*callback)(void *priv),
+		unsigned int time_ms, enum target_timer_type type, void *priv)
+{
+	return target_register_named_timer_callback(callback, time_ms, type, priv, NULL);
+}
+
 int target_unregister_event_callback(int (*callback)(struct target *target,
 		enum target_event event, void *priv), void *priv)
 {
@@ -1876,7 +1953,9 @@ static int target_timer_callback_periodic_restart(
 static int target_call_timer_callback(struct target_timer_callback *cb,
 		int64_t *now)
 {
+	int64_t start = perf_start();
 	cb->callback(cb->priv);
+	perf_end(cb->perf, start, 0);
 
 	if (cb->type == TARGET_TIMER_TYPE_PERIODIC)
 		return target_timer_callback_periodic_restart(cb, now);
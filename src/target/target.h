@@ -36,6 +36,7 @@ struct mem_param;
 struct reg_param;
 struct target_list;
 struct gdb_fileio_info;
+struct perf_counter;
 
 /*
  * TARGET_UNKNOWN = 0: we don't know anything about the target yet
@@ -320,6 +321,8 @@ enum target_event {
 	TARGET_EVENT_TRACE_CONFIG,
 
 	TARGET_EVENT_SEMIHOSTING_START, /* Espressif */
+	TARGET_EVENT_FLASH_JOB_PROGRESS, /* Espressif */
+	TARGET_EVENT_FLASH_JOB_END, /* Espressif */
 
 	TARGET_EVENT_SEMIHOSTING_USER_CMD_0X100 = 0x100, /* semihosting allows user cmds from 0x100 to 0x1ff */
 	TARGET_EVENT_SEMIHOSTING_USER_CMD_0X101 = 0x101,
@@ -363,6 +366,7 @@ struct target_timer_callback {
 	bool removed;
 	int64_t when;	/* output of timeval_ms() */
 	void *priv;
+	struct perf_counter *perf;
 	struct target_timer_callback *next;
 };
 
@@ -428,6 +432,15 @@ int target_call_trace_callbacks(struct target *target, size_t len, uint8_t *data
  */
 int target_register_timer_callback(int (*callback)(void *priv),
 		unsigned int time_ms, enum target_timer_type type, void *priv);
+/**
+ * Same as target_register_timer_callback(), @a name identifies the callback
+ * in the perf statistics and trace, e.g. "esp.apptrace.poll". Callbacks
+ * registered under the same name share a counter, NULL stands for
+ * "target.timer_callback".
+ */
+int target_register_named_timer_callback(int (*callback)(void *priv),
+		unsigned int time_ms, enum target_timer_type type, void *priv,
+		const char *name);
 int target_unregister_timer_callback(int (*callback)(void *priv), void *priv);
 int target_call_timer_callbacks(void);
 /**
@@ -552,6 +565,15 @@ int target_get_gdb_reg_list_noread(struct target *target,
 		struct reg **reg_list[], int *reg_list_size,
 		enum target_register_class reg_class);
 
+/**
+ * Prefetch the values of the registers in @a reg_list into the register cache.
+ *
+ * This routine is a wrapper for target->type->read_register_set. It does
+ * nothing for targets that don't implement it.
+ */
+int target_read_register_set(struct target *target,
+		struct reg **reg_list, int reg_count);
+
 /**
  * Check if @a target allows GDB connections.
  *
@@ -559,6 +581,16 @@ int target_get_gdb_reg_list_noread(struct target *target,
  */
 bool target_supports_gdb_connection(const struct target *target);
 
+/**
+ * Step the target until its PC leaves [@a range_start, @a range_end).
+ *
+ * This routine is a wrapper for target->type->step_range. The target may
+ * also return early with the PC still inside the range, e.g. to stay
+ * responsive while stepping a tight loop.
+ */
+int target_step_range(struct target *target, target_addr_t range_start,
+		target_addr_t range_end, bool handle_breakpoints);
+
 /**
  * Step the target.
  *
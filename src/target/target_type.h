@@ -46,6 +46,15 @@ struct target_type {
 			bool handle_breakpoints, bool debug_execution);
 	int (*step)(struct target *target, bool current, target_addr_t address,
 			bool handle_breakpoints);
+	/**
+	 * Keep single-stepping from the current PC as long as the PC stays within
+	 * [range_start, range_end) and the target stops for no other reason.
+	 * Returns with the target halted and debug_reason set like after step.
+	 * Optional; do @b not call this function directly, use
+	 * target_step_range() instead.
+	 */
+	int (*step_range)(struct target *target, target_addr_t range_start,
+			target_addr_t range_end, bool handle_breakpoints);
 	/* target reset control. assert reset can be invoked when OpenOCD and
 	 * the target is out of sync.
 	 *
@@ -106,6 +115,16 @@ struct target_type {
 			struct reg **reg_list[], int *reg_list_size,
 			enum target_register_class reg_class);
 
+	/**
+	 * Bring the values of the registers in @a reg_list into the register
+	 * cache using as few target accesses as possible. Registers that are
+	 * already valid are left alone, those that couldn't be read stay invalid.
+	 * Optional; do @b not call this function directly, use
+	 * target_read_register_set() instead.
+	 */
+	int (*read_register_set)(struct target *target, struct reg **reg_list,
+			int reg_count);
+
 	/**
 	 * Function to get target-specific memory map for GDB.
 	 * Maps memory regions (ROM, RAM, etc.) with their start addresses and lengths.
@@ -14,6 +14,8 @@
 #include <stdlib.h>
 #include <helper/time_support.h>
 #include <helper/align.h>
+#include <helper/bits.h>
+#include <helper/perf_stats.h>
 #include <target/register.h>
 #include <target/algorithm.h>
 
@@ -489,6 +491,17 @@ static int xtensa_core_reg_get(struct reg *reg)
 	return ERROR_OK;
 }
 
+/* Flag a core cache register dirty and record it for the next write-back */
+static void xtensa_reg_flag_dirty(struct xtensa *xtensa, struct reg *reg)
+{
+	reg->dirty = true;
+	if (!xtensa->core_cache || !xtensa->dirty_regs)
+		return;
+	ptrdiff_t idx = reg - xtensa->core_cache->reg_list;
+	if (idx >= 0 && (size_t)idx < xtensa->core_cache->num_regs)
+		set_bit(idx, xtensa->dirty_regs);
+}
+
 static int xtensa_core_reg_set(struct reg *reg, uint8_t *buf)
 {
 	struct xtensa *xtensa = (struct xtensa *)reg->arch_info;
@@ -522,7 +535,7 @@ static int xtensa_core_reg_set(struct reg *reg, uint8_t *buf)
 			}
 		}
 	}
-	reg->dirty = true;
+	xtensa_reg_flag_dirty(xtensa, reg);
 	reg->valid = true;
 
 	return ERROR_OK;
@@ -561,8 +574,7 @@ static enum xtensa_reg_id xtensa_canonical_to_windowbase_offset(struct xtensa *x
 
 static void xtensa_mark_register_dirty(struct xtensa *xtensa, enum xtensa_reg_id reg_idx)
 {
-	struct reg *reg_list = xtensa->core_cache->reg_list;
-	reg_list[reg_idx].dirty = true;
+	xtensa_reg_flag_dirty(xtensa, &xtensa->core_cache->reg_list[reg_idx]);
 }
 
 static void xtensa_queue_exec_ins(struct xtensa *xtensa, uint32_t ins)
@@ -716,12 +728,21 @@ static int xtensa_write_dirty_registers(struct target *target)
 		xtensa->nx_reg_idx[XT_NX_REG_IDX_MS] : reg_list_size;
 	xtensa_reg_val_t ms = 0;
 	bool restore_ms = false;
+	bool ar_dirty = false, rotate_window = false;
+	unsigned int regs_written = 0;
 
 	LOG_TARGET_DEBUG(target, "start");
 
 	/* We need to write the dirty registers in the cache list back to the processor.
-	 * Start by writing the SFR/user registers. */
+	 * Start by writing the SFR/user registers. Only those recorded in the dirty bitmap
+	 * can be dirty, so skip over the all-clear words of the bitmap. */
 	for (unsigned int i = 0; i < reg_list_size; i++) {
+		if (!xtensa->dirty_regs[BIT_WORD(i)]) {
+			i |= BITS_PER_LONG - 1;
+			continue;
+		}
+		if (!test_bit(i, xtensa->dirty_regs))
+			continue;
 		struct xtensa_reg_desc *rlist = (i < XT_NUM_REGS) ? xtensa_regs : xtensa->optregs;
 		unsigned int ridx = (i < XT_NUM_REGS) ? i : i - XT_NUM_REGS;
 		if (reg_list[i].dirty) {
@@ -784,6 +805,7 @@ static int xtensa_write_dirty_registers(struct target *target)
 					}
 				}
 				reg_list[i].dirty = false;
+				regs_written++;
 			}
 		}
 	}
@@ -798,18 +820,28 @@ static int xtensa_write_dirty_registers(struct target *target)
 				xtensa_regs[XT_REG_IDX_CPENABLE].reg_num,
 				XT_REG_A3));
 		reg_list[XT_REG_IDX_CPENABLE].dirty = false;
+		regs_written++;
 	}
 
-	preserve_a3 = (xtensa->core_config->windowed) || (xtensa->core_config->core_type == XT_NX);
+	/* After the A/AR writes below, A3 is only used as scratch by the delayed MS write.
+	 * The cache already holds the value it has to get back (A3 is flagged dirty if it was
+	 * used as scratch above), so only read it from the core if the cache entry is stale. */
+	preserve_a3 = restore_ms &&
+		((xtensa->core_config->windowed) || (xtensa->core_config->core_type == XT_NX));
 	if (preserve_a3) {
-		/* Save (windowed) A3 for scratch use */
-		xtensa_queue_exec_ins(xtensa, XT_INS_WSR(xtensa, XT_SR_DDR, XT_REG_A3));
-		xtensa_queue_dbg_reg_read(xtensa, XDMREG_DDR, a3_buf);
-		res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
-		if (res != ERROR_OK)
-			return res;
-		xtensa_core_status_check(target);
-		a3 = buf_get_u32(a3_buf, 0, 32);
+		if (reg_list[XT_REG_IDX_A3].valid || reg_list[XT_REG_IDX_A3].dirty) {
+			a3 = xtensa_reg_get(target, XT_REG_IDX_A3);
+		} else {
+			/* Save (windowed) A3 for scratch use */
+			xtensa_queue_exec_ins(xtensa, XT_INS_WSR(xtensa, XT_SR_DDR, XT_REG_A3));
+			xtensa_queue_dbg_reg_read(xtensa, XDMREG_DDR, a3_buf);
+			res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
+			if (res != ERROR_OK)
+				return res;
+			xtensa_core_status_check(target);
+			a3 = buf_get_u32(a3_buf, 0, 32);
+			xtensa->regs_wb_stats.a3_reads++;
+		}
 	}
 
 	if (xtensa->core_config->windowed) {
@@ -848,6 +880,19 @@ static int xtensa_write_dirty_registers(struct target *target)
 				}
 			}
 		}
+
+		/* The window only has to be rotated if a dirty AR is outside of the current one */
+		for (unsigned int i = 0; i < xtensa->core_config->aregs_num; i++) {
+			enum xtensa_reg_id realadr =
+				xtensa_windowbase_offset_to_canonical(xtensa, XT_REG_IDX_AR0 + i, windowbase);
+			if (reg_list[realadr].dirty) {
+				ar_dirty = true;
+				if (i >= 16) {
+					rotate_window = true;
+					break;
+				}
+			}
+		}
 	}
 
 	/* Write A0-A16. */
@@ -861,6 +906,7 @@ static int xtensa_write_dirty_registers(struct target *target)
 			xtensa_queue_dbg_reg_write(xtensa, XDMREG_DDR, regval);
 			xtensa_queue_exec_ins(xtensa, XT_INS_RSR(xtensa, XT_SR_DDR, i));
 			reg_list[XT_REG_IDX_A0 + i].dirty = false;
+			regs_written++;
 			if (i == 3) {
 				/* Avoid stomping A3 during restore at end of function */
 				a3 = regval;
@@ -868,9 +914,10 @@ static int xtensa_write_dirty_registers(struct target *target)
 		}
 	}
 
-	if (xtensa->core_config->windowed) {
+	if (ar_dirty) {
 		/* Now write AR registers */
-		for (unsigned int j = 0; j < XT_REG_IDX_ARLAST; j += 16) {
+		unsigned int ar_end = rotate_window ? XT_REG_IDX_ARLAST : 16;
+		for (unsigned int j = 0; j < ar_end; j += 16) {
 			/* Write the 16 registers we can see */
 			for (unsigned int i = 0; i < 16; i++) {
 				if (i + j < xtensa->core_config->aregs_num) {
@@ -891,6 +938,7 @@ static int xtensa_write_dirty_registers(struct target *target)
 							XT_INS_RSR(xtensa, XT_SR_DDR,
 								xtensa_regs[XT_REG_IDX_AR0 + i].reg_num));
 						reg_list[realadr].dirty = false;
+						regs_written++;
 						if ((i + j) == 3)
 							/* Avoid stomping AR during A3 restore at end of function */
 							a3 = regval;
@@ -898,13 +946,17 @@ static int xtensa_write_dirty_registers(struct target *target)
 				}
 			}
 
+			if (!rotate_window)
+				break;
 			/* Now rotate the window so we'll see the next 16 registers. The final rotate
 			 * will wraparound, leaving us in the state we were.
 			 * Each ROTW rotates 4 registers on LX and 8 on NX */
 			int rotw_arg = (xtensa->core_config->core_type == XT_LX) ? 4 : 2;
 			xtensa_queue_exec_ins(xtensa, XT_INS_ROTW(xtensa, rotw_arg));
 		}
+	}
 
+	if (xtensa->core_config->windowed) {
 		for (enum xtensa_ar_scratch_set_e s = 0; s < XT_AR_SCRATCH_NUM; s++)
 			xtensa->scratch_ars[s].intval = false;
 	}
@@ -925,6 +977,29 @@ static int xtensa_write_dirty_registers(struct target *target)
 	res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
 	xtensa_core_status_check(target);
 
+	/* Keep only the registers which are still dirty (e.g. not writable) in the bitmap */
+	for (unsigned int i = 0; i < reg_list_size; i++) {
+		if (!xtensa->dirty_regs[BIT_WORD(i)]) {
+			i |= BITS_PER_LONG - 1;
+			continue;
+		}
+		if (!reg_list[i].dirty)
+			clear_bit(i, xtensa->dirty_regs);
+	}
+
+	if (regs_written) {
+		struct xtensa_regs_wb_stats *stats = &xtensa->regs_wb_stats;
+		stats->writebacks++;
+		stats->regs += regs_written;
+		stats->last_regs = regs_written;
+		if (regs_written > stats->max_regs)
+			stats->max_regs = regs_written;
+		if (rotate_window)
+			stats->rotations++;
+	}
+	LOG_TARGET_DEBUG(target, "Wrote back %u registers%s", regs_written,
+		rotate_window ? " (window rotated)" : "");
+
 	return res;
 }
 
@@ -1023,10 +1098,10 @@ static inline xtensa_reg_val_t xtensa_reg_get_value(struct reg *reg)
 	return buf_get_u32(reg->value, 0, 32);
 }
 
-static inline void xtensa_reg_set_value(struct reg *reg, xtensa_reg_val_t value)
+static inline void xtensa_reg_set_value(struct xtensa *xtensa, struct reg *reg, xtensa_reg_val_t value)
 {
 	buf_set_u32(reg->value, 0, 32, value);
-	reg->dirty = true;
+	xtensa_reg_flag_dirty(xtensa, reg);
 }
 
 static int xtensa_imprecise_exception_occurred(struct target *target)
@@ -1129,7 +1204,7 @@ void xtensa_reg_set(struct target *target, enum xtensa_reg_id reg_id, xtensa_reg
 	struct reg *reg = &xtensa->core_cache->reg_list[reg_id];
 	if (xtensa_reg_get_value(reg) == value)
 		return;
-	xtensa_reg_set_value(reg, value);
+	xtensa_reg_set_value(xtensa, reg, value);
 }
 
 /* Set Ax (XT_REG_RELGEN) register along with its underlying ARx (XT_REG_GENERAL) */
@@ -1263,6 +1338,8 @@ int xtensa_soft_reset_halt(struct target *target)
 	return xtensa_assert_reset(target);
 }
 
+static struct perf_counter xtensa_reg_fetch_perf = PERF_COUNTER_INIT("xtensa.reg_fetch", "regs");
+
 int xtensa_fetch_all_regs(struct target *target)
 {
 	struct xtensa *xtensa = target_to_xtensa(target);
@@ -1273,6 +1350,7 @@ int xtensa_fetch_all_regs(struct target *target)
 	uint32_t ms = 0;
 	uint8_t a0_buf[4], a3_buf[4], ms_buf[4];
 	bool debug_dsrs = !xtensa->regs_fetched || LOG_LEVEL_IS(LOG_LVL_DEBUG);
+	int64_t start = perf_start();
 
 	union xtensa_reg_val_u *regvals = calloc(reg_list_size, sizeof(*regvals));
 	if (!regvals) {
@@ -1503,6 +1581,8 @@ int xtensa_fetch_all_regs(struct target *target)
 				}
 				xtensa_reg_set(target, i, regval);
 				reg_list[i].dirty = is_dirty;	/*always do this _after_ xtensa_reg_set! */
+				if (is_dirty)
+					set_bit(i, xtensa->dirty_regs);
 			}
 			reg_list[i].valid = true;
 		} else {
@@ -1525,6 +1605,7 @@ int xtensa_fetch_all_regs(struct target *target)
 	}
 
 	xtensa->regs_fetched = true;
+	perf_end(&xtensa_reg_fetch_perf, start, reg_list_size);
 xtensa_fetch_all_regs_done:
 	free(regvals);
 	free(dsrs);
@@ -1635,6 +1716,21 @@ int xtensa_halt(struct target *target)
 	return res;
 }
 
+static void xtensa_debug_reason_set(struct target *target, uint32_t halt_cause)
+{
+	/* TODO: Add handling of DBG_REASON_EXC_CATCH */
+	if (halt_cause & DEBUGCAUSE_IC)
+		target->debug_reason = DBG_REASON_SINGLESTEP;
+	if (halt_cause & (DEBUGCAUSE_IB | DEBUGCAUSE_BN | DEBUGCAUSE_BI)) {
+		if (halt_cause & DEBUGCAUSE_DB)
+			target->debug_reason = DBG_REASON_WPTANDBKPT;
+		else
+			target->debug_reason = DBG_REASON_BREAKPOINT;
+	} else if (halt_cause & DEBUGCAUSE_DB) {
+		target->debug_reason = DBG_REASON_WATCHPOINT;
+	}
+}
+
 int xtensa_prepare_resume(struct target *target,
 	bool current,
 	target_addr_t address,
@@ -1990,6 +2086,180 @@ int xtensa_step(struct target *target, bool current, target_addr_t address,
 	return ERROR_OK;
 }
 
+/* Single-step LX core with ICOUNT as long as PC stays in [start, end), the core stops for no
+ * other reason and the deadline isn't reached. Unlike xtensa_do_step() nothing goes through
+ * the register cache between the steps: ICOUNT is armed and PC/DEBUGCAUSE are read with A3
+ * borrowed via XSR, so each step takes only two queue executions. The cache is re-fetched
+ * once at the end. */
+static int xtensa_step_range_fast(struct target *target, target_addr_t start, target_addr_t end,
+	int64_t deadline)
+{
+	struct xtensa *xtensa = target_to_xtensa(target);
+	const uint32_t icount_val = -2;	/* ICOUNT value to load for 1 step */
+	const unsigned int epc_num = XT_EPC_REG_NUM_BASE + xtensa->core_config->debug.irq_level;
+	const unsigned int icount_num = xtensa_regs[XT_REG_IDX_ICOUNT].reg_num;
+	const unsigned int cause_num = xtensa_regs[XT_REG_IDX_DEBUGCAUSE].reg_num;
+	xtensa_reg_val_t oldps = xtensa_reg_get(target, xtensa->eps_dbglevel_idx);
+	xtensa_reg_val_t pc = xtensa_reg_get(target, XT_REG_IDX_PC);
+	xtensa_reg_val_t cause = DEBUGCAUSE_IC;
+	uint8_t dsr_buf[4], pc_buf[4], cause_buf[4];
+	unsigned int steps = 0;
+	bool timed_out = false;
+	int res;
+
+	/* Same ICOUNTLEVEL and interrupt masking as xtensa_do_step(), written once for all steps */
+	if (xtensa->stepping_isr_mode == XT_STEPPING_ISR_OFF)
+		xtensa_reg_set(target, xtensa->eps_dbglevel_idx,
+			(oldps & ~0xF) | (xtensa->core_config->debug.irq_level - 1));
+	xtensa_reg_set(target, XT_REG_IDX_ICOUNTLEVEL, xtensa->core_config->debug.irq_level);
+	res = xtensa_write_dirty_registers(target);
+	if (res != ERROR_OK)
+		goto restore;
+
+	while (true) {
+		/* Arm ICOUNT and leave debug mode, A3 keeps its value */
+		xtensa_queue_dbg_reg_write(xtensa, XDMREG_DDR, icount_val);
+		xtensa_queue_exec_ins(xtensa, XT_INS_XSR(xtensa, XT_SR_DDR, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_WSR(xtensa, icount_num, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_XSR(xtensa, XT_SR_DDR, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_RFDO(xtensa));
+		xtensa_queue_dbg_reg_read(xtensa, XDMREG_DSR, dsr_buf);
+		res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
+		if (res != ERROR_OK)
+			break;
+		xtensa->dbg_mod.core_status.dsr = buf_get_u32(dsr_buf, 0, 32);
+
+		/* One instruction is usually done by the time DSR is scanned, poll otherwise */
+		long long start_ms = timeval_ms();
+		while ((xtensa_dm_core_status_get(&xtensa->dbg_mod) & (OCDDSR_STOPPED | OCDDSR_EXECBUSY)) !=
+			OCDDSR_STOPPED && timeval_ms() < start_ms + 500) {
+			usleep(1000);
+			res = xtensa_dm_core_status_read(&xtensa->dbg_mod);
+			if (res != ERROR_OK)
+				break;
+		}
+		if (res != ERROR_OK)
+			break;
+		if (!xtensa_is_stopped(target)) {
+			LOG_TARGET_WARNING(target,
+				"Timed out waiting for target to finish stepping. dsr=0x%08" PRIx32,
+				xtensa_dm_core_status_get(&xtensa->dbg_mod));
+			timed_out = true;
+			break;
+		}
+		steps++;
+
+		/* Fetch PC and DEBUGCAUSE only */
+		xtensa_queue_exec_ins(xtensa, XT_INS_WSR(xtensa, XT_SR_DDR, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_RSR(xtensa, epc_num, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_XSR(xtensa, XT_SR_DDR, XT_REG_A3));
+		xtensa_queue_dbg_reg_read(xtensa, XDMREG_DDR, pc_buf);
+		xtensa_queue_exec_ins(xtensa, XT_INS_WSR(xtensa, XT_SR_DDR, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_RSR(xtensa, cause_num, XT_REG_A3));
+		xtensa_queue_exec_ins(xtensa, XT_INS_XSR(xtensa, XT_SR_DDR, XT_REG_A3));
+		xtensa_queue_dbg_reg_read(xtensa, XDMREG_DDR, cause_buf);
+		res = xtensa_dm_queue_execute(&xtensa->dbg_mod);
+		if (res != ERROR_OK)
+			break;
+		pc = buf_get_u32(pc_buf, 0, 32);
+		cause = buf_get_u32(cause_buf, 0, 32);
+
+		if ((cause & ~DEBUGCAUSE_IC) || !(cause & DEBUGCAUSE_IC))
+			break;
+		if (pc < start || pc >= end)
+			break;
+		if (timeval_ms() >= deadline)
+			break;
+	}
+	LOG_TARGET_DEBUG(target, "Range stepped %u instructions, PC=%" PRIX32 " dbg_cause=%" PRIx32,
+		steps, pc, cause);
+
+	if (timed_out) {
+		/* The masked interrupt level and ICOUNTLEVEL can only be undone on a stopped core */
+		target->state = TARGET_RUNNING;
+		if (xtensa_halt(target) == ERROR_OK) {
+			long long start_ms = timeval_ms();
+			while (!xtensa_is_stopped(target) && timeval_ms() < start_ms + 500) {
+				usleep(1000);
+				if (xtensa_dm_core_status_read(&xtensa->dbg_mod) != ERROR_OK)
+					break;
+			}
+		}
+		if (!xtensa_is_stopped(target)) {
+			LOG_TARGET_ERROR(target, "Core did not halt, PS and ICOUNTLEVEL are left modified");
+			target->debug_reason = DBG_REASON_NOTHALTED;
+			target->state = TARGET_RUNNING;
+			return ERROR_FAIL;
+		}
+		res = ERROR_FAIL;
+	}
+
+	/* Bring the register cache in sync with the core again */
+	target->state = TARGET_HALTED;
+	xtensa_fetch_all_regs(target);
+	if (res == ERROR_OK) {
+		target->debug_reason = DBG_REASON_SINGLESTEP;
+		xtensa_debug_reason_set(target, xtensa_cause_get(target));
+	} else {
+		target->debug_reason = DBG_REASON_DBGRQ;
+	}
+
+restore:
+	/* Restore int level and clear ICOUNTLEVEL on the core, whatever the outcome */
+	if (xtensa->stepping_isr_mode == XT_STEPPING_ISR_OFF) {
+		xtensa_reg_val_t newps = xtensa_reg_get(target, xtensa->eps_dbglevel_idx);
+		newps = (newps & ~0xF) | (oldps & 0xf);
+		xtensa_reg_set(target, xtensa->eps_dbglevel_idx, newps);
+	}
+	xtensa_reg_set(target, XT_REG_IDX_ICOUNTLEVEL, 0);
+	int restore_res = xtensa_write_dirty_registers(target);
+	return res != ERROR_OK ? res : restore_res;
+}
+
+int xtensa_do_step_range(struct target *target, target_addr_t start, target_addr_t end,
+	bool handle_breakpoints)
+{
+	struct xtensa *xtensa = target_to_xtensa(target);
+	/* Return to the server now and then, gdb just asks again if PC is still in range */
+	int64_t deadline = timeval_ms() + 1000;
+	xtensa_reg_val_t pc;
+
+	LOG_TARGET_DEBUG(target, "range [" TARGET_ADDR_FMT ", " TARGET_ADDR_FMT ")", start, end);
+
+	/* The first step takes care of breakpoints/watchpoints at the current PC */
+	int res = xtensa_do_step(target, true, 0, handle_breakpoints);
+	while (res == ERROR_OK) {
+		pc = xtensa_reg_get(target, XT_REG_IDX_PC);
+		if (xtensa->core_config->windowed &&
+			xtensa->stepping_isr_mode == XT_STEPPING_ISR_OFF &&
+			xtensa_pc_in_winexc(target, pc)) {
+			/* xtensa_do_step() steps out of window exception handlers */
+			res = xtensa_do_step(target, true, 0, handle_breakpoints);
+			continue;
+		}
+		if (target->debug_reason != DBG_REASON_SINGLESTEP || pc < start || pc >= end ||
+			timeval_ms() >= deadline)
+			break;
+		keep_alive();
+		if (xtensa->core_config->core_type == XT_LX)
+			res = xtensa_step_range_fast(target, start, end, deadline);
+		else
+			res = xtensa_do_step(target, true, 0, handle_breakpoints);
+	}
+	return res;
+}
+
+int xtensa_step_range(struct target *target, target_addr_t start, target_addr_t end,
+	bool handle_breakpoints)
+{
+	int retval = xtensa_do_step_range(target, start, end, handle_breakpoints);
+	if (retval != ERROR_OK)
+		return retval;
+	target_call_event_callbacks(target, TARGET_EVENT_HALTED);
+
+	return ERROR_OK;
+}
+
 /**
  * Returns true if two ranges are overlapping
  */
@@ -2425,17 +2695,7 @@ int xtensa_poll(struct target *target)
 			/* Watchpoint and breakpoint events at the same time results in special
 			 * debug reason: DBG_REASON_WPTANDBKPT. */
 			uint32_t halt_cause = xtensa_cause_get(target);
-			/* TODO: Add handling of DBG_REASON_EXC_CATCH */
-			if (halt_cause & DEBUGCAUSE_IC)
-				target->debug_reason = DBG_REASON_SINGLESTEP;
-			if (halt_cause & (DEBUGCAUSE_IB | DEBUGCAUSE_BN | DEBUGCAUSE_BI)) {
-				if (halt_cause & DEBUGCAUSE_DB)
-					target->debug_reason = DBG_REASON_WPTANDBKPT;
-				else
-					target->debug_reason = DBG_REASON_BREAKPOINT;
-			} else if (halt_cause & DEBUGCAUSE_DB) {
-				target->debug_reason = DBG_REASON_WATCHPOINT;
-			}
+			xtensa_debug_reason_set(target, halt_cause);
 			LOG_TARGET_DEBUG(target, "Target halted, pc=0x%08" PRIx32
 				", debug_reason=%08" PRIx32 ", oldstate=%08" PRIx32,
 				xtensa_reg_get(target, XT_REG_IDX_PC),
@@ -2861,7 +3121,7 @@ int xtensa_start_algorithm(struct target *target,
 			assert(reg_id < xtensa->core_cache->num_regs && "Attempt to access non-existing reg!");
 			reg = &xtensa->core_cache->reg_list[reg_id];
 		}
-		xtensa_reg_set_value(reg, buf_get_u32(reg_params[i].value, 0, reg->size));
+		xtensa_reg_set_value(xtensa, reg, buf_get_u32(reg_params[i].value, 0, reg->size));
 		reg->valid = 1;
 	}
 	/* ignore custom core mode if custom PS value is specified */
@@ -2977,7 +3237,7 @@ int xtensa_wait_algorithm(struct target *target,
 				LOG_DEBUG("restoring register %s %u-bits", xtensa->core_cache->reg_list[i].name, reg->size);
 			}
 			buf_cpy(xtensa->algo_context_backup[i], reg->value, reg->size);
-			xtensa->core_cache->reg_list[i].dirty = 1;
+			xtensa_reg_flag_dirty(xtensa, reg);
 			xtensa->core_cache->reg_list[i].valid = 1;
 		}
 	}
@@ -3018,7 +3278,6 @@ int xtensa_run_algorithm(struct target *target,
 static int xtensa_build_reg_cache(struct target *target)
 {
 	struct xtensa *xtensa = target_to_xtensa(target);
-	struct reg_cache **cache_p = register_get_last_cache_p(&target->reg_cache);
 	unsigned int last_dbreg_num = 0;
 
 	if (xtensa->core_regs_num + xtensa->num_optregs != xtensa->total_regs_num)
@@ -3148,9 +3407,13 @@ static int xtensa_build_reg_cache(struct target *target)
 			goto fail;
 		}
 	}
+	xtensa->dirty_regs = calloc(BITS_TO_LONGS(reg_cache->num_regs), sizeof(unsigned long));
+	if (!xtensa->dirty_regs) {
+		LOG_ERROR("Failed to alloc mem for dirty registers bitmap!");
+		goto fail;
+	}
 	xtensa->core_cache = reg_cache;
-	if (cache_p)
-		*cache_p = reg_cache;
+	register_link_cache(&target->reg_cache, reg_cache);
 	return ERROR_OK;
 
 fail:
@@ -3171,6 +3434,8 @@ fail:
 			free(xtensa->algo_context_backup[i]);
 		free(xtensa->algo_context_backup);
 	}
+	free(xtensa->dirty_regs);
+	xtensa->dirty_regs = NULL;
 	free(reg_cache);
 
 	return ERROR_FAIL;
@@ -3549,6 +3814,8 @@ static void xtensa_free_reg_cache(struct target *target)
 	}
 	xtensa->core_cache = NULL;
 	xtensa->algo_context_backup = NULL;
+	free(xtensa->dirty_regs);
+	xtensa->dirty_regs = NULL;
 
 	if (xtensa->empty_regs) {
 		for (unsigned int i = 0; i < xtensa->dbregs_num; i++) {
@@ -4266,6 +4533,34 @@ COMMAND_HANDLER(xtensa_cmd_perfmon_dump)
 		target_to_xtensa(get_current_target(CMD_CTX)));
 }
 
+/* regstats [reset] */
+COMMAND_HELPER(xtensa_cmd_regstats_do, struct xtensa *xtensa)
+{
+	struct xtensa_regs_wb_stats *stats = &xtensa->regs_wb_stats;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset"))
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		memset(stats, 0, sizeof(*stats));
+		return ERROR_OK;
+	}
+
+	command_print(CMD, "write-backs: %u, registers: %" PRIu64 " (avg %" PRIu64 ", max %u, last %u)",
+		stats->writebacks, stats->regs,
+		stats->writebacks ? stats->regs / stats->writebacks : 0,
+		stats->max_regs, stats->last_regs);
+	command_print(CMD, "window rotations: %u, A3 reads: %u", stats->rotations, stats->a3_reads);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(xtensa_cmd_regstats)
+{
+	return CALL_COMMAND_HANDLER(xtensa_cmd_regstats_do,
+		target_to_xtensa(get_current_target(CMD_CTX)));
+}
+
 COMMAND_HELPER(xtensa_cmd_mask_interrupts_do, struct xtensa *xtensa)
 {
 	int state = -1;
@@ -4671,6 +4966,13 @@ static const struct command_registration xtensa_any_command_handlers[] = {
 		.help = "Dump performance counter value. If no argument specified, dumps all counters.",
 		.usage = "[counter_id]",
 	},
+	{
+		.name = "regstats",
+		.handler = xtensa_cmd_regstats,
+		.mode = COMMAND_EXEC,
+		.help = "Show or reset statistics of register write-backs done on resume/step",
+		.usage = "['reset']",
+	},
 	{
 		.name = "tracestart",
 		.handler = xtensa_cmd_tracestart,
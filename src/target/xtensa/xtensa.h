@@ -237,6 +237,16 @@ struct xtensa_algorithm {
 
 #define XTENSA_COMMON_MAGIC 0x54E4E555U
 
+/* Register write-back statistics, see "xtensa regstats" */
+struct xtensa_regs_wb_stats {
+	unsigned int writebacks;	/* number of write-backs which had something to write */
+	uint64_t regs;			/* registers written back in total */
+	unsigned int last_regs;		/* registers written by the most recent write-back */
+	unsigned int max_regs;
+	unsigned int a3_reads;		/* write-backs which had to read A3 from the core */
+	unsigned int rotations;		/* write-backs which had to rotate the register window */
+};
+
 /**
  * Represents a generic Xtensa core.
  */
@@ -288,6 +298,10 @@ struct xtensa {
 	struct xtensa_keyval_info scratch_ars[XT_AR_SCRATCH_NUM];
 	bool regs_fetched;	/* true after first register fetch completed successfully */
 	xtensa_tie_reg_access_fn tie_reg_access;
+	/* Indexes of core_cache registers which may be dirty. Bits are set whenever a register is
+	 * flagged dirty and cleared by the write-back, so it never has to walk the whole cache. */
+	unsigned long *dirty_regs;
+	struct xtensa_regs_wb_stats regs_wb_stats;
 };
 
 static inline struct xtensa *target_to_xtensa(struct target *target)
@@ -339,6 +353,27 @@ static inline int xtensa_queue_dbg_reg_read(struct xtensa *xtensa, enum xtensa_d
 	return dm->dbg_ops->queue_reg_read(dm, reg, data);
 }
 
+static inline int xtensa_queue_dbg_reg_read_stream(struct xtensa *xtensa, enum xtensa_dm_reg reg, uint8_t *data,
+	uint32_t count)
+{
+	struct xtensa_debug_module *dm = &xtensa->dbg_mod;
+
+	if (!dm->dbg_ops->queue_reg_read_stream) {
+		for (uint32_t i = 0; i < count; i++) {
+			int res = xtensa_queue_dbg_reg_read(xtensa, reg, data + i * 4);
+			if (res != ERROR_OK)
+				return res;
+		}
+		return ERROR_OK;
+	}
+	if (!xtensa->core_config->trace.enabled &&
+		(reg <= XDMREG_MEMADDREND || (reg >= XDMREG_PMG && reg <= XDMREG_PMSTAT7))) {
+		LOG_ERROR("Can not access %u reg when Trace Port option disabled!", reg);
+		return ERROR_FAIL;
+	}
+	return dm->dbg_ops->queue_reg_read_stream(dm, reg, data, count);
+}
+
 static inline int xtensa_queue_dbg_reg_write(struct xtensa *xtensa, enum xtensa_dm_reg reg, uint32_t data)
 {
 	struct xtensa_debug_module *dm = &xtensa->dbg_mod;
@@ -401,6 +436,10 @@ int xtensa_step(struct target *target, bool current, target_addr_t address,
 		bool handle_breakpoints);
 int xtensa_do_step(struct target *target, bool current, target_addr_t address,
 		bool handle_breakpoints);
+int xtensa_step_range(struct target *target, target_addr_t start, target_addr_t end,
+		bool handle_breakpoints);
+int xtensa_do_step_range(struct target *target, target_addr_t start, target_addr_t end,
+		bool handle_breakpoints);
 int xtensa_mmu_is_enabled(struct target *target, bool *enabled);
 int xtensa_read_memory(struct target *target, target_addr_t address, uint32_t size, uint32_t count, uint8_t *buffer);
 int xtensa_read_buffer(struct target *target, target_addr_t address, uint32_t count, uint8_t *buffer);
@@ -453,6 +492,7 @@ COMMAND_HELPER(xtensa_cmd_perfmon_enable_do, struct xtensa *xtensa);
 COMMAND_HELPER(xtensa_cmd_tracestart_do, struct xtensa *xtensa);
 COMMAND_HELPER(xtensa_cmd_tracestop_do, struct xtensa *xtensa);
 COMMAND_HELPER(xtensa_cmd_tracedump_do, struct xtensa *xtensa, const char *fname);
+COMMAND_HELPER(xtensa_cmd_regstats_do, struct xtensa *xtensa);
 
 extern const struct command_registration xtensa_command_handlers[];
 
@@ -73,6 +73,7 @@ static int xtensa_chip_virt2phys(struct target *target,
 static const struct xtensa_debug_ops xtensa_chip_dm_dbg_ops = {
 	.queue_enable = xtensa_dm_queue_enable,
 	.queue_reg_read = xtensa_dm_queue_reg_read,
+	.queue_reg_read_stream = xtensa_dm_queue_reg_read_stream,
 	.queue_reg_write = xtensa_dm_queue_reg_write
 };
 
@@ -157,6 +158,7 @@ struct target_type xtensa_chip_target = {
 	.halt = xtensa_halt,
 	.resume = xtensa_resume,
 	.step = xtensa_step,
+	.step_range = xtensa_step_range,
 
 	.assert_reset = xtensa_assert_reset,
 	.deassert_reset = xtensa_deassert_reset,
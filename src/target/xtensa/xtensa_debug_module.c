@@ -11,6 +11,7 @@
 #endif
 
 #include <helper/align.h>
+#include <helper/perf_stats.h>
 #include "xtensa_debug_module.h"
 
 #define TAPINS_PWRCTL           0x08
@@ -44,6 +45,8 @@ static enum xtensa_dm_reg xtensa_dm_regaddr_to_id(uint32_t addr)
 	return id;
 }
 
+static struct perf_counter xtensa_dm_ir_elided_perf = PERF_COUNTER_INIT("xtensa.ir_scan_elided", "bits");
+
 static void xtensa_dm_add_set_ir(struct xtensa_debug_module *dm, uint8_t value)
 {
 	struct scan_field field;
@@ -71,6 +74,48 @@ static void xtensa_dm_add_dr_scan(struct xtensa_debug_module *dm,
 	jtag_add_dr_scan(dm->tap, 1, &field, endstate);
 }
 
+/* Select NARSEL unless the TAP still holds it from the previous register
+ * access. The JTAG core keeps cur_instr up to date for every IR scan on the
+ * chain, including the ones which put this TAP into BYPASS. After a failed
+ * queue the IR scan is always done, as it also resets NARSEL to the NAR. */
+static void xtensa_dm_select_narsel(struct xtensa_debug_module *dm)
+{
+	if (dm->narsel_resync) {
+		dm->narsel_resync = false;
+	} else if (!dm->tap->bypass &&
+			buf_get_u32(dm->tap->cur_instr, 0, dm->tap->ir_length) == TAPINS_NARSEL) {
+		if (perf_stats_enabled) {
+			unsigned int ir_bits = 0;
+			for (struct jtag_tap *tap = jtag_tap_next_enabled(NULL); tap; tap = jtag_tap_next_enabled(tap))
+				ir_bits += tap->ir_length;
+			perf_count(&xtensa_dm_ir_elided_perf, ir_bits);
+		}
+		return;
+	}
+	xtensa_dm_add_set_ir(dm, TAPINS_NARSEL);
+}
+
+/* Queue the NAR scan selecting the register and the NDR scan transferring its
+ * value as one sequence. The NAR has to pass Update-DR to take effect. */
+static void xtensa_dm_add_nar_ndr_scan(struct xtensa_debug_module *dm,
+	uint8_t nar,
+	const uint8_t *ndr_out,
+	uint8_t *ndr_in)
+{
+	struct scan_field fields[2];
+
+	memset(fields, 0, sizeof(fields));
+	fields[0].num_bits = TAPINS_NARSEL_ADRLEN;
+	fields[0].out_value = &nar;
+	fields[1].num_bits = TAPINS_NARSEL_DATALEN;
+	fields[1].out_value = ndr_out;
+	fields[1].in_value = ndr_in;
+
+	xtensa_dm_select_narsel(dm);
+	jtag_add_dr_scan(dm->tap, 1, &fields[0], TAP_IDLE);
+	jtag_add_dr_scan(dm->tap, 1, &fields[1], TAP_IDLE);
+}
+
 int xtensa_dm_init(struct xtensa_debug_module *dm, const struct xtensa_debug_module_config *cfg)
 {
 	if (!dm || !cfg)
@@ -172,9 +217,30 @@ int xtensa_dm_queue_reg_read(struct xtensa_debug_module *dm, enum xtensa_dm_reg
 		return mem_ap_read_buf(dm->debug_ap, value, 4, 1, xdm_regs[reg].apb + dm->ap_offset);
 	uint8_t regdata = (xdm_regs[reg].nar << 1) | 0;
 	uint8_t dummy[4] = { 0, 0, 0, 0 };
-	xtensa_dm_add_set_ir(dm, TAPINS_NARSEL);
-	xtensa_dm_add_dr_scan(dm, TAPINS_NARSEL_ADRLEN, &regdata, NULL, TAP_IDLE);
-	xtensa_dm_add_dr_scan(dm, TAPINS_NARSEL_DATALEN, dummy, value, TAP_IDLE);
+	xtensa_dm_add_nar_ndr_scan(dm, regdata, dummy, value);
+	return ERROR_OK;
+}
+
+/* Read the register @a count times into consecutive words of @a value. Intended for
+ * FIFO-like registers, e.g. TRAXDATA which advances TRAXADDR on every read. Over APB
+ * this is one non-incrementing block read. JTAG has no faster sequence than the
+ * NAR+NDR pair per word xtensa_dm_queue_reg_read() queues, so that is used there. */
+int xtensa_dm_queue_reg_read_stream(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint8_t *value,
+	uint32_t count)
+{
+	if (reg >= XDMREG_NUM) {
+		LOG_ERROR("Invalid DBG reg ID %d!", reg);
+		return ERROR_FAIL;
+	}
+	if (count == 0)
+		return ERROR_OK;
+	if (dm->dap)
+		return mem_ap_read_buf_noincr(dm->debug_ap, value, 4, count, xdm_regs[reg].apb + dm->ap_offset);
+	for (uint32_t i = 0; i < count; i++) {
+		int res = xtensa_dm_queue_reg_read(dm, reg, value + i * 4);
+		if (res != ERROR_OK)
+			return res;
+	}
 	return ERROR_OK;
 }
 
@@ -188,9 +254,7 @@ int xtensa_dm_queue_reg_write(struct xtensa_debug_module *dm, enum xtensa_dm_reg
 		return mem_ap_write_u32(dm->debug_ap, xdm_regs[reg].apb + dm->ap_offset, value);
 	uint8_t regdata = (xdm_regs[reg].nar << 1) | 1;
 	uint8_t valdata[] = { value, value >> 8, value >> 16, value >> 24 };
-	xtensa_dm_add_set_ir(dm, TAPINS_NARSEL);
-	xtensa_dm_add_dr_scan(dm, TAPINS_NARSEL_ADRLEN, &regdata, NULL, TAP_IDLE);
-	xtensa_dm_add_dr_scan(dm, TAPINS_NARSEL_DATALEN, valdata, NULL, TAP_IDLE);
+	xtensa_dm_add_nar_ndr_scan(dm, regdata, valdata, NULL);
 	return ERROR_OK;
 }
 
@@ -431,8 +495,15 @@ int xtensa_dm_trace_data_read(struct xtensa_debug_module *dm, uint8_t *dest, uin
 	if (!dest)
 		return ERROR_FAIL;
 
-	for (unsigned int i = 0; i < size / 4; i++)
-		dm->dbg_ops->queue_reg_read(dm, XDMREG_TRAXDATA, &dest[i * 4]);
+	int res = ERROR_OK;
+	if (dm->dbg_ops->queue_reg_read_stream) {
+		res = dm->dbg_ops->queue_reg_read_stream(dm, XDMREG_TRAXDATA, dest, size / 4);
+	} else {
+		for (unsigned int i = 0; i < size / 4 && res == ERROR_OK; i++)
+			res = dm->dbg_ops->queue_reg_read(dm, XDMREG_TRAXDATA, &dest[i * 4]);
+	}
+	if (res != ERROR_OK)
+		return res;
 	xtensa_dm_queue_tdi_idle(dm);
 	return xtensa_dm_queue_execute(dm);
 }
@@ -398,6 +398,10 @@ struct xtensa_debug_ops {
 	int (*queue_enable)(struct xtensa_debug_module *dm);
 	/** register read. */
 	int (*queue_reg_read)(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint8_t *data);
+	/** consecutive reads of the same register, optional, only faster than
+	 * queue_reg_read over APB. */
+	int (*queue_reg_read_stream)(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint8_t *data,
+		uint32_t count);
 	/** register write. */
 	int (*queue_reg_write)(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint32_t data);
 };
@@ -503,6 +507,8 @@ struct xtensa_debug_module {
 	struct xtensa_core_status core_status;
 	xtensa_ocdid_t device_id;
 	uint32_t ap_offset;
+	/* NARSEL may be out of NAR/NDR phase, select it again by an IR scan */
+	bool narsel_resync;
 };
 
 int xtensa_dm_init(struct xtensa_debug_module *dm, const struct xtensa_debug_module_config *cfg);
@@ -511,6 +517,8 @@ int xtensa_dm_poll(struct xtensa_debug_module *dm);
 int xtensa_dm_examine(struct xtensa_debug_module *dm);
 int xtensa_dm_queue_enable(struct xtensa_debug_module *dm);
 int xtensa_dm_queue_reg_read(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint8_t *value);
+int xtensa_dm_queue_reg_read_stream(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint8_t *value,
+	uint32_t count);
 int xtensa_dm_queue_reg_write(struct xtensa_debug_module *dm, enum xtensa_dm_reg reg, uint32_t value);
 int xtensa_dm_queue_pwr_reg_read(struct xtensa_debug_module *dm,
 	enum xtensa_dm_pwr_reg reg,
@@ -522,7 +530,13 @@ int xtensa_dm_queue_pwr_reg_write(struct xtensa_debug_module *dm,
 
 static inline int xtensa_dm_queue_execute(struct xtensa_debug_module *dm)
 {
-	return dm->dap ? dap_run(dm->dap) : jtag_execute_queue();
+	if (dm->dap)
+		return dap_run(dm->dap);
+	int res = jtag_execute_queue();
+	/* A failed or aborted queue can stop between a NAR and its NDR scan */
+	if (res != ERROR_OK)
+		dm->narsel_resync = true;
+	return res;
 }
 
 static inline void xtensa_dm_queue_tdi_idle(struct xtensa_debug_module *dm)
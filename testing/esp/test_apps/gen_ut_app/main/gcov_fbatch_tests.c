@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "gen_ut_app.h"
+
+#if CONFIG_ESP32_GCOV_ENABLE || CONFIG_ESP_GCOV_ENABLE
+#include "esp_idf_version.h"
+#include "esp_app_trace.h"
+#include "esp_log.h"
+const static char *TAG = "gcov_fbatch_test";
+
+/* host file commands, see esp32_apptrace.c in OpenOCD */
+#define FBATCH_CMD_FOPEN        0x0
+#define FBATCH_CMD_FCLOSE       0x1
+#define FBATCH_CMD_FWRITE       0x2
+#define FBATCH_CMD_FREAD        0x3
+#define FBATCH_CMD_STOP         0x6
+#define FBATCH_CMD_BATCH        0x8
+
+#define FBATCH_TMO              (5 * 1000 * 1000)
+
+#ifndef GCOV_FBATCH_TEST_DIR
+#define GCOV_FBATCH_TEST_DIR    "."
+#endif
+
+/* checked by the test script, 0 means success, otherwise the number of the failed step */
+volatile int gcov_fbatch_test_result = -1;
+
+static const char *s_fbatch_paths[] = {
+    GCOV_FBATCH_TEST_DIR "/fbatch_a.txt",
+    GCOV_FBATCH_TEST_DIR "/fbatch_b.txt",
+};
+static const char *s_fbatch_data[] = {
+    "FBATCH test file A",
+    "FBATCH test file B",
+};
+static uint8_t s_fbatch_down_buf[256];
+
+static inline uint8_t *fbatch_buffer_get(uint32_t size)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
+    return esp_apptrace_buffer_get(size, FBATCH_TMO);
+#else
+    return esp_apptrace_buffer_get(ESP_APPTRACE_DEST_JTAG, size, FBATCH_TMO);
+#endif
+}
+
+static inline esp_err_t fbatch_buffer_put(uint8_t *ptr)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
+    return esp_apptrace_buffer_put(ptr, FBATCH_TMO);
+#else
+    return esp_apptrace_buffer_put(ESP_APPTRACE_DEST_JTAG, ptr, FBATCH_TMO);
+#endif
+}
+
+static inline esp_err_t fbatch_flush(void)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
+    return esp_apptrace_flush(FBATCH_TMO);
+#else
+    return esp_apptrace_flush(ESP_APPTRACE_DEST_JTAG, FBATCH_TMO);
+#endif
+}
+
+static inline esp_err_t fbatch_read(void *data, uint32_t *size)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
+    return esp_apptrace_read(data, size, FBATCH_TMO);
+#else
+    return esp_apptrace_read(ESP_APPTRACE_DEST_JTAG, data, size, FBATCH_TMO);
+#endif
+}
+
+static inline bool fbatch_host_is_connected(void)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
+    return esp_apptrace_host_is_connected();
+#else
+    return esp_apptrace_host_is_connected(ESP_APPTRACE_DEST_JTAG);
+#endif
+}
+
+/* Appends [cmd][u16 args len][fd (if not 0)][args] to the batch */
+static size_t fbatch_add(uint8_t *buf, size_t len, uint8_t cmd, uint32_t fd, const void *args, size_t args_len)
+{
+    size_t fd_len = fd ? sizeof(fd) : 0;
+
+    buf[len] = cmd;
+    buf[len + 1] = (fd_len + args_len) & 0xFF;
+    buf[len + 2] = (fd_len + args_len) >> 8;
+    memcpy(buf + len + 3, &fd, fd_len);
+    memcpy(buf + len + 3 + fd_len, args, args_len);
+    return len + 3 + fd_len + args_len;
+}
+
+static size_t fbatch_add_fopen(uint8_t *buf, size_t len, const char *path, const char *mode)
+{
+    uint8_t args[256];
+    size_t path_len = strlen(path) + 1;
+    size_t mode_len = strlen(mode) + 1;
+
+    memcpy(args, path, path_len);
+    memcpy(args + path_len, mode, mode_len);
+    return fbatch_add(buf, len, FBATCH_CMD_FOPEN, 0, args, path_len + mode_len);
+}
+
+/* Sends the batch and receives the responses, [u16 len][data] each */
+static int fbatch_send(const uint8_t *cmds, size_t len, uint8_t *resp, uint32_t *resp_len)
+{
+    uint8_t *ptr = fbatch_buffer_get(len + 1);
+    if (!ptr) {
+        return -1;
+    }
+    ptr[0] = FBATCH_CMD_BATCH;
+    memcpy(ptr + 1, cmds, len);
+    if (fbatch_buffer_put(ptr) != ESP_OK || fbatch_flush() != ESP_OK) {
+        return -1;
+    }
+    return fbatch_read(resp, resp_len) == ESP_OK ? 0 : -1;
+}
+
+/* @return data of the next response record and its length in 'len', NULL if there is none */
+static const uint8_t *fbatch_resp_next(const uint8_t **resp, const uint8_t *end, uint16_t *len)
+{
+    if (end - *resp < 2) {
+        return NULL;
+    }
+    *len = (*resp)[0] | ((*resp)[1] << 8);
+    const uint8_t *data = *resp + 2;
+    if (end - data < *len) {
+        return NULL;
+    }
+    *resp = data + *len;
+    return data;
+}
+
+static bool fbatch_resp_u32(const uint8_t **resp, const uint8_t *end, uint32_t *val)
+{
+    uint16_t len;
+    const uint8_t *data = fbatch_resp_next(resp, end, &len);
+    if (!data || len != sizeof(*val)) {
+        return false;
+    }
+    memcpy(val, data, sizeof(*val));
+    return true;
+}
+
+/* @return 0 on success, otherwise the number of the failed step */
+static int fbatch_test_run(void)
+{
+    uint8_t cmds[640];
+    uint8_t resp[sizeof(s_fbatch_down_buf)];
+    uint32_t resp_len, fd[2], val;
+    const uint8_t *p, *end;
+    size_t len;
+
+    /* 1: open both files for writing */
+    len = 0;
+    for (int i = 0; i < 2; i++) {
+        len = fbatch_add_fopen(cmds, len, s_fbatch_paths[i], "w");
+    }
+    resp_len = sizeof(resp);
+    if (fbatch_send(cmds, len, resp, &resp_len) != 0) {
+        return 1;
+    }
+    p = resp;
+    end = resp + resp_len;
+    for (int i = 0; i < 2; i++) {
+        if (!fbatch_resp_u32(&p, end, &fd[i]) || fd[i] == 0) {
+            return 1;
+        }
+    }
+
+    /* 2: write and close them */
+    len = 0;
+    for (int i = 0; i < 2; i++) {
+        len = fbatch_add(cmds, len, FBATCH_CMD_FWRITE, fd[i], s_fbatch_data[i], strlen(s_fbatch_data[i]));
+    }
+    for (int i = 0; i < 2; i++) {
+        len = fbatch_add(cmds, len, FBATCH_CMD_FCLOSE, fd[i], NULL, 0);
+    }
+    resp_len = sizeof(resp);
+    if (fbatch_send(cmds, len, resp, &resp_len) != 0) {
+        return 2;
+    }
+    p = resp;
+    end = resp + resp_len;
+    for (int i = 0; i < 4; i++) {
+        /* fwrite() writes one item, fclose() returns 0 */
+        if (!fbatch_resp_u32(&p, end, &val) || val != (i < 2 ? 1 : 0)) {
+            return 2;
+        }
+    }
+
+    /* 3: reopen the first one for reading */
+    len = fbatch_add_fopen(cmds, 0, s_fbatch_paths[0], "r");
+    resp_len = sizeof(resp);
+    if (fbatch_send(cmds, len, resp, &resp_len) != 0) {
+        return 3;
+    }
+    p = resp;
+    end = resp + resp_len;
+    if (!fbatch_resp_u32(&p, end, &fd[0]) || fd[0] == 0) {
+        return 3;
+    }
+
+    /* 4: read it back, close it and stop, the last command has no response data */
+    uint32_t rd_len = 64;
+    len = fbatch_add(cmds, 0, FBATCH_CMD_FREAD, fd[0], &rd_len, sizeof(rd_len));
+    len = fbatch_add(cmds, len, FBATCH_CMD_FCLOSE, fd[0], NULL, 0);
+    len = fbatch_add(cmds, len, FBATCH_CMD_STOP, 0, NULL, 0);
+    resp_len = sizeof(resp);
+    if (fbatch_send(cmds, len, resp, &resp_len) != 0) {
+        return 4;
+    }
+    p = resp;
+    end = resp + resp_len;
+    uint16_t rec_len;
+    const uint8_t *data = fbatch_resp_next(&p, end, &rec_len);
+    size_t data_len = strlen(s_fbatch_data[0]);
+    if (!data || rec_len != sizeof(val) + data_len) {
+        return 4;
+    }
+    memcpy(&val, data, sizeof(val));
+    if (val != data_len || memcmp(data + sizeof(val), s_fbatch_data[0], data_len) != 0) {
+        return 4;
+    }
+    if (!fbatch_resp_u32(&p, end, &val) || val != 0) {
+        return 4;
+    }
+    if (!fbatch_resp_next(&p, end, &rec_len) || rec_len != 0 || p != end) {
+        return 4;
+    }
+    return 0;
+}
+
+static void gcov_fbatch_task(void *pvParameter)
+{
+    esp_apptrace_down_buffer_config(s_fbatch_down_buf, sizeof(s_fbatch_down_buf));
+    while (!fbatch_host_is_connected()) {
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+    int res = fbatch_test_run();
+    if (res != 0) {
+        uint8_t stop = FBATCH_CMD_STOP;
+        uint8_t *ptr = fbatch_buffer_get(sizeof(stop));
+        ESP_LOGE(TAG, "FBATCH test failed at step %d", res);
+        /* let the host finish */
+        if (ptr) {
+            *ptr = stop;
+            fbatch_buffer_put(ptr);
+            fbatch_flush();
+        }
+    }
+    gcov_fbatch_test_result = res;
+    while (1) {
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+    }
+}
+#endif //CONFIG_ESP32_GCOV_ENABLE || CONFIG_ESP_GCOV_ENABLE
+
+ut_result_t gcov_fbatch_test_do(int test_num, int core_num)
+{
+    if (core_num < 0 || core_num >= portNUM_PROCESSORS)
+        core_num = portNUM_PROCESSORS-1;
+#if CONFIG_ESP32_GCOV_ENABLE || CONFIG_ESP_GCOV_ENABLE
+    if (TEST_ID_MATCH("test_gcov.GcovTests*.test_fbatch*", test_num)) {
+        xTaskCreatePinnedToCore(&gcov_fbatch_task, "gcov_fbatch_task", 4096, NULL, 5, NULL, core_num);
+        return UT_OK;
+    }
+#endif //CONFIG_ESP32_GCOV_ENABLE || CONFIG_ESP_GCOV_ENABLE
+    return UT_UNSUPPORTED;
+}
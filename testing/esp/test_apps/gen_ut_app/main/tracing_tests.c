@@ -250,7 +250,7 @@ static void os_trace_test_task(void *pvParameter)
     }
 }
 
-TEST_DECL(os_tracing, "test_sysview.SysView*TracingTests*.test_os_tracing")
+TEST_DECL(os_tracing, "test_sysview.SysView*TracingTests*.test_os_tracing*")
 {
     static struct os_trace_task_arg task_args[2] = {
         { .tim_grp = TEST_TIMER_GROUP_0, .tim_id = TEST_TIMER_0, .tim_period = 300000UL /*us*/, .task_period = 500 /*ms*/},
@@ -345,6 +345,26 @@ class GcovTestsImpl:
         data_path = os.path.join(self.test_app_cfg.build_obj_dir(), 'esp-idf', 'main', 'CMakeFiles', MAIN_COMP_BUILD_DIR_NAME, 'helper_funcs.c.gcda')
         self.assertTrue(os.path.exists(os.path.join(self.gcov_prefix, self.strip_gcov_path(data_path))))
 
+    def test_fbatch_oocd(self):
+        """
+            This test checks that file commands packed by target in one block (FBATCH) are handled.
+            1) Select appropriate sub-test number on target.
+            2) Resume target, test task waits for host connection.
+            3) Run 'esp gcov dump'. Test task opens, writes, reads back and closes two files using batches
+               and checks the responses.
+            4) Check test task result and contents of the files on host.
+        """
+        self.resume_exec()
+        time.sleep(1)
+        self.oocd.gcov_dump(False)
+        self.stop_exec()
+        self.assertEqual(int(self.gdb.data_eval_expr('gcov_fbatch_test_result'), 0), 0)
+        data_dir = os.path.join(self.test_app_cfg.build_obj_dir(), 'esp-idf', 'main', 'CMakeFiles', MAIN_COMP_BUILD_DIR_NAME)
+        for name,data in (('fbatch_a.txt', 'FBATCH test file A'), ('fbatch_b.txt', 'FBATCH test file B')):
+            path = os.path.join(self.gcov_prefix, self.strip_gcov_path(os.path.join(data_dir, name)))
+            with open(path) as f:
+                self.assertEqual(f.read(), data)
+
 ########################################################################
 #              TESTS DEFINITION WITH SPECIAL TESTS                     #
 ########################################################################
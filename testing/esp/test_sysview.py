@@ -7,6 +7,7 @@ import os.path
 import re
 import time
 import tempfile
+import json
 import sys
 import traceback
 
@@ -386,6 +387,94 @@ class SysViewTracingTestsImpl(BaseTracingTestsImpl):
                 freq_dev = 100*(irq_ref_data[name]['freq'] - irq_run_data[name]['run_count']/iv)/irq_ref_data[name]['freq']
                 self.assertTrue(freq_dev <= 10) # max event's freq deviation (due to measurement error) is 10%
 
+    def _export_store(self, store_path, start_us=None, end_us=None):
+        fhnd,json_path = tempfile.mkstemp(suffix='.json')
+        os.close(fhnd)
+        json_path = json_path.replace("\\","/")
+        cmd = 'esp sysview_export %s %s' % (store_path, json_path)
+        if start_us is not None:
+            cmd += ' %d %d' % (start_us, end_us)
+        out = self.oocd.cmd_exec(cmd)
+        self.assertTrue(re.search(r'Exported [0-9]+ events', out), out)
+        with open(json_path) as f:
+            trace = json.load(f)
+        os.remove(json_path)
+        return trace['traceEvents']
+
+    def test_os_tracing_store(self):
+        """
+            This test checks that SystemView events stored while tracing can be exported to Perfetto JSON.
+            1) Select appropriate sub-test number on target.
+            2) Resume target and wait some time to allow test tasks and timers to start working.
+            3) Enable events store and start collecting SystemView trace data.
+            4) Wait some time, stop collecting trace data and disable events store.
+            5) Export all stored events and check that task runs and ISRs match the ones in the trace files.
+            6) Export the middle of the trace and check that only events from that time range are exported.
+        """
+        fhnd,store_path = tempfile.mkstemp()
+        os.close(fhnd)
+        store_path = store_path.replace("\\","/")
+        self.resume_exec()
+        time.sleep(3.0)
+        self.oocd.cmd_exec('esp sysview_store %s' % store_path)
+        if self.cores_num > 1:
+            self.oocd.sysview_start(self.trace_ctrl[0]['src'], self.trace_ctrl[1]['src'])
+        else:
+            self.oocd.sysview_start(self.trace_ctrl[0]['src'])
+        time.sleep(5.0)
+        self.oocd.sysview_stop()
+        self.oocd.cmd_exec('esp sysview_store off')
+
+        self._create_processor(keep_all_events=True)
+        try:
+            self._process_trace()
+        except (apptrace.ReaderTimeoutError) as e:
+            get_logger().info("Stop processing trace. (%s)" % e)
+        except Exception as e:
+            traceback.print_exc()
+            self.fail("Failed to parse trace (%s)!" % e)
+
+        # reference counts from SystemView trace files
+        ref_runs = {}
+        ref_isrs = {}
+        tasks_info = self.trace_ctrl[0]['parser'].tasks_info
+        for evt in self.processor.events:
+            if evt.id == sysview.SYSVIEW_EVTID_TASK_START_EXEC:
+                name = tasks_info.get(evt.params['tid'].value)
+                if name:
+                    ref_runs[name] = ref_runs.get(name, 0) + 1
+            elif evt.id == sysview.SYSVIEW_EVTID_ISR_ENTER:
+                name = 'isr %d' % evt.params['irq_num'].value
+                ref_isrs[name] = ref_isrs.get(name, 0) + 1
+
+        events = self._export_store(store_path)
+        runs = {}
+        isrs = {}
+        for evt in events:
+            if evt['ph'] != 'B':
+                continue
+            if evt['name'].startswith('isr '):
+                isrs[evt['name']] = isrs.get(evt['name'], 0) + 1
+            else:
+                runs[evt['name']] = runs.get(evt['name'], 0) + 1
+        for name in ['trace_task0', 'trace_task1'][:self.test_tasks_num]:
+            self.assertNotEqual(ref_runs.get(name, 0), 0)
+            self.assertEqual(runs.get(name, 0), ref_runs[name])
+        self.assertNotEqual(len(ref_isrs), 0)
+        self.assertEqual(isrs, ref_isrs)
+
+        # export the middle of the trace
+        ts = [evt['ts'] for evt in events if 'ts' in evt]
+        start_us = int(min(ts) + (max(ts) - min(ts)) / 3)
+        end_us = int(min(ts) + 2 * (max(ts) - min(ts)) / 3)
+        events = self._export_store(store_path, start_us, end_us)
+        ts = [evt['ts'] for evt in events if 'ts' in evt]
+        self.assertNotEqual(len(ts), 0)
+        # timestamps are rounded to ticks of the trace clock
+        for t in ts:
+            self.assertTrue(start_us - 1 <= t <= end_us + 1)
+        os.remove(store_path)
+
 class SysViewMcoreTracingTestsImpl(BaseTracingTestsImpl):
     """ Test cases which are common for dual and single core modes
     """